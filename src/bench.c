@@ -0,0 +1,356 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "ic_levin.h"
+#include "ic_netfile.h"
+#include "ic_parallel.h"
+#include "ic_runtime.h"
+#include "ic_search.h"
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+/**
+ * Fixed workload sizes; every run of the same build measures the same work
+ */
+typedef struct {
+    size_t max_nodes;
+    size_t gas_limit;
+    size_t build_indices;    // Indices built by the build-only workload
+    size_t reduce_nets;      // Pre-built nets reduced by the reduce-only workload
+    uint64_t search_limit;   // Index limit of each full search
+} bench_config_t;
+
+static const bench_config_t bench_default = { 100, 10000, 1000000, 2000, 200000 };
+static const bench_config_t bench_quick = { 100, 10000, 100000, 200, 20000 };
+
+// Numbers factored by the search workload (12 has no solution, so it
+// always searches the whole limit)
+static const int bench_targets[] = { 6, 8, 12 };
+
+static double bench_now(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec / 1000000000.0;
+}
+
+static double bench_rate(double amount, double seconds) {
+    return (seconds > 0.0) ? amount / seconds : 0.0;
+}
+
+/**
+ * Build-only: rebuild one net for consecutive indices, no reduction
+ * With `stream`, each net is patched from an ic_enum_cursor_t instead.
+ */
+static int bench_build(const bench_config_t *config, bool stream, bool first) {
+    ic_net_t *net = ic_net_create(config->max_nodes, config->gas_limit);
+    if (!net) return -1;
+    
+    ic_enum_cursor_t cursor;
+    ic_enum_cursor_init(&cursor);
+    size_t allocs = ic_net_alloc_count();
+    size_t nodes = 0;
+    double start = bench_now();
+    for (size_t index = 0; index < config->build_indices; index++) {
+        if (stream) {
+            ic_enum_cursor_build(&cursor, index, net);
+        } else {
+            ic_enum_build_net_compatible(NULL, index, net);
+        }
+        nodes += net->used_nodes;
+    }
+    double seconds = bench_now() - start;
+    allocs = ic_net_alloc_count() - allocs;
+    ic_net_free(net);
+    
+    printf("%s    {\"workload\": \"%s\", \"indices\": %zu, \"nodes\": %zu, \"seconds\": %.6f, "
+           "\"nets_per_sec\": %.1f, \"allocs_per_index\": %.4f}",
+           first ? "" : ",\n", stream ? "build_stream" : "build", config->build_indices, nodes, seconds,
+           bench_rate(config->build_indices, seconds),
+           (double)allocs / config->build_indices);
+    return 0;
+}
+
+/**
+ * Reduce-only: build nets for the first indices up front, then time only
+ * their reduction
+ */
+static int bench_reduce(const bench_config_t *config, bool first) {
+    size_t count = config->reduce_nets;
+    ic_net_t **nets = (ic_net_t**)calloc(count, sizeof(ic_net_t*));
+    if (!nets) return -1;
+    
+    int status = 0;
+    for (size_t i = 0; i < count && status == 0; i++) {
+        nets[i] = ic_net_create(config->max_nodes, config->gas_limit);
+        if (!nets[i] || ic_enum_build_net_compatible(NULL, i, nets[i]) != 0) status = -1;
+    }
+    
+    if (status == 0) {
+        size_t allocs = ic_net_alloc_count();
+        uint64_t rewrites = 0;
+        double start = bench_now();
+        for (size_t i = 0; i < count; i++) {
+            ic_net_reduce(nets[i]);
+            rewrites += nets[i]->gas_used;
+        }
+        double seconds = bench_now() - start;
+        allocs = ic_net_alloc_count() - allocs;
+        
+        printf("%s    {\"workload\": \"reduce\", \"nets\": %zu, \"rewrites\": %" PRIu64 ", "
+               "\"seconds\": %.6f, \"nets_per_sec\": %.1f, \"rewrites_per_sec\": %.1f, "
+               "\"ns_per_rewrite\": %.2f, \"allocs_per_index\": %.4f}",
+               first ? "" : ",\n", count, rewrites, seconds, bench_rate(count, seconds),
+               bench_rate(rewrites, seconds), rewrites ? seconds * 1e9 / rewrites : 0.0,
+               (double)allocs / count);
+    }
+    
+    for (size_t i = 0; i < count; i++) {
+        ic_net_free(nets[i]);
+    }
+    free(nets);
+    return status;
+}
+
+/**
+ * Single large net: the nets of bench_reduce side by side in one net,
+ * reduced by ic_net_reduce (threads = 0) or ic_net_reduce_parallel
+ */
+static int bench_reduce_union(const bench_config_t *config, int threads) {
+    size_t count = config->reduce_nets;
+    ic_net_t *net = ic_net_create(count * config->max_nodes, count * config->gas_limit);
+    ic_net_t *part = ic_net_create(config->max_nodes, config->gas_limit);
+    int status = (net && part) ? 0 : -1;
+    
+    // Copy each net's wiring, offset by the slots before it
+    for (size_t i = 0; i < count && status == 0; i++) {
+        if (ic_enum_build_net_compatible(NULL, i, part) != 0) {
+            status = -1;
+            break;
+        }
+        size_t offset = net->used_nodes;
+        for (size_t n = 0; n < part->used_nodes; n++) {
+            ic_net_new_node(net, ic_net_node_type(part, n));
+        }
+        for (size_t w = 0; w < 3 * part->used_nodes; w++) {
+            ic_wire_t wire = part->wires[w];
+            net->wires[3 * offset + w] = (wire == IC_WIRE_NONE) ? IC_WIRE_NONE :
+                IC_WIRE(IC_WIRE_NODE(wire) + offset, IC_WIRE_PORT(wire));
+        }
+    }
+    
+    if (status == 0) {
+        size_t nodes = net->used_nodes;
+        double start = bench_now();
+        int result = (threads > 0) ? ic_net_reduce_parallel(net, threads) : ic_net_reduce(net);
+        double seconds = bench_now() - start;
+        status = (result < 0) ? -1 : 0;
+        
+        printf(",\n    {\"workload\": \"reduce_union\", \"nodes\": %zu, \"threads\": %d, "
+               "\"rewrites\": %zu, \"seconds\": %.6f, \"rewrites_per_sec\": %.1f, "
+               "\"ns_per_rewrite\": %.2f}",
+               nodes, threads, net->gas_used, seconds, bench_rate(net->gas_used, seconds),
+               net->gas_used ? seconds * 1e9 / net->gas_used : 0.0);
+        fflush(stdout);
+    }
+    
+    ic_net_free(part);
+    ic_net_free(net);
+    return status;
+}
+
+// Times the netfile workload writes each reduced net
+#define BENCH_NETFILE_PASSES 50
+
+/**
+ * Serialization: write the reduced nets of bench_reduce to a temporary
+ * file as ic_net_write records, BENCH_NETFILE_PASSES times over, then read
+ * them all back into one net with ic_net_read
+ */
+static int bench_netfile(const bench_config_t *config) {
+    size_t count = config->reduce_nets;
+    ic_net_t **nets = (ic_net_t**)calloc(count, sizeof(ic_net_t*));
+    ic_net_t *copy = ic_net_create(config->max_nodes, config->gas_limit);
+    FILE *file = tmpfile();
+    int status = (nets && copy && file) ? 0 : -1;
+    
+    int *results = (int*)calloc(count, sizeof(int));
+    if (!results) status = -1;
+    for (size_t i = 0; i < count && status == 0; i++) {
+        nets[i] = ic_net_create(config->max_nodes, config->gas_limit);
+        if (!nets[i] || ic_enum_build_net_compatible(NULL, i, nets[i]) != 0) {
+            status = -1;
+            break;
+        }
+        results[i] = ic_net_reduce(nets[i]);
+    }
+    
+    if (status == 0) {
+        size_t records = count * BENCH_NETFILE_PASSES;
+        double start = bench_now();
+        for (size_t pass = 0; pass < BENCH_NETFILE_PASSES && status == 0; pass++) {
+            for (size_t i = 0; i < count; i++) {
+                if (ic_net_write(file, nets[i], i, results[i]) != 0) status = -1;
+            }
+        }
+        if (fflush(file) != 0) status = -1;
+        double write_seconds = bench_now() - start;
+        long bytes = ftell(file);
+        
+        rewind(file);
+        size_t read = 0, nodes = 0;
+        start = bench_now();
+        while (ic_net_read(file, copy, NULL) == 1) {
+            nodes += copy->used_nodes;
+            read++;
+        }
+        double read_seconds = bench_now() - start;
+        if (read != records) status = -1;
+        
+        printf(",\n    {\"workload\": \"netfile\", \"nets\": %zu, \"nodes\": %zu, "
+               "\"bytes_per_net\": %.1f, \"write_seconds\": %.6f, \"read_seconds\": %.6f, "
+               "\"written_per_sec\": %.1f, \"read_per_sec\": %.1f}",
+               records, nodes, (double)bytes / records, write_seconds, read_seconds,
+               bench_rate(records, write_seconds), bench_rate(read, read_seconds));
+        fflush(stdout);
+    }
+    
+    if (file) fclose(file);
+    for (size_t i = 0; nets && i < count; i++) {
+        ic_net_free(nets[i]);
+    }
+    free(results);
+    free(nets);
+    ic_net_free(copy);
+    return status;
+}
+
+/**
+ * Full search: ic_search_factor for one number at one thread count
+ */
+static void bench_search(const bench_config_t *config, int N, int threads) {
+#ifdef _OPENMP
+    omp_set_num_threads(threads);
+#endif
+    
+    ic_enum_state_t state;
+    ic_enum_init(&state, config->max_nodes);
+    ic_enum_set_search_limit(&state, config->search_limit);
+    
+    double start = bench_now();
+    int64_t solution = ic_search_factor(&state, N, config->max_nodes, config->gas_limit);
+    double seconds = bench_now() - start;
+    
+    size_t indices = state.indices_searched;
+    printf(",\n    {\"workload\": \"search\", \"N\": %d, \"threads\": %d, \"solution\": %" PRId64 ", "
+           "\"indices\": %zu, \"deduplicated\": %zu, \"rewrites\": %" PRIu64 ", \"seconds\": %.6f, "
+           "\"nets_per_sec\": %.1f, \"rewrites_per_sec\": %.1f, \"ns_per_rewrite\": %.2f, "
+           "\"allocs_per_index\": %.4f}",
+           N, threads, solution, indices, state.indices_deduplicated, state.rewrites, seconds,
+           bench_rate(indices, seconds), bench_rate(state.rewrites, seconds),
+           state.rewrites ? seconds * 1e9 / state.rewrites : 0.0,
+           indices ? (double)state.loop_allocations / indices : 0.0);
+    fflush(stdout);
+}
+
+/**
+ * Levin search: ic_search_levin for one number at one thread count, over
+ * the same range and gas limit as the full search
+ */
+static void bench_levin(const bench_config_t *config, int N, int threads) {
+    ic_enum_state_t state;
+    ic_enum_init(&state, config->max_nodes);
+    ic_enum_set_search_limit(&state, config->search_limit);
+    ic_enum_set_threads(&state, threads);
+    
+    ic_levin_result_t levin;
+    double start = bench_now();
+    int64_t solution = ic_search_levin(&state, N, config->max_nodes, config->gas_limit, &levin);
+    double seconds = bench_now() - start;
+    
+    printf(",\n    {\"workload\": \"levin\", \"N\": %d, \"threads\": %d, \"solution\": %" PRId64 ", "
+           "\"phase\": %u, \"phases\": %u, \"candidates\": %" PRIu64 ", \"rewrites\": %" PRIu64 ", "
+           "\"resumptions\": %" PRIu64 ", \"peak_suspended\": %zu, \"seconds\": %.6f, "
+           "\"rewrites_per_sec\": %.1f}",
+           N, threads, solution, levin.phase, levin.phases, levin.candidates, levin.rewrites,
+           levin.resumptions, levin.peak_suspended, seconds, bench_rate(levin.rewrites, seconds));
+    fflush(stdout);
+}
+
+int main(int argc, char **argv) {
+    const bench_config_t *config = &bench_default;
+    if (argc > 1 && strcmp(argv[1], "--quick") == 0) {
+        config = &bench_quick;
+    } else if (argc > 1) {
+        fprintf(stderr, "Usage: %s [--quick]\n", argv[0]);
+        return 1;
+    }
+    
+#ifdef _OPENMP
+    int available = omp_get_num_procs();
+#else
+    int available = 1;
+#endif
+    
+    // 1, 2, 4 and all processors, without repeats
+    int thread_counts[4];
+    size_t thread_runs = 0;
+    const int wanted[] = { 1, 2, 4, available };
+    for (size_t i = 0; i < sizeof(wanted) / sizeof(wanted[0]); i++) {
+        bool repeat = false;
+        for (size_t j = 0; j < thread_runs; j++) {
+            repeat = repeat || thread_counts[j] == wanted[i];
+        }
+#ifndef _OPENMP
+        repeat = repeat || wanted[i] != 1;
+#endif
+        if (!repeat) thread_counts[thread_runs++] = wanted[i];
+    }
+    
+    printf("{\n  \"benchmark\": \"icsearch\",\n");
+    printf("  \"config\": {\"max_nodes\": %zu, \"gas_limit\": %zu, \"build_indices\": %zu, "
+           "\"reduce_nets\": %zu, \"search_limit\": %" PRIu64 ", \"processors\": %d},\n",
+           config->max_nodes, config->gas_limit, config->build_indices, config->reduce_nets,
+           config->search_limit, available);
+    printf("  \"results\": [\n");
+    
+    if (bench_build(config, false, true) != 0 || bench_build(config, true, false) != 0 ||
+        bench_reduce(config, false) != 0) {
+        fprintf(stderr, "Failed to allocate benchmark nets\n");
+        return 1;
+    }
+    
+    // threads = 0 is the sequential reference
+    for (size_t r = 0; r <= thread_runs; r++) {
+        if (bench_reduce_union(config, (r == 0) ? 0 : thread_counts[r - 1]) != 0) {
+            fprintf(stderr, "Failed to allocate benchmark nets\n");
+            return 1;
+        }
+    }
+    
+    if (bench_netfile(config) != 0) {
+        fprintf(stderr, "Failed to write or read back benchmark nets\n");
+        return 1;
+    }
+    
+    for (size_t t = 0; t < sizeof(bench_targets) / sizeof(bench_targets[0]); t++) {
+        for (size_t r = 0; r < thread_runs; r++) {
+            bench_search(config, bench_targets[t], thread_counts[r]);
+        }
+    }
+    
+    for (size_t t = 0; t < sizeof(bench_targets) / sizeof(bench_targets[0]); t++) {
+        for (size_t r = 0; r < thread_runs; r++) {
+            bench_levin(config, bench_targets[t], thread_counts[r]);
+        }
+    }
+    
+    printf("\n  ]\n}\n");
+    return 0;
+}
@@ -0,0 +1,202 @@
+#include "ic_enum.h"
+#include "ic_search.h"
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * Type of node n of a net built from `pattern`: two pattern bits per node
+ */
+static inline ic_node_type_t ic_enum_node_type(uint64_t pattern, size_t n) {
+    unsigned int bit = (pattern >> (n % 16)) & 0x3; // Use 2 bits
+
+    if (bit == 0) return IC_NODE_DELTA;
+    if (bit == 1) return IC_NODE_GAMMA;
+    return IC_NODE_EPSILON;
+}
+
+int ic_enum_build_index(uint64_t index, ic_net_t *net) {
+    if (!net) return -1;
+
+    // Fast reset - reuses the node storage without zeroing it
+    ic_net_reset(net);
+
+    // Small nets are faster to evaluate and more likely to have useful
+    // computational behavior
+    size_t num_nodes = ic_enum_net_size(index);
+
+    // Extract some randomization bits from the index
+    uint64_t pattern = index / IC_ENUM_SIZE_CLASSES;
+
+    // Directly create a delta-gamma active pair for factorization
+    int delta_node = ic_net_new_node(net, IC_NODE_DELTA);
+    int gamma_node = ic_net_new_node(net, IC_NODE_GAMMA);
+
+    if (delta_node < 0 || gamma_node < 0) {
+        return -1; // Out of space
+    }
+
+    // Connect principal ports to create active pair - guarantees computation
+    ic_net_connect(net, delta_node, 0, gamma_node, 0);
+
+    // Generate the rest of the nodes with fast pattern-based distribution
+    for (size_t n = 2; n < num_nodes; n++) {
+        if (ic_net_new_node(net, ic_enum_node_type(pattern, n)) < 0) {
+            return -1; // Out of space
+        }
+    }
+
+    // Fast bit-pattern based connection scheme
+    // Form a cycle to ensure all ports are connected
+    for (size_t i = 0; i < net->used_nodes; i++) {
+        // Connect auxiliary ports to next/prev nodes to form a ring
+        size_t next = (i + 1) % net->used_nodes;
+        size_t prev = (i + net->used_nodes - 1) % net->used_nodes;
+
+        // Skip principal ports that are already connected in active pair
+        if (i == 0 || i == 1) {
+            // Connect auxiliary ports only
+            ic_net_connect(net, i, 1, next, 2);
+            ic_net_connect(net, i, 2, prev, 1);
+        } else {
+            // For other nodes, connect all ports
+            ic_net_connect(net, i, 0, (i + 2) % net->used_nodes, 0);
+            ic_net_connect(net, i, 1, next, 2);
+            ic_net_connect(net, i, 2, prev, 1);
+        }
+    }
+
+    // We know all ports are connected and we have an active pair
+    return 0;
+}
+
+int ic_enum_build_net(ic_enum_state_t *state, size_t index, ic_net_t *net) {
+    if (!state) return -1;
+    return ic_enum_build_index(index, net);
+}
+
+int ic_enum_build_net_compatible(ic_enum_state_t *state, size_t index, ic_net_t *net) {
+    (void)state;
+    return ic_enum_build_index(index, net);
+}
+
+int ic_enum_next(ic_enum_state_t *state, ic_net_t *net) {
+    if (!state || !net) return 0;
+
+    // Every build succeeds until the nets outgrow max_nodes
+    int result = ic_enum_cursor_build(&state->cursor, state->current_index, net);
+    state->current_index++;
+    return (result == 0) ? 1 : 0;
+}
+
+void ic_enum_cursor_init(ic_enum_cursor_t *cursor) {
+    if (!cursor) return;
+    for (size_t c = 0; c < IC_ENUM_SIZE_CLASSES; c++) {
+        cursor->templates[c].built = false;
+    }
+    cursor->repeat_of = UINT64_MAX;
+}
+
+const ic_net_t *ic_enum_cursor_seek(ic_enum_cursor_t *cursor, uint64_t index) {
+    ic_enum_template_t *tmpl = &cursor->templates[index % IC_ENUM_SIZE_CLASSES];
+    uint64_t pattern = index / IC_ENUM_SIZE_CLASSES;
+    ic_net_t *net = &tmpl->net.net;
+    cursor->repeat_of = UINT64_MAX;
+
+    // First visit of the class: wire it once; 16 slots always suffice
+    if (!tmpl->built) {
+        ic_net16_init(&tmpl->net, IC_ENUM_MAX_NET_NODES, 0);
+        ic_enum_build_index(index, net);
+        tmpl->pattern = pattern;
+        tmpl->index = index;
+        tmpl->built = true;
+        return net;
+    }
+
+    // Retype only the nodes whose two bits flipped
+    uint64_t flipped = pattern ^ tmpl->pattern;
+    bool retyped = false;
+    for (size_t n = 2; n < net->used_nodes; n++) {
+        if (((flipped >> (n % 16)) & 0x3) == 0) continue;
+
+        uint8_t type = (uint8_t)ic_enum_node_type(pattern, n);
+        if (net->types[n] != type) {
+            net->types[n] = type;
+            retyped = true;
+        }
+    }
+
+    if (!retyped && tmpl->index < index) {
+        cursor->repeat_of = tmpl->index;
+    }
+    tmpl->pattern = pattern;
+    tmpl->index = index;
+    return net;
+}
+
+int ic_enum_cursor_copy(const ic_net_t *pristine, ic_net_t *net) {
+    if (!pristine || !net) return -1;
+
+    ic_net_reset(net);
+    size_t used = pristine->used_nodes;
+    if (used > net->max_nodes) {
+        return -1; // Out of space, as ic_net_new_node would be
+    }
+
+    memcpy(net->wires, pristine->wires, 3 * used * sizeof(ic_wire_t));
+    memcpy(net->types, pristine->types, used);
+    memcpy(net->active, pristine->active, used);
+    net->used_nodes = used;
+    net->free_head = pristine->free_head;
+
+    // The pairs the builder queued, in order; any ring holds the few of them
+    size_t queued = pristine->redex_queue_size;
+    if (queued > net->redex_queue_capacity) {
+        net->redex_rescan_needed = true;
+        return 0;
+    }
+    for (size_t i = 0; i < queued; i++) {
+        net->redex_queue[i] = pristine->redex_queue[
+            (pristine->redex_queue_start + i) & (pristine->redex_queue_capacity - 1)];
+    }
+    net->redex_queue_size = queued;
+    net->redex_rescan_needed = pristine->redex_rescan_needed;
+    return 0;
+}
+
+int ic_enum_cursor_build(ic_enum_cursor_t *cursor, uint64_t index, ic_net_t *net) {
+    if (!cursor || !net) return -1;
+    return ic_enum_cursor_copy(ic_enum_cursor_seek(cursor, index), net);
+}
+
+int ic_enum_seen_init(ic_enum_seen_t *seen) {
+    if (!seen) return -1;
+    seen->first = (_Atomic uint64_t*)malloc(IC_ENUM_LAYOUTS * sizeof(*seen->first));
+    if (!seen->first) return -1;
+
+    for (size_t i = 0; i < IC_ENUM_LAYOUTS; i++) {
+        atomic_init(&seen->first[i], UINT64_MAX);
+    }
+    atomic_init(&seen->count, 0);
+    return 0;
+}
+
+void ic_enum_seen_destroy(ic_enum_seen_t *seen) {
+    if (!seen) return;
+    free((void*)seen->first);
+    seen->first = NULL;
+}
+
+bool ic_enum_seen_claim(ic_enum_seen_t *seen, uint64_t index) {
+    _Atomic uint64_t *slot = &seen->first[ic_enum_layout_id(index)];
+
+    // Lower the slot's index to ours unless a smaller one is there
+    uint64_t current = atomic_load_explicit(slot, memory_order_relaxed);
+    while (index < current &&
+           !atomic_compare_exchange_weak_explicit(slot, &current, index,
+                                                  memory_order_relaxed, memory_order_relaxed)) {
+    }
+    if (current == UINT64_MAX) {
+        atomic_fetch_add_explicit(&seen->count, 1, memory_order_relaxed);
+    }
+    return current < index;
+}
@@ -0,0 +1,143 @@
+#ifndef IC_ENUM_H
+#define IC_ENUM_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "ic_runtime.h"
+#include "ic_fixed.h"
+
+// Net sizes of the enumeration: index i builds 3 + i % IC_ENUM_SIZE_CLASSES
+// nodes, typed from the pattern i / IC_ENUM_SIZE_CLASSES
+#define IC_ENUM_SIZE_CLASSES 10
+
+// Largest net the enumerator builds (3 + index % 10 nodes)
+#define IC_ENUM_MAX_NET_NODES 12
+
+// Most node slots a reduction of an enumerated net can occupy: no rule
+// increases the live count, and δγ takes two slots before freeing two
+#define IC_ENUM_MAX_SLOTS (IC_ENUM_MAX_NET_NODES + 2)
+
+/**
+ * Number of nodes the net of an index is built with
+ */
+static inline size_t ic_enum_net_size(uint64_t index) {
+    return 3 + (size_t)(index % IC_ENUM_SIZE_CLASSES);
+}
+
+// Bound on the distinct nets the enumeration builds: a class of n nodes
+// types nodes 2..n-1 as δ, γ or ε and wires every index alike, so it has
+// at most 3^(n-2)
+#define IC_ENUM_LAYOUTS 88572u
+
+/**
+ * Id below IC_ENUM_LAYOUTS of the net an index builds
+ * All nets of a size class share the δ–γ pair on nodes 0 and 1 and the
+ * ring wiring; only the types of nodes 2..n-1 differ. The id is that type
+ * vector read in base 3 (each digit the node's ic_node_type_t), offset by
+ * the layouts of the smaller classes, so two indices build identical nets
+ * exactly when their ids are equal. It is computed from the index alone,
+ * without building anything.
+ */
+static inline uint32_t ic_enum_layout_id(uint64_t index) {
+    size_t n = ic_enum_net_size(index);
+    uint64_t pattern = index / IC_ENUM_SIZE_CLASSES;
+
+    // Node k has type min(pattern bits k..k+1, 2), as the builder reads them
+    uint32_t code = 0, layouts = 1;
+    for (size_t k = n - 1; k >= 2; k--) {
+        unsigned bits = (unsigned)(pattern >> k) & 0x3;
+        code = code * 3 + ((bits < 2) ? bits : 2);
+        layouts *= 3;
+    }
+    return (layouts - 3) / 2 + code;
+}
+
+/**
+ * Smallest index known to build each layout, shared by any number of
+ * threads
+ * One slot per layout, so claims never probe, collide or run out of room.
+ */
+typedef struct {
+    _Atomic uint64_t *first;  // By ic_enum_layout_id, UINT64_MAX if unclaimed
+    _Atomic size_t count;     // Layouts claimed so far
+} ic_enum_seen_t;
+
+/**
+ * Create an empty table
+ * @return 0 on success, -1 on allocation failure
+ */
+int ic_enum_seen_init(ic_enum_seen_t *seen);
+
+/**
+ * Free a table
+ */
+void ic_enum_seen_destroy(ic_enum_seen_t *seen);
+
+/**
+ * Record that `index` builds its layout
+ * @return true if a smaller index has already claimed the same layout, in
+ *         which case that index's evaluation covers this one
+ */
+bool ic_enum_seen_claim(ic_enum_seen_t *seen, uint64_t index);
+
+/**
+ * Pristine, unreduced net of one size class
+ * The wiring of a size class never changes, so moving the template to
+ * another index of its class only retypes the nodes whose pattern bits
+ * differ.
+ */
+typedef struct {
+    ic_net16_t net;     // Built by the reference builder
+    uint64_t pattern;   // Pattern the node types currently encode
+    uint64_t index;     // Index the template was last moved to
+    bool built;
+} ic_enum_template_t;
+
+/**
+ * Streaming enumerator: one template per size class
+ * Walking indices in ascending order visits each class every
+ * IC_ENUM_SIZE_CLASSES indices with the pattern one higher, so a step
+ * flips the pattern bits of p ^ (p - 1), on average fewer than two, and
+ * the net is copied out of the template instead of being rewired.
+ */
+typedef struct {
+    ic_enum_template_t templates[IC_ENUM_SIZE_CLASSES];
+    uint64_t repeat_of;  // Earlier index with the same layout as the last
+                         // one built, UINT64_MAX if none is known
+} ic_enum_cursor_t;
+
+/**
+ * Build the net for an index from scratch (the reference builder)
+ * @return 0 on success, -1 if the net does not fit
+ */
+int ic_enum_build_index(uint64_t index, ic_net_t *net);
+
+/**
+ * Prepare a cursor with no templates built yet
+ */
+void ic_enum_cursor_init(ic_enum_cursor_t *cursor);
+
+/**
+ * Move the template of index's size class to index
+ * Sets cursor->repeat_of when no node type changed since the template's
+ * previous, smaller index, which then builds the identical layout.
+ * @return The template, now holding index's net
+ */
+const ic_net_t *ic_enum_cursor_seek(ic_enum_cursor_t *cursor, uint64_t index);
+
+/**
+ * Copy a template net into net, which then equals ic_enum_build_index's
+ * result, redex queue included
+ * @return 0 on success, -1 if the net does not fit
+ */
+int ic_enum_cursor_copy(const ic_net_t *pristine, ic_net_t *net);
+
+/**
+ * ic_enum_cursor_seek followed by ic_enum_cursor_copy
+ * @return 0 on success, -1 if the net does not fit
+ */
+int ic_enum_cursor_build(ic_enum_cursor_t *cursor, uint64_t index, ic_net_t *net);
+
+#endif // IC_ENUM_H
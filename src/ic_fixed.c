@@ -0,0 +1,24 @@
+#include "ic_fixed.h"
+#include "ic_trace.h"
+#include <stdio.h>
+#include <string.h>
+
+// One specialized reducer per capacity, instantiated from the template
+#define IC_FIXED_CAP 16
+#include "ic_fixed_impl.h"
+#undef IC_FIXED_CAP
+
+#define IC_FIXED_CAP 32
+#include "ic_fixed_impl.h"
+#undef IC_FIXED_CAP
+
+#define IC_FIXED_CAP 64
+#include "ic_fixed_impl.h"
+#undef IC_FIXED_CAP
+
+size_t ic_fixed_capacity(size_t slots) {
+    if (slots <= 16) return 16;
+    if (slots <= 32) return 32;
+    if (slots <= IC_FIXED_CAPACITY_MAX) return 64;
+    return 0;
+}
@@ -0,0 +1,69 @@
+#ifndef IC_FIXED_H
+#define IC_FIXED_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "ic_runtime.h"
+
+// Largest capacity with a specialized reducer
+#define IC_FIXED_CAPACITY_MAX 64
+
+// Redex ring of a fixed net with `cap` slots (power of two)
+#define IC_FIXED_QUEUE(cap) (4 * (cap))
+
+/**
+ * Net with inline storage for `cap` node slots
+ * `net` is an ordinary header whose arrays and redex ring point into the
+ * struct, so a fixed net can live on the stack and be built, inspected
+ * and hashed with the usual ic_net_* functions. It is reduced with its
+ * capacity's ic_netN_reduce, never freed.
+ */
+#define IC_FIXED_NET(cap) struct {                                  \
+    ic_net_t net;                                                   \
+    size_t node_limit;   /* Requested max_nodes, may exceed cap */  \
+    bool overflowed;     /* Last reduction outgrew the storage */   \
+    ic_wire_t wires[3 * (cap)];                                     \
+    uint8_t types[cap];                                             \
+    uint8_t active[cap];                                            \
+    ic_redex_t queue[IC_FIXED_QUEUE(cap)];                          \
+    ic_wire_t loop_wires[3 * (cap)];  /* net.loop_state's arrays */ \
+    uint8_t loop_types[cap];                                        \
+    ic_redex_t loop_queue[IC_FIXED_QUEUE(cap)];                     \
+}
+
+typedef IC_FIXED_NET(16) ic_net16_t;
+typedef IC_FIXED_NET(32) ic_net32_t;
+typedef IC_FIXED_NET(64) ic_net64_t;
+
+/**
+ * Prepare a fixed net for nets of up to max_nodes nodes
+ * max_nodes may exceed the capacity when the nets are known to stay
+ * smaller; a reduction that would outgrow the storage then returns -1.
+ */
+void ic_net16_init(ic_net16_t *fixed, size_t max_nodes, size_t gas_limit);
+void ic_net32_init(ic_net32_t *fixed, size_t max_nodes, size_t gas_limit);
+void ic_net64_init(ic_net64_t *fixed, size_t max_nodes, size_t gas_limit);
+
+/**
+ * ic_net_reduce specialized for one capacity
+ * Follows ic_net_reduce in FIFO order step for step, so gas, result and
+ * final layout are identical, but addresses the inline arrays directly and
+ * skips the bounds checks that queued redexes cannot fail. The net's goal
+ * is polled and checked, but input_number is ignored; without a goal, read
+ * the result with ic_net_factor_pair.
+ * @return 0 if fully reduced, 1 if stopped due to gas limit, 2 if stopped
+ *         at the gas limit after a loop was detected, 3 if the goal became
+ *         impossible, -1 if the net outgrew the capacity or the redex ring
+ *         (rebuild it and use ic_net_reduce)
+ */
+int ic_net16_reduce(ic_net16_t *fixed);
+int ic_net32_reduce(ic_net32_t *fixed);
+int ic_net64_reduce(ic_net64_t *fixed);
+
+/**
+ * Smallest specialized capacity with room for the given number of slots
+ * @return 16, 32 or 64, or 0 if no fixed net is large enough
+ */
+size_t ic_fixed_capacity(size_t slots);
+
+#endif // IC_FIXED_H
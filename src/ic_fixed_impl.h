@@ -0,0 +1,211 @@
+/*
+ * Reducer template for one fixed capacity, included by ic_fixed.c once per
+ * capacity with IC_FIXED_CAP defined. The rules come from ic_rules_impl.h,
+ * as ic_net_reduce's do, and the queue and scan mirror their ic_runtime.c
+ * counterparts; the capacity is a compile-time constant and every array is
+ * at a fixed offset from the struct, so no pointer is reloaded after a
+ * byte store and the ring mask is an immediate.
+ */
+
+#ifndef IC_FIXED_CAP
+#error "define IC_FIXED_CAP before including ic_fixed_impl.h"
+#endif
+
+#define IC_FIXED_PASTE(a, b, c) a##b##c
+#define IC_FIXED_NAME(a, b, c) IC_FIXED_PASTE(a, b, c)
+
+#define FIXED_T IC_FIXED_NAME(ic_net, IC_FIXED_CAP, _t)
+#define FIXED_FN(name) IC_FIXED_NAME(fixed, IC_FIXED_CAP, _##name)
+#define FIXED_MASK (IC_FIXED_QUEUE(IC_FIXED_CAP) - 1)
+
+// Rules count only if they completed; an overflowed net is reduced again
+#define FIXED_COUNT(f, field) do { if (!(f)->overflowed) IC_STAT_INC(&(f)->net, field); } while (0)
+
+// Completed rewrites are traced like the reference reducer's
+#define FIXED_TRACE(f, rule, node_a, node_b) do { \
+        if (!(f)->overflowed) IC_TRACE_EVENT(IC_TRACE_REWRITE, (rule), (node_a), (node_b)); \
+    } while (0)
+
+void IC_FIXED_NAME(ic_net, IC_FIXED_CAP, _init)(FIXED_T *f, size_t max_nodes, size_t gas_limit) {
+    ic_net_t *net = &f->net;
+    memset(net, 0, sizeof(*net));
+
+    // The header never sees more slots than the struct has
+    net->wires = f->wires;
+    net->types = f->types;
+    net->active = f->active;
+    net->max_nodes = (max_nodes < IC_FIXED_CAP) ? max_nodes : IC_FIXED_CAP;
+    net->free_head = -1;
+    net->gas_limit = gas_limit;
+    net->redex_queue = f->queue;
+    net->redex_queue_capacity = IC_FIXED_QUEUE(IC_FIXED_CAP);
+    net->redex_order = IC_REDEX_FIFO;
+    net->borrowed_storage = true;
+    net->loop_state.wires = f->loop_wires;
+    net->loop_state.types = f->loop_types;
+    net->loop_state.queue = f->loop_queue;
+    net->loop_state.slots = IC_FIXED_CAP;
+    net->loop_state.queue_slots = IC_FIXED_QUEUE(IC_FIXED_CAP);
+
+    f->node_limit = max_nodes;
+    f->overflowed = false;
+}
+
+static inline int FIXED_FN(new_node)(FIXED_T *f, ic_node_type_t type) {
+    ic_net_t *net = &f->net;
+    int idx;
+    if (net->free_head != -1) {
+        idx = net->free_head;
+        ic_wire_t next = f->wires[3 * (size_t)idx];
+        net->free_head = (next == IC_WIRE_NONE) ? -1 : (int)next;
+    } else if (net->used_nodes < net->max_nodes) {
+        idx = (int)net->used_nodes++;
+    } else {
+        // Out of storage before the net's own limit: not the reference outcome
+        if (f->node_limit > net->max_nodes) f->overflowed = true;
+        return -1;
+    }
+
+    f->types[idx] = (uint8_t)type;
+    f->active[idx] = 1;
+    f->wires[3 * (size_t)idx] = f->wires[3 * (size_t)idx + 1] = f->wires[3 * (size_t)idx + 2] = IC_WIRE_NONE;
+    return idx;
+}
+
+static inline bool FIXED_FN(is_redex)(const FIXED_T *f, int node_a, int node_b) {
+    return f->active[node_a] && f->active[node_b] &&
+           f->wires[3 * (size_t)node_a] == IC_WIRE(node_b, 0) &&
+           f->wires[3 * (size_t)node_b] == IC_WIRE(node_a, 0);
+}
+
+static inline void FIXED_FN(add_redex)(FIXED_T *f, int node_a, int node_b) {
+    if (!FIXED_FN(is_redex)(f, node_a, node_b)) return;
+
+    // The reference would grow its queue here
+    ic_net_t *net = &f->net;
+    if (net->redex_queue_size == IC_FIXED_QUEUE(IC_FIXED_CAP)) {
+        IC_TRACE_EVENT(IC_TRACE_QUEUE_FULL, IC_TRACE_QUEUE_FALLBACK, 0, IC_FIXED_QUEUE(IC_FIXED_CAP));
+        f->overflowed = true;
+        return;
+    }
+
+    size_t pos = (net->redex_queue_start + net->redex_queue_size) & FIXED_MASK;
+    f->queue[pos].node_a = node_a;
+    f->queue[pos].node_b = node_b;
+    net->redex_queue_size++;
+}
+
+static inline bool FIXED_FN(next_redex)(FIXED_T *f, int *node_a, int *node_b) {
+    ic_net_t *net = &f->net;
+    while (net->redex_queue_size > 0) {
+        size_t pos = net->redex_queue_start;
+        net->redex_queue_start = (pos + 1) & FIXED_MASK;
+        net->redex_queue_size--;
+
+        *node_a = f->queue[pos].node_a;
+        *node_b = f->queue[pos].node_b;
+        if (FIXED_FN(is_redex)(f, *node_a, *node_b)) return true;
+    }
+    return false;
+}
+
+// The rewrite rules, shared with ic_net_reduce; a redex taken from the
+// queue passed is_redex, so interact needs no index checks
+#define IC_RULES_T FIXED_T
+#define IC_RULES_FN(name) FIXED_FN(name)
+#define IC_RULES_NET(f) (&(f)->net)
+#define IC_RULES_WIRES(f) ((f)->wires)
+#define IC_RULES_TYPES(f) ((f)->types)
+#define IC_RULES_ACTIVE(f) ((f)->active)
+#define IC_RULES_NEW_NODE(f, type) FIXED_FN(new_node)((f), (type))
+#define IC_RULES_ADD_REDEX(f, a, b) FIXED_FN(add_redex)((f), (a), (b))
+#define IC_RULES_ABORTED(f) ((f)->overflowed)
+#define IC_RULES_COUNT(f, field) FIXED_COUNT((f), field)
+#define IC_RULES_TRACE(f, rule, a, b) FIXED_TRACE((f), (rule), (a), (b))
+#include "ic_rules_impl.h"
+
+static void FIXED_FN(scan)(FIXED_T *f) {
+    ic_net_t *net = &f->net;
+    net->redex_queue_size = 0;
+    net->redex_queue_start = 0;
+    net->redex_rescan_needed = false;
+
+    for (size_t i = 0; i < net->used_nodes; i++) {
+        if (!f->active[i]) continue;
+
+        ic_wire_t conn = f->wires[3 * i];
+        if (conn == IC_WIRE_NONE) continue;
+
+        int conn_node = IC_WIRE_NODE(conn);
+        if (conn_node > (int)i && IC_WIRE_PORT(conn) == 0 && f->active[conn_node]) {
+            FIXED_FN(add_redex)(f, (int)i, conn_node);
+        }
+    }
+}
+
+int IC_FIXED_NAME(ic_net, IC_FIXED_CAP, _reduce)(FIXED_T *f) {
+    ic_net_t *net = &f->net;
+    f->overflowed = false;
+    net->gas_used = 0;
+    net->gas_skipped = 0;
+    net->reduce_suspended = false;
+    ic_loop_detector_t loop;
+    ic_loop_detector_init(&loop, net);
+    ic_goal_poll_t poll;
+    ic_goal_poll_init(&poll, net->goal);
+    bool abandoned = false;
+
+    FIXED_FN(scan)(f);
+
+    while (net->gas_used < net->gas_limit) {
+        int node_a, node_b;
+        if (ic_goal_poll_step(&poll, net)) {
+            abandoned = true;
+            break;
+        }
+        if (!FIXED_FN(next_redex)(f, &node_a, &node_b)) {
+#ifdef IC_DEBUG
+            // Same consistency check as ic_net_reduce
+            IC_STAT_INC(net, rescans);
+            FIXED_FN(scan)(f);
+            if (net->redex_queue_size > 0) {
+                fprintf(stderr, "ic_net_reduce: %zu redexes were not queued by their rewrite\n",
+                        net->redex_queue_size);
+                continue;
+            }
+#endif
+            break;
+        }
+
+        FIXED_FN(interact)(f, node_a, node_b);
+        if (f->overflowed) return -1;
+        net->gas_used++;
+        ic_loop_detector_step(&loop, net);
+    }
+    if (f->overflowed) return -1;
+
+#ifdef IC_STATS
+    ic_stats_count_reduction(&net->stats, net->gas_used);
+    if (loop.found) {
+        net->stats.loops++;
+        net->stats.gas_skipped += net->gas_skipped;
+    }
+    if (abandoned) net->stats.abandoned++;
+#endif
+
+    if (abandoned) return 3;
+    if (net->goal && net->goal->reached) {
+        net->goal->reached(net->goal, net);
+    }
+
+    if (loop.found) return 2;
+    return (net->gas_used < net->gas_limit) ? 0 : 1;
+}
+
+#undef FIXED_TRACE
+#undef FIXED_COUNT
+#undef FIXED_MASK
+#undef FIXED_FN
+#undef FIXED_T
+#undef IC_FIXED_NAME
+#undef IC_FIXED_PASTE
@@ -0,0 +1,404 @@
+#include "ic_levin.h"
+#include "ic_trace.h"
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+// Node slots a snapshot holds; every enumerated net's reduction fits
+#define IC_LEVIN_SLOTS IC_ENUM_MAX_SLOTS
+
+// Queued redexes a snapshot holds, stale entries included
+#define IC_LEVIN_REDEXES 16
+
+// Byte a snapshot stores for IC_WIRE_NONE; every other wire value of a net
+// this small (packed wire or free-list link) is below it
+#define IC_LEVIN_WIRE_NONE 0xFFu
+
+// Marks a snapshot slot whose reduction has stopped
+#define IC_LEVIN_FINISHED UINT64_MAX
+
+_Static_assert(4 * IC_LEVIN_SLOTS < IC_LEVIN_WIRE_NONE, "snapshot wires must fit in a byte");
+
+/**
+ * A reduction suspended between phases, packed to a few cache lines:
+ * the used slots byte by byte and the redex queue in order
+ */
+typedef struct {
+    uint64_t index;              // IC_LEVIN_FINISHED once the reduction stopped
+    uint64_t gas_used;
+    uint64_t gas_skipped;
+    uint64_t next_poll;
+    ic_loop_detector_t loop;
+    uint8_t used_nodes;
+    int8_t free_head;
+    uint8_t queued;
+    bool rescan_needed;
+    uint8_t wires[3 * IC_LEVIN_SLOTS];
+    uint8_t types[IC_LEVIN_SLOTS];
+    uint8_t active[IC_LEVIN_SLOTS];
+    uint8_t queue[2 * IC_LEVIN_REDEXES];
+
+    // The state the loop detector compares against, if it saved one
+    uint8_t loop_used;
+    int8_t loop_free_head;
+    uint8_t loop_queued;
+    uint8_t loop_order;
+    uint8_t loop_wires[3 * IC_LEVIN_SLOTS];
+    uint8_t loop_types[IC_LEVIN_SLOTS];
+    uint8_t loop_queue[2 * IC_LEVIN_REDEXES];
+} ic_levin_snapshot_t;
+
+/**
+ * Pack `count` wires into one byte each
+ * @return 0 on success, -1 if a wire does not fit in a byte
+ */
+static int ic_levin_pack_wires(const ic_wire_t *wires, size_t count, uint8_t *packed) {
+    for (size_t w = 0; w < count; w++) {
+        ic_wire_t wire = wires[w];
+        if (wire != IC_WIRE_NONE && wire >= IC_LEVIN_WIRE_NONE) return -1;
+        packed[w] = (wire == IC_WIRE_NONE) ? IC_LEVIN_WIRE_NONE : (uint8_t)wire;
+    }
+    return 0;
+}
+
+static void ic_levin_unpack_wires(const uint8_t *packed, size_t count, ic_wire_t *wires) {
+    for (size_t w = 0; w < count; w++) {
+        wires[w] = (packed[w] == IC_LEVIN_WIRE_NONE) ? IC_WIRE_NONE : packed[w];
+    }
+}
+
+/**
+ * Pack the loop detector's saved state, so the reduction resumes with
+ * the same loop check whichever candidate used the net in between
+ * @return 0 on success, -1 if the saved state is larger than a snapshot holds
+ */
+static int ic_levin_save_loop(const ic_net_t *net, ic_levin_snapshot_t *snapshot) {
+    const ic_loop_state_t *saved = &net->loop_state;
+    size_t used = saved->used_nodes;
+    if (used > IC_LEVIN_SLOTS || saved->queued > IC_LEVIN_REDEXES) return -1;
+    if (ic_levin_pack_wires(saved->wires, 3 * used, snapshot->loop_wires) != 0) return -1;
+
+    memcpy(snapshot->loop_types, saved->types, used);
+    for (size_t i = 0; i < saved->queued; i++) {
+        snapshot->loop_queue[2 * i] = (uint8_t)saved->queue[i].node_a;
+        snapshot->loop_queue[2 * i + 1] = (uint8_t)saved->queue[i].node_b;
+    }
+    snapshot->loop_used = (uint8_t)used;
+    snapshot->loop_free_head = (int8_t)saved->free_head;
+    snapshot->loop_queued = (uint8_t)saved->queued;
+    snapshot->loop_order = saved->order;
+    return 0;
+}
+
+/**
+ * Pack a suspended reduction into a snapshot
+ * @return 0 on success, -1 if the net is larger than a snapshot holds
+ */
+static int ic_levin_save(const ic_net_t *net, uint64_t index, ic_levin_snapshot_t *snapshot) {
+    size_t used = net->used_nodes;
+    if (used > IC_LEVIN_SLOTS || net->redex_queue_size > IC_LEVIN_REDEXES) return -1;
+    if (ic_levin_pack_wires(net->wires, 3 * used, snapshot->wires) != 0) return -1;
+    if (net->reduce_loop.has_saved && ic_levin_save_loop(net, snapshot) != 0) return -1;
+
+    memcpy(snapshot->types, net->types, used);
+    memcpy(snapshot->active, net->active, used);
+
+    size_t mask = net->redex_queue_capacity - 1;
+    for (size_t i = 0; i < net->redex_queue_size; i++) {
+        const ic_redex_t *redex = &net->redex_queue[(net->redex_queue_start + i) & mask];
+        snapshot->queue[2 * i] = (uint8_t)redex->node_a;
+        snapshot->queue[2 * i + 1] = (uint8_t)redex->node_b;
+    }
+
+    snapshot->index = index;
+    snapshot->gas_used = net->gas_used;
+    snapshot->gas_skipped = net->gas_skipped;
+    snapshot->next_poll = net->reduce_next_poll;
+    snapshot->loop = net->reduce_loop;
+    snapshot->used_nodes = (uint8_t)used;
+    snapshot->free_head = (int8_t)net->free_head;
+    snapshot->queued = (uint8_t)net->redex_queue_size;
+    snapshot->rescan_needed = net->redex_rescan_needed;
+    return 0;
+}
+
+/**
+ * Unpack a snapshot into a net, whose next ic_net_reduce_steps call then
+ * continues the reduction
+ */
+static void ic_levin_restore(const ic_levin_snapshot_t *snapshot, ic_net_t *net) {
+    ic_net_reset(net);
+
+    size_t used = snapshot->used_nodes;
+    ic_levin_unpack_wires(snapshot->wires, 3 * used, net->wires);
+    memcpy(net->types, snapshot->types, used);
+    memcpy(net->active, snapshot->active, used);
+
+    // Any queue capacity above IC_LEVIN_REDEXES holds the entries in order
+    for (size_t i = 0; i < snapshot->queued; i++) {
+        net->redex_queue[i].node_a = snapshot->queue[2 * i];
+        net->redex_queue[i].node_b = snapshot->queue[2 * i + 1];
+    }
+
+    net->used_nodes = used;
+    net->free_head = snapshot->free_head;
+    net->gas_used = (size_t)snapshot->gas_used;
+    net->gas_skipped = (size_t)snapshot->gas_skipped;
+    net->redex_queue_size = snapshot->queued;
+    net->redex_rescan_needed = snapshot->rescan_needed;
+    net->reduce_suspended = true;
+    net->reduce_loop = snapshot->loop;
+    net->reduce_next_poll = (size_t)snapshot->next_poll;
+
+    // Without room for the saved state the detector starts sampling anew
+    if (!snapshot->loop.has_saved) return;
+    ic_loop_state_t *saved = &net->loop_state;
+    if (ic_net_reserve_loop_state(net, snapshot->loop_used, snapshot->loop_queued) != 0) {
+        net->reduce_loop.has_saved = false;
+        return;
+    }
+    ic_levin_unpack_wires(snapshot->loop_wires, 3 * (size_t)snapshot->loop_used, saved->wires);
+    memcpy(saved->types, snapshot->loop_types, snapshot->loop_used);
+    for (size_t i = 0; i < snapshot->loop_queued; i++) {
+        saved->queue[i].node_a = snapshot->loop_queue[2 * i];
+        saved->queue[i].node_b = snapshot->loop_queue[2 * i + 1];
+    }
+    saved->used_nodes = snapshot->loop_used;
+    saved->free_head = snapshot->loop_free_head;
+    saved->queued = snapshot->loop_queued;
+    saved->order = snapshot->loop_order;
+}
+
+/**
+ * Best candidate so far: smallest solving index of the current phase
+ */
+typedef struct {
+    _Atomic uint64_t index;  // UINT64_MAX while none
+    int factor_a;
+    int factor_b;
+    uint64_t gas;
+} ic_levin_best_t;
+
+/**
+ * Record a solving index if it is smaller than the best one so far
+ */
+static void ic_levin_offer(ic_levin_best_t *best, uint64_t index, const ic_net_t *net) {
+    #pragma omp critical(ic_levin_best)
+    {
+        if (index < atomic_load(&best->index)) {
+            best->factor_a = net->factor_a;
+            best->factor_b = net->factor_b;
+            best->gas = net->gas_used;
+            atomic_store(&best->index, index);
+        }
+    }
+}
+
+int64_t ic_search_levin(ic_enum_state_t *state, int N, size_t max_nodes, size_t gas_limit,
+                        ic_levin_result_t *result) {
+    ic_levin_result_t local;
+    if (!result) result = &local;
+    memset(result, 0, sizeof(*result));
+    result->solution_index = -1;
+    if (!state || N <= 1) return -1;
+
+    state->indices_searched = 0;
+    state->indices_deduplicated = 0;
+    state->rewrites = 0;
+    state->loops_detected = 0;
+    state->nets_abandoned = 0;
+    state->indices_pruned = 0;
+    state->distinct_nets = 0;
+    state->threads_used = 0;
+    state->threads_pinned = 0;
+#ifdef IC_STATS
+    memset(&state->stats, 0, sizeof(state->stats));
+#endif
+
+    // Too small a net cannot factor N; none at all means nothing to search
+    size_t min_net_size = ic_search_min_net_size(N, max_nodes, state->slot_reuse);
+    uint64_t start = state->search_start;
+    uint64_t range = (state->search_limit > start) ? state->search_limit - start : 0;
+    if (min_net_size == 0 || range == 0) return -1;
+
+    ic_goal_t goal = ic_goal_factor(N);
+    if (!state->prune) goal.impossible = NULL;
+
+#ifdef _OPENMP
+    int max_threads = (state->threads > 0) ? state->threads : omp_get_max_threads();
+#endif
+
+    // Layouts claimed by some candidate, kept over every phase: a larger
+    // twin never has more allowance than the smaller index and ends the
+    // same way, so only the smaller one is run
+    ic_enum_seen_t seen_table;
+    ic_enum_seen_t *seen = NULL;
+    if (state->dedup) {
+        if (ic_enum_seen_init(&seen_table) != 0) return IC_SEARCH_ERROR;
+        seen = &seen_table;
+    }
+
+    ic_levin_snapshot_t *suspended = NULL;
+    size_t count = 0, capacity = 0;
+    ic_levin_best_t best = { .factor_a = 0, .factor_b = 0, .gas = 0 };
+    atomic_init(&best.index, UINT64_MAX);
+    uint64_t introduced = 0;  // Offsets below this have been started
+    bool failed = false;
+
+    for (unsigned phase = 1; !failed && (count > 0 || introduced < range); phase++) {
+        // This phase starts the candidates of length `phase`
+        uint64_t fresh_end = (phase >= 64) ? range : ((uint64_t)1 << phase) - 1;
+        if (fresh_end > range) fresh_end = range;
+        size_t fresh = (size_t)(fresh_end - introduced);
+
+        if (count + fresh > capacity) {
+            size_t grown = (capacity > 0) ? capacity : 1024;
+            while (grown < count + fresh) grown *= 2;
+            ic_levin_snapshot_t *larger = (ic_levin_snapshot_t*)realloc(
+                suspended, grown * sizeof(ic_levin_snapshot_t));
+            if (!larger) {
+                failed = true;
+                break;
+            }
+            suspended = larger;
+            capacity = grown;
+        }
+
+        // Item i is snapshot i: the suspended reductions, then the new
+        // candidates, each written back to its own slot if it suspends again
+        size_t items = count + fresh;
+        uint64_t candidates = 0, rewrites = 0, resumptions = 0, loops = 0, abandoned = 0;
+        uint64_t pruned = 0, deduplicated = 0;
+        int threads_used = 0, pool_failed = 0;
+
+        #pragma omp parallel num_threads(max_threads) \
+            reduction(+:candidates, rewrites, resumptions, loops, abandoned, pruned, deduplicated)
+        {
+            ic_enum_cursor_t cursor;
+            ic_enum_cursor_init(&cursor);
+
+            #pragma omp atomic
+            threads_used++;
+            IC_TRACE_ATTACH();
+
+            ic_net_t *net = ic_net_create(max_nodes, gas_limit);
+            if (!net) {
+                #pragma omp atomic write
+                pool_failed = 1;
+            } else {
+                ic_net_set_loop_check(net, state->loop_check_interval);
+                ic_net_set_slot_reuse(net, state->slot_reuse);
+                ic_net_set_goal(net, &goal);
+            }
+
+            #pragma omp for schedule(dynamic, IC_SEARCH_CHUNK)
+            for (size_t i = 0; i < items; i++) {
+                ic_levin_snapshot_t *snapshot = &suspended[i];
+                if (!net) {
+                    snapshot->index = IC_LEVIN_FINISHED;
+                    continue;
+                }
+
+                uint64_t index;
+                if (i < count) {
+                    index = snapshot->index;
+                    ic_levin_restore(snapshot, net);
+                    resumptions++;
+                } else {
+                    index = start + introduced + (i - count);
+                    snapshot->index = IC_LEVIN_FINISHED;
+                    size_t size = ic_enum_net_size(index);
+                    if (size < min_net_size) {
+                        pruned++;
+                        continue;
+                    }
+                    if (size > max_nodes) continue;
+                    if (seen && ic_enum_seen_claim(seen, index)) {
+                        deduplicated++;
+                        continue;
+                    }
+                    ic_enum_cursor_copy(ic_enum_cursor_seek(&cursor, index), net);
+                    candidates++;
+                }
+
+                // The rest of this phase cannot beat a solution below it
+                if (index > atomic_load_explicit(&best.index, memory_order_relaxed)) {
+                    snapshot->index = IC_LEVIN_FINISHED;
+                    continue;
+                }
+
+                unsigned length = ic_levin_length(index - start);
+                size_t allowance = ic_levin_allowance(phase, length, gas_limit);
+                size_t before = net->gas_used - net->gas_skipped;
+                IC_TRACE_EVENT(IC_TRACE_INDEX_BEGIN, 0, index, 0);
+                int status = ic_net_reduce_steps(net, allowance - net->gas_used);
+
+                // A snapshot too small for the net finishes it right away
+                if (status == IC_REDUCE_SUSPENDED && ic_levin_save(net, index, snapshot) != 0) {
+                    status = ic_net_reduce_steps(net, gas_limit);
+                }
+                rewrites += (net->gas_used - net->gas_skipped) - before;
+                IC_TRACE_EVENT(IC_TRACE_INDEX_END, (unsigned)status, index,
+                               (net->gas_used < UINT32_MAX) ? (uint32_t)net->gas_used : UINT32_MAX);
+                if (status == IC_REDUCE_SUSPENDED) continue;
+
+                snapshot->index = IC_LEVIN_FINISHED;
+                if (status == 2) loops++;
+                if (status == 3) abandoned++;
+                if (net->factor_found) ic_levin_offer(&best, index, net);
+            }
+
+#ifdef IC_STATS
+            if (net) {
+                #pragma omp critical(ic_levin_stats)
+                ic_stats_add(&state->stats, &net->stats);
+            }
+#endif
+            ic_net_free(net);
+        }
+
+        result->phases = phase;
+        result->candidates += candidates;
+        result->rewrites += rewrites;
+        result->resumptions += resumptions;
+        state->indices_pruned += pruned;
+        state->indices_deduplicated += deduplicated;
+        state->loops_detected += loops;
+        state->nets_abandoned += abandoned;
+        if (threads_used > state->threads_used) state->threads_used = threads_used;
+        introduced = fresh_end;
+        if (pool_failed) failed = true;
+
+        uint64_t found = atomic_load(&best.index);
+        if (found != UINT64_MAX) {
+            result->solution_index = (int64_t)found;
+            result->factor_a = best.factor_a;
+            result->factor_b = best.factor_b;
+            result->phase = phase;
+            result->solution_gas = best.gas;
+            break;
+        }
+
+        // Keep the reductions still suspended, in index order
+        size_t kept = 0;
+        for (size_t i = 0; i < items; i++) {
+            if (suspended[i].index == IC_LEVIN_FINISHED) continue;
+            if (kept != i) suspended[kept] = suspended[i];
+            kept++;
+        }
+        count = kept;
+        if (count > result->peak_suspended) result->peak_suspended = count;
+    }
+
+    free(suspended);
+    state->distinct_nets = seen ? atomic_load(&seen->count) : 0;
+    if (seen) ic_enum_seen_destroy(seen);
+    state->indices_searched = result->candidates + state->indices_deduplicated;
+    state->rewrites = result->rewrites;
+    state->current_index = start + introduced;
+    return failed ? IC_SEARCH_ERROR : result->solution_index;
+}
@@ -0,0 +1,71 @@
+#ifndef IC_LEVIN_H
+#define IC_LEVIN_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "ic_search.h"
+
+/**
+ * Description length of the candidate at `offset` into a search's range:
+ * the bit length of offset + 1, so offsets 0, 1-2, 3-6, ... have lengths
+ * 1, 2, 3, ... and there are 2^(l-1) candidates of length l
+ */
+static inline unsigned ic_levin_length(uint64_t offset) {
+    unsigned length = 0;
+    for (uint64_t bits = offset + 1; bits; bits >>= 1) length++;
+    return length;
+}
+
+/**
+ * Total rewrites a candidate of length `length` may have used by the end
+ * of phase `phase`: 2^(phase - length), capped at the gas limit
+ */
+static inline size_t ic_levin_allowance(unsigned phase, unsigned length, size_t gas_limit) {
+    if (phase < length) return 0;
+    unsigned shift = phase - length;
+    if (shift >= 63 || ((size_t)1 << shift) >= gas_limit) return gas_limit;
+    return (size_t)1 << shift;
+}
+
+/**
+ * Outcome of a Levin search
+ */
+typedef struct {
+    int64_t solution_index;   // Solving index found first, or -1 if none
+    int factor_a;             // Factors read from its net
+    int factor_b;
+    unsigned phase;           // Phase it was found in (0 if none)
+    uint64_t solution_gas;    // Rewrites its reduction took
+    unsigned phases;          // Phases run
+    uint64_t candidates;      // Indices whose reduction was started
+    uint64_t rewrites;        // Rewrites over every phase and candidate
+    uint64_t resumptions;     // Slices that continued a suspended reduction
+    size_t peak_suspended;    // Most reductions suspended between two phases
+} ic_levin_result_t;
+
+/**
+ * Factor N with Levin-style universal search over the state's range
+ * Phase k runs every candidate of length l <= k (ic_levin_length) until
+ * it has used 2^(k - l) rewrites in total or its reduction stops, so each
+ * phase costs about k * 2^(k-1) rewrites, shared out equally over the
+ * lengths, and a net that halts after t rewrites is reached in phase
+ * l + log2(t) instead of after every smaller index has spent the full gas
+ * limit. A reduction that runs out of its allowance is suspended
+ * (ic_net_reduce_steps) and kept in a compact snapshot, and the next
+ * phase resumes it where it stopped rather than starting over. A net only
+ * counts as a solution when its reduction stops, as in ic_search_factor,
+ * so the allowance never exceeds gas_limit and both searches accept the
+ * same indices; the one found is the smallest solving index of the
+ * earliest phase with one, not necessarily the smallest overall.
+ * Uses the state's range, thread count, pruning, deduplication and loop
+ * detection, and fills its indices_searched, indices_deduplicated,
+ * rewrites, loops_detected, nets_abandoned, indices_pruned, distinct_nets
+ * and threads_used statistics; result may be NULL.
+ * @return The index found, -1 if no candidate factors N, or IC_SEARCH_ERROR
+ *         if memory ran out
+ */
+int64_t ic_search_levin(ic_enum_state_t *state, int N, size_t max_nodes, size_t gas_limit,
+                        ic_levin_result_t *result);
+
+#endif // IC_LEVIN_H
@@ -0,0 +1,230 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "ic_netfile.h"
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+_Static_assert(sizeof(ic_netfile_header_t) == 56, "ic_netfile_header_t must stay 56 bytes on disk");
+
+size_t ic_netfile_record_bytes(size_t used_nodes) {
+    size_t bytes = sizeof(ic_netfile_header_t) + used_nodes * (3 * sizeof(ic_wire_t) + 2);
+    return (bytes + 7) & ~(size_t)7;
+}
+
+/**
+ * Check a header before anything it describes is read
+ */
+static bool ic_netfile_header_valid(const ic_netfile_header_t *header) {
+    return header->magic == IC_NETFILE_MAGIC && header->version == IC_NETFILE_VERSION &&
+           header->record_bytes == ic_netfile_record_bytes(header->used_nodes) &&
+           header->status >= -1 && header->status <= 3 &&
+           header->free_head >= -1 && (int64_t)header->free_head < (int64_t)header->used_nodes;
+}
+
+/**
+ * Check that stored nodes only refer to slots inside the record, so a
+ * damaged file cannot send a reducer out of bounds
+ */
+static bool ic_netfile_nodes_valid(const ic_wire_t *wires, const uint8_t *types,
+                                   const uint8_t *active, size_t used, int32_t free_head) {
+    for (size_t i = 0; i < used; i++) {
+        if (types[i] > IC_NODE_EPSILON || active[i] > 1) return false;
+
+        // A free slot only keeps the next free slot in its principal wire
+        const ic_wire_t *ports = &wires[3 * i];
+        if (!active[i]) {
+            if (ports[0] != IC_WIRE_NONE && ports[0] >= used) return false;
+            continue;
+        }
+        for (int p = 0; p < 3; p++) {
+            if (ports[p] == IC_WIRE_NONE) continue;
+            if ((size_t)IC_WIRE_NODE(ports[p]) >= used || IC_WIRE_PORT(ports[p]) > 2) return false;
+        }
+    }
+
+    // The free list must end and only pass through free slots
+    size_t steps = 0;
+    for (int64_t slot = free_head; slot >= 0; steps++) {
+        if (steps >= used || active[slot]) return false;
+        ic_wire_t next = wires[3 * (size_t)slot];
+        slot = (next == IC_WIRE_NONE) ? -1 : (int64_t)next;
+    }
+    return true;
+}
+
+/**
+ * fwrite that also accepts an empty array
+ */
+static bool ic_netfile_put(const void *data, size_t size, size_t count, FILE *out) {
+    return count == 0 || fwrite(data, size, count, out) == count;
+}
+
+/**
+ * fread counterpart of ic_netfile_put
+ */
+static bool ic_netfile_get(void *data, size_t size, size_t count, FILE *in) {
+    return count == 0 || fread(data, size, count, in) == count;
+}
+
+int ic_net_write(FILE *out, const ic_net_t *net, uint64_t index, int status) {
+    if (!out || !net) return -1;
+
+    size_t used = net->used_nodes;
+    int factor_a = 0, factor_b = 0;
+    if (!ic_net_factor_pair(net, &factor_a, &factor_b)) {
+        factor_a = factor_b = 0;
+    }
+
+    ic_netfile_header_t header = {
+        .magic = IC_NETFILE_MAGIC,
+        .version = IC_NETFILE_VERSION,
+        .index = index,
+        .gas_used = net->gas_used,
+        .gas_limit = net->gas_limit,
+        .used_nodes = (uint32_t)used,
+        .free_head = net->free_head,
+        .status = status,
+        .factor_a = factor_a,
+        .factor_b = factor_b,
+        .record_bytes = (uint32_t)ic_netfile_record_bytes(used),
+    };
+    size_t padding = header.record_bytes - sizeof(header) - used * (3 * sizeof(ic_wire_t) + 2);
+    static const unsigned char zeros[8] = { 0 };
+
+    // One record at a time, whichever threads share the stream
+    flockfile(out);
+    bool ok = ic_netfile_put(&header, sizeof(header), 1, out) &&
+              ic_netfile_put(net->wires, sizeof(ic_wire_t), 3 * used, out) &&
+              ic_netfile_put(net->types, 1, used, out) &&
+              ic_netfile_put(net->active, 1, used, out) &&
+              ic_netfile_put(zeros, 1, padding, out);
+    funlockfile(out);
+    return ok ? 0 : -1;
+}
+
+int ic_net_read(FILE *in, ic_net_t *net, ic_netfile_header_t *header) {
+    if (!in || !net) return -1;
+
+    ic_netfile_header_t stored;
+    if (fread(&stored, sizeof(stored), 1, in) != 1) {
+        return feof(in) ? 0 : -1;
+    }
+    if (!ic_netfile_header_valid(&stored)) return -1;
+    if (header) *header = stored;
+
+    size_t used = stored.used_nodes;
+    size_t payload = stored.record_bytes - sizeof(stored);
+    if (used > net->max_nodes) {
+        // Leave the stream at the next record
+        fseek(in, (long)payload, SEEK_CUR);
+        return -1;
+    }
+
+    unsigned char padding[8];
+    bool ok = ic_netfile_get(net->wires, sizeof(ic_wire_t), 3 * used, in) &&
+              ic_netfile_get(net->types, 1, used, in) &&
+              ic_netfile_get(net->active, 1, used, in) &&
+              ic_netfile_get(padding, 1, payload - used * (3 * sizeof(ic_wire_t) + 2), in) &&
+              ic_netfile_nodes_valid(net->wires, net->types, net->active, used, stored.free_head);
+
+    ic_net_reset(net);
+    if (!ok) return -1;
+
+    net->used_nodes = used;
+    net->free_head = stored.free_head;
+    net->gas_used = (size_t)stored.gas_used;
+    net->gas_limit = (size_t)stored.gas_limit;
+    net->factor_a = stored.factor_a;
+    net->factor_b = stored.factor_b;
+    net->factor_found = stored.factor_a > 0;
+    return 1;
+}
+
+int ic_netfile_open(ic_netfile_t *file, const char *path) {
+    if (!file || !path) return -1;
+    memset(file, 0, sizeof(*file));
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return -1;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return -1;
+    }
+
+    // An empty file holds no records; mmap refuses zero-length mappings
+    size_t size = (size_t)st.st_size;
+    if (size == 0) {
+        close(fd);
+        return 0;
+    }
+
+    void *map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) return -1;
+
+    // Validate every record once, so views can be handed out unchecked
+    const unsigned char *bytes = (const unsigned char*)map;
+    size_t offset = 0, count = 0;
+    while (offset < size) {
+        const ic_netfile_header_t *header = (const ic_netfile_header_t*)(bytes + offset);
+        if (size - offset < sizeof(*header) || !ic_netfile_header_valid(header) ||
+            size - offset < header->record_bytes) {
+            munmap(map, size);
+            return -1;
+        }
+
+        size_t used = header->used_nodes;
+        const ic_wire_t *wires = (const ic_wire_t*)(header + 1);
+        const uint8_t *types = (const uint8_t*)(wires + 3 * used);
+        if (!ic_netfile_nodes_valid(wires, types, types + used, used, header->free_head)) {
+            munmap(map, size);
+            return -1;
+        }
+        offset += header->record_bytes;
+        count++;
+    }
+
+    file->map = bytes;
+    file->map_size = size;
+    file->count = count;
+    return 0;
+}
+
+void ic_netfile_close(ic_netfile_t *file) {
+    if (!file) return;
+    if (file->map) munmap((void*)file->map, file->map_size);
+    memset(file, 0, sizeof(*file));
+}
+
+int ic_netfile_next(const ic_netfile_t *file, size_t *offset, ic_net_t *view,
+                    const ic_netfile_header_t **header) {
+    if (!file || !file->map || !offset || !view || *offset >= file->map_size) return 0;
+
+    const ic_netfile_header_t *stored = (const ic_netfile_header_t*)(file->map + *offset);
+    size_t used = stored->used_nodes;
+
+    memset(view, 0, sizeof(*view));
+    view->wires = (ic_wire_t*)(stored + 1);
+    view->types = (uint8_t*)(view->wires + 3 * used);
+    view->active = view->types + used;
+    view->max_nodes = used;
+    view->used_nodes = used;
+    view->free_head = stored->free_head;
+    view->gas_limit = (size_t)stored->gas_limit;
+    view->gas_used = (size_t)stored->gas_used;
+    view->redex_order = IC_REDEX_FIFO;
+    view->borrowed_storage = true;
+    view->factor_a = stored->factor_a;
+    view->factor_b = stored->factor_b;
+    view->factor_found = stored->factor_a > 0;
+
+    if (header) *header = stored;
+    *offset += stored->record_bytes;
+    return 1;
+}
@@ -0,0 +1,97 @@
+#ifndef IC_NETFILE_H
+#define IC_NETFILE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "ic_runtime.h"
+
+#define IC_NETFILE_MAGIC   0x54454E49u  // "INET" little-endian
+#define IC_NETFILE_VERSION 1u
+
+// Index recorded for nets that were not built from an enumeration index
+#define IC_NETFILE_NO_INDEX UINT64_MAX
+
+/**
+ * Header of one serialized net (56 bytes on disk)
+ * It is followed by the net's used_nodes slots packed as in ic_net_t's
+ * storage block: 3 * used_nodes wires, then used_nodes types, then
+ * used_nodes liveness bytes, zero-padded to a multiple of 8 bytes so the
+ * next record's header and wires stay aligned. A file is any number of
+ * records back to back in native byte order, like the outcome table.
+ */
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t index;         // Enumeration index, IC_NETFILE_NO_INDEX if none
+    uint64_t gas_used;
+    uint64_t gas_limit;
+    uint32_t used_nodes;
+    int32_t free_head;      // Free slots keep their list in their wires
+    int32_t status;         // ic_net_reduce's result, -1 if not reduced
+    int32_t factor_a;       // ic_net_factor_pair when written, 0 without a pair
+    int32_t factor_b;
+    uint32_t record_bytes;  // Header plus padded node data
+} ic_netfile_header_t;
+
+/**
+ * Bytes one record of a net with used_nodes slots takes on disk
+ */
+size_t ic_netfile_record_bytes(size_t used_nodes);
+
+/**
+ * Append a net to a stream as one record
+ * The redex queue is not stored: ic_net_reduce rebuilds it from the
+ * wiring before its first rewrite. The record is written under the
+ * stream's lock, so threads may share one stream.
+ * @param index   Enumeration index of the net, or IC_NETFILE_NO_INDEX
+ * @param status  ic_net_reduce's result, or -1 for an unreduced net
+ * @return 0 on success, -1 on a write error
+ */
+int ic_net_write(FILE *out, const ic_net_t *net, uint64_t index, int status);
+
+/**
+ * Read the next record of a stream into an existing net
+ * Restores the nodes, free list, gas and factor pair (factor_found is set
+ * when the record has one); the queue is emptied and input_number, goal
+ * and settings are kept. A net read back reduces exactly like the one
+ * written. header, if not NULL, receives the record's header.
+ * @return 1 if a net was read, 0 at the end of the stream, -1 if the
+ *         record is malformed or does not fit the net
+ */
+int ic_net_read(FILE *in, ic_net_t *net, ic_netfile_header_t *header);
+
+/**
+ * A read-only, memory-mapped file of net records
+ */
+typedef struct {
+    const unsigned char *map;  // Base of the mapping
+    size_t map_size;
+    size_t count;              // Records in the file
+} ic_netfile_t;
+
+/**
+ * Map a file of net records read-only and validate every record
+ * @return 0 on success, -1 on error
+ */
+int ic_netfile_open(ic_netfile_t *file, const char *path);
+
+/**
+ * Unmap a file opened with ic_netfile_open
+ */
+void ic_netfile_close(ic_netfile_t *file);
+
+/**
+ * Point `view` at the record starting at *offset (0 for the first) and
+ * advance *offset to the next record
+ * The view's node arrays are the mapped file itself, so nothing is copied.
+ * It answers ic_net_factor_pair, ic_net_hash, ic_net_print and
+ * ic_net_export_dot but must not be modified or reduced; ic_net_read gives
+ * a net that can be. header, if not NULL, points at the record's header.
+ * @return 1 if the view was set, 0 after the last record
+ */
+int ic_netfile_next(const ic_netfile_t *file, size_t *offset, ic_net_t *view,
+                    const ic_netfile_header_t **header);
+
+#endif // IC_NETFILE_H
@@ -0,0 +1,523 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "ic_parallel.h"
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+// Nodes one rewrite claims at most: its pair, four auxiliary peers and
+// the two nodes a δγ rewrite creates
+#define PAR_MAX_CLAIMS 8
+
+// Initial capacity of a worker's deque; must be a power of two
+#define PAR_DEQUE_INITIAL 64
+
+#ifdef IC_STATS
+#define PAR_STAT_INC(w, field) ((w)->stats.field++)
+#else
+#define PAR_STAT_INC(w, field) ((void)0)
+#endif
+
+/**
+ * Redexes and spare node slots of one thread
+ * The owner pushes and pops the newest entry; thieves take the oldest.
+ * Both ends are guarded by the same spin lock, held only to move one entry.
+ */
+typedef struct {
+    _Alignas(64) atomic_flag lock;
+    ic_redex_t *items;   // Ring of capacity entries (power of two)
+    size_t capacity;
+    size_t head;         // Oldest entry
+    size_t size;
+    int free_head;       // Slots this worker released, reused by it first
+#ifdef IC_STATS
+    ic_stats_t stats;
+#endif
+} par_worker_t;
+
+/**
+ * State shared by the threads of one parallel reduction
+ */
+typedef struct {
+    ic_net_t *net;
+    atomic_uchar *claims;      // 1 while a rewrite owns the node
+    par_worker_t *workers;
+    int num_workers;
+    atomic_size_t next_slot;   // used_nodes while the threads run
+    atomic_size_t gas;         // Rewrites done or reserved
+    atomic_size_t pending;     // Queued redexes plus those being rewritten
+    atomic_bool stop;          // Set once the gas ran out
+    atomic_bool dropped;       // A deque could not grow and lost a redex
+} par_state_t;
+
+/**
+ * Nodes claimed by the rewrite in progress
+ */
+typedef struct {
+    int nodes[PAR_MAX_CLAIMS];
+    int count;
+} par_claims_t;
+
+typedef enum {
+    PAR_DONE,    // Rewritten
+    PAR_STALE,   // No longer a redex
+    PAR_RETRY,   // Another rewrite holds one of its nodes
+    PAR_NO_GAS   // The gas ran out first
+} par_outcome_t;
+
+static inline ic_wire_t *par_slot(ic_net_t *net, ic_wire_t wire) {
+    return &net->wires[3 * (size_t)IC_WIRE_NODE(wire) + IC_WIRE_PORT(wire)];
+}
+
+static inline bool par_is_redex(const ic_net_t *net, int node_a, int node_b) {
+    return net->active[node_a] && net->active[node_b] &&
+           net->wires[3 * (size_t)node_a] == IC_WIRE(node_b, 0) &&
+           net->wires[3 * (size_t)node_b] == IC_WIRE(node_a, 0);
+}
+
+static inline void par_lock(par_worker_t *w) {
+    while (atomic_flag_test_and_set_explicit(&w->lock, memory_order_acquire)) {
+        // Spin; the holder only moves one entry
+    }
+}
+
+static inline void par_unlock(par_worker_t *w) {
+    atomic_flag_clear_explicit(&w->lock, memory_order_release);
+}
+
+/**
+ * Double a deque's ring, keeping its entries in order; called with the lock held
+ * @return 0 on success, -1 if out of memory
+ */
+static int par_grow(par_worker_t *w) {
+    size_t capacity = w->capacity * 2;
+    ic_redex_t *items = (ic_redex_t*)malloc(capacity * sizeof(ic_redex_t));
+    if (!items) return -1;
+
+    for (size_t i = 0; i < w->size; i++) {
+        items[i] = w->items[(w->head + i) & (w->capacity - 1)];
+    }
+    free(w->items);
+    w->items = items;
+    w->capacity = capacity;
+    w->head = 0;
+    return 0;
+}
+
+/**
+ * Queue a redex at the owner's end of a deque
+ * A redex that does not fit is dropped and found by the next round's scan.
+ * @param fresh  Count it as pending; false when requeueing a popped entry
+ * @param front  Put it at the thieves' end so the owner tries other work first
+ */
+static void par_push(par_state_t *par, par_worker_t *w, int node_a, int node_b,
+                     bool fresh, bool front) {
+    par_lock(w);
+    if (w->size == w->capacity && par_grow(w) != 0) {
+        par_unlock(w);
+        PAR_STAT_INC(w, redexes_dropped);
+        atomic_store(&par->dropped, true);
+        if (!fresh) atomic_fetch_sub(&par->pending, 1);
+        return;
+    }
+
+    size_t mask = w->capacity - 1;
+    size_t pos;
+    if (front) {
+        w->head = (w->head - 1) & mask;
+        pos = w->head;
+    } else {
+        pos = (w->head + w->size) & mask;
+    }
+    w->items[pos].node_a = node_a;
+    w->items[pos].node_b = node_b;
+    w->size++;
+    if (fresh) atomic_fetch_add(&par->pending, 1);
+    par_unlock(w);
+}
+
+/**
+ * Take the owner's newest or, for a thief, the oldest entry of a deque
+ * @return true if an entry was taken
+ */
+static bool par_take(par_worker_t *w, bool oldest, ic_redex_t *redex) {
+    par_lock(w);
+    if (w->size == 0) {
+        par_unlock(w);
+        return false;
+    }
+
+    size_t mask = w->capacity - 1;
+    if (oldest) {
+        *redex = w->items[w->head];
+        w->head = (w->head + 1) & mask;
+    } else {
+        *redex = w->items[(w->head + w->size - 1) & mask];
+    }
+    w->size--;
+    par_unlock(w);
+    return true;
+}
+
+/**
+ * Claim a node for the rewrite in progress; nodes it already holds succeed
+ * @return false if another rewrite holds it
+ */
+static bool par_claim(par_state_t *par, par_claims_t *claims, int node) {
+    for (int i = 0; i < claims->count; i++) {
+        if (claims->nodes[i] == node) return true;
+    }
+
+    unsigned char expected = 0;
+    if (!atomic_compare_exchange_strong_explicit(&par->claims[node], &expected, 1,
+                                                 memory_order_acquire,
+                                                 memory_order_relaxed)) {
+        return false;
+    }
+    claims->nodes[claims->count++] = node;
+    return true;
+}
+
+static bool par_claim_peer(par_state_t *par, par_claims_t *claims, ic_wire_t peer) {
+    return peer == IC_WIRE_NONE || par_claim(par, claims, IC_WIRE_NODE(peer));
+}
+
+static void par_unclaim_all(par_state_t *par, par_claims_t *claims) {
+    for (int i = 0; i < claims->count; i++) {
+        atomic_store_explicit(&par->claims[claims->nodes[i]], 0, memory_order_release);
+    }
+    claims->count = 0;
+}
+
+/**
+ * ic_net_new_node for one worker: its own released slots first, then a
+ * fresh slot above the shared high-water mark
+ * A released slot can still be named by a stale queue entry or a one-way
+ * wire, so it is claimed before its free-list link is read; if another
+ * rewrite holds it, a fresh slot is taken instead.
+ * @return Index of the claimed node, -1 if no slot is left, -2 if the
+ *         only spare slot is held by another rewrite
+ */
+static int par_new_node(par_state_t *par, par_worker_t *w, par_claims_t *claims,
+                        ic_node_type_t type) {
+    ic_net_t *net = par->net;
+    int idx = -1;
+    bool busy = false;
+    if (w->free_head != -1) {
+        if (par_claim(par, claims, w->free_head)) {
+            idx = w->free_head;
+            ic_wire_t next = net->wires[3 * (size_t)idx];
+            w->free_head = (next == IC_WIRE_NONE) ? -1 : (int)next;
+        } else {
+            busy = true;
+        }
+    }
+    if (idx == -1) {
+        size_t slot = atomic_load(&par->next_slot);
+        do {
+            if (slot >= net->max_nodes) return busy ? -2 : -1;
+        } while (!atomic_compare_exchange_weak(&par->next_slot, &slot, slot + 1));
+        idx = (int)slot;
+        par_claim(par, claims, idx);  // Never seen by anyone else yet
+    }
+
+    net->types[idx] = (uint8_t)type;
+    net->active[idx] = 1;
+    net->wires[3 * (size_t)idx] = net->wires[3 * (size_t)idx + 1] =
+        net->wires[3 * (size_t)idx + 2] = IC_WIRE_NONE;
+    return idx;
+}
+
+/**
+ * ic_release_node onto the worker's free list (with slot reuse on)
+ */
+static void par_release_node(par_state_t *par, par_worker_t *w, int idx) {
+    ic_net_t *net = par->net;
+    ic_wire_t *ports = &net->wires[3 * (size_t)idx];
+    for (int p = 0; p < 3; p++) {
+        ic_wire_t peer = ports[p];
+        if (peer != IC_WIRE_NONE && *par_slot(net, peer) == IC_WIRE(idx, p)) {
+            *par_slot(net, peer) = IC_WIRE_NONE;
+        }
+    }
+
+    net->active[idx] = 0;
+    ports[1] = ports[2] = IC_WIRE_NONE;
+    if (!net->reuse_slots) {
+        ports[0] = IC_WIRE_NONE;
+        return;
+    }
+    ports[0] = (w->free_head == -1) ? IC_WIRE_NONE : (ic_wire_t)w->free_head;
+    w->free_head = idx;
+}
+
+/**
+ * ic_net_link for claimed ports; a new principal pair goes to the worker's deque
+ */
+static void par_link(par_state_t *par, par_worker_t *w, ic_wire_t a, ic_wire_t b) {
+    ic_net_t *net = par->net;
+    if (a != IC_WIRE_NONE) *par_slot(net, a) = b;
+    if (b != IC_WIRE_NONE) *par_slot(net, b) = a;
+
+    if (a != IC_WIRE_NONE && b != IC_WIRE_NONE &&
+        IC_WIRE_PORT(a) == 0 && IC_WIRE_PORT(b) == 0 &&
+        par_is_redex(net, IC_WIRE_NODE(a), IC_WIRE_NODE(b))) {
+        par_push(par, w, IC_WIRE_NODE(a), IC_WIRE_NODE(b), true, false);
+    }
+}
+
+/**
+ * Claim a queued pair and every node its rule relinks, then rewrite it
+ * with the rules of ic_rules_impl.h
+ */
+static par_outcome_t par_rewrite(par_state_t *par, par_worker_t *w, int node_a, int node_b) {
+    ic_net_t *net = par->net;
+    par_claims_t claims = { .count = 0 };
+
+    // Writers of a node's ports must hold it, so once the pair is held its
+    // wires stay put and name the peers to claim
+    if (!par_claim(par, &claims, node_a) || !par_claim(par, &claims, node_b)) {
+        par_unclaim_all(par, &claims);
+        return PAR_RETRY;
+    }
+    if (!par_is_redex(net, node_a, node_b)) {
+        par_unclaim_all(par, &claims);
+        return PAR_STALE;
+    }
+
+    ic_node_type_t type_a = (ic_node_type_t)net->types[node_a];
+    ic_node_type_t type_b = (ic_node_type_t)net->types[node_b];
+    ic_wire_t a1 = net->wires[3 * (size_t)node_a + 1], a2 = net->wires[3 * (size_t)node_a + 2];
+    ic_wire_t b1 = net->wires[3 * (size_t)node_b + 1], b2 = net->wires[3 * (size_t)node_b + 2];
+    bool epsilon = (type_a == IC_NODE_EPSILON || type_b == IC_NODE_EPSILON);
+
+    // ε only disconnects its own peers; the other rules relink all four
+    bool held;
+    if (epsilon && type_a == IC_NODE_EPSILON) {
+        held = par_claim_peer(par, &claims, a1) && par_claim_peer(par, &claims, a2);
+    } else if (epsilon) {
+        held = par_claim_peer(par, &claims, b1) && par_claim_peer(par, &claims, b2);
+    } else {
+        held = par_claim_peer(par, &claims, a1) && par_claim_peer(par, &claims, a2) &&
+               par_claim_peer(par, &claims, b1) && par_claim_peer(par, &claims, b2);
+    }
+    if (!held) {
+        par_unclaim_all(par, &claims);
+        return PAR_RETRY;
+    }
+
+    // δγ takes its two new nodes before spending gas, so a busy slot can
+    // still back out
+    bool a_is_delta = (type_a == IC_NODE_DELTA);
+    int new_delta = -1, new_gamma = -1;
+    if (!epsilon && type_a != type_b) {
+        new_delta = par_new_node(par, w, &claims, IC_NODE_DELTA);
+        new_gamma = par_new_node(par, w, &claims, IC_NODE_GAMMA);
+    }
+    bool busy = (new_delta == -2 || new_gamma == -2);
+    bool no_gas = !busy && atomic_fetch_add(&par->gas, 1) >= net->gas_limit;
+    if (busy || no_gas) {
+        if (new_delta >= 0) par_release_node(par, w, new_delta);
+        if (new_gamma >= 0) par_release_node(par, w, new_gamma);
+        par_unclaim_all(par, &claims);
+        if (busy) return PAR_RETRY;
+
+        atomic_fetch_sub(&par->gas, 1);
+        atomic_store(&par->stop, true);
+        return PAR_NO_GAS;
+    }
+
+    if (epsilon) {
+        par_release_node(par, w, (type_a == IC_NODE_EPSILON) ? node_a : node_b);
+        PAR_STAT_INC(w, epsilon);
+    } else if (type_a == type_b) {
+        if (type_a == IC_NODE_DELTA) {
+            par_link(par, w, a1, b2);
+            par_link(par, w, a2, b1);
+            PAR_STAT_INC(w, delta_delta);
+        } else {
+            par_link(par, w, a1, b1);
+            par_link(par, w, a2, b2);
+            PAR_STAT_INC(w, gamma_gamma);
+        }
+        par_release_node(par, w, node_a);
+        par_release_node(par, w, node_b);
+    } else {
+        int delta_node = a_is_delta ? node_a : node_b;
+        int gamma_node = a_is_delta ? node_b : node_a;
+        ic_wire_t d1 = a_is_delta ? a1 : b1, d2 = a_is_delta ? a2 : b2;
+        ic_wire_t g1 = a_is_delta ? b1 : a1, g2 = a_is_delta ? b2 : a2;
+
+        if (new_delta == -1 || new_gamma == -1) {
+            // Out of space: like ic_net_reduce, keep the pair queued
+            if (new_delta != -1) par_release_node(par, w, new_delta);
+            if (new_gamma != -1) par_release_node(par, w, new_gamma);
+            par_push(par, w, delta_node, gamma_node, true, false);
+            PAR_STAT_INC(w, out_of_space);
+        } else {
+            par_link(par, w, IC_WIRE(new_delta, 0), IC_WIRE(new_gamma, 0));
+            par_link(par, w, IC_WIRE(new_delta, 1), d1);
+            par_link(par, w, IC_WIRE(new_delta, 2), g1);
+            par_link(par, w, IC_WIRE(new_gamma, 1), d2);
+            par_link(par, w, IC_WIRE(new_gamma, 2), g2);
+            par_release_node(par, w, delta_node);
+            par_release_node(par, w, gamma_node);
+        }
+        PAR_STAT_INC(w, delta_gamma);
+    }
+
+    par_unclaim_all(par, &claims);
+    return PAR_DONE;
+}
+
+/**
+ * Rewrite until no redex is pending or the gas runs out
+ */
+static void par_work(par_state_t *par, int id) {
+    par_worker_t *self = &par->workers[id];
+
+    while (!atomic_load_explicit(&par->stop, memory_order_relaxed)) {
+        ic_redex_t redex;
+        bool found = par_take(self, false, &redex);
+
+        // Steal round-robin, starting after our own deque
+        for (int k = 1; !found && k < par->num_workers; k++) {
+            found = par_take(&par->workers[(id + k) % par->num_workers], true, &redex);
+        }
+
+        if (!found) {
+            // Nothing queued and nothing being rewritten: normal form
+            if (atomic_load(&par->pending) == 0) break;
+            sched_yield();
+            continue;
+        }
+
+        par_outcome_t outcome = par_rewrite(par, self, redex.node_a, redex.node_b);
+        if (outcome == PAR_RETRY) {
+            // Still pending; let the holder finish first
+            par_push(par, self, redex.node_a, redex.node_b, false, true);
+            sched_yield();
+            continue;
+        }
+        atomic_fetch_sub(&par->pending, 1);
+    }
+}
+
+/**
+ * Deal the net's redexes round-robin over the deques, as
+ * ic_net_scan_for_redexes finds them
+ */
+static void par_scan(par_state_t *par) {
+    ic_net_t *net = par->net;
+    size_t used = atomic_load(&par->next_slot);
+    int next = 0;
+
+    for (size_t i = 0; i < used; i++) {
+        if (!net->active[i]) continue;
+
+        ic_wire_t conn = net->wires[3 * i];
+        if (conn == IC_WIRE_NONE) continue;
+
+        int conn_node = IC_WIRE_NODE(conn);
+        if (conn_node > (int)i && IC_WIRE_PORT(conn) == 0 &&
+            par_is_redex(net, (int)i, conn_node)) {
+            par_push(par, &par->workers[next], (int)i, conn_node, true, false);
+            next = (next + 1) % par->num_workers;
+        }
+    }
+}
+
+int ic_net_reduce_parallel(ic_net_t *net, int threads) {
+    if (!net) return 1;
+
+#ifdef _OPENMP
+    if (threads <= 0) threads = omp_get_max_threads();
+#else
+    threads = 1;
+#endif
+
+    par_state_t par;
+    par.net = net;
+    par.num_workers = threads;
+    par.claims = (atomic_uchar*)calloc(net->max_nodes > 0 ? net->max_nodes : 1,
+                                       sizeof(atomic_uchar));
+    par.workers = (par_worker_t*)calloc((size_t)threads, sizeof(par_worker_t));
+    bool allocated = par.claims && par.workers;
+    for (int t = 0; allocated && t < threads; t++) {
+        par_worker_t *w = &par.workers[t];
+        atomic_flag_clear(&w->lock);
+        w->items = (ic_redex_t*)malloc(PAR_DEQUE_INITIAL * sizeof(ic_redex_t));
+        w->capacity = PAR_DEQUE_INITIAL;
+        w->free_head = -1;
+        allocated = (w->items != NULL);
+    }
+    if (!allocated) {
+        for (int t = 0; par.workers && t < threads; t++) free(par.workers[t].items);
+        free(par.workers);
+        free(par.claims);
+        return -1;
+    }
+
+    // The net's spare slots go to the first worker
+    par.workers[0].free_head = net->free_head;
+    atomic_init(&par.next_slot, net->used_nodes);
+    atomic_init(&par.gas, 0);
+    atomic_init(&par.pending, 0);
+    atomic_init(&par.stop, false);
+    atomic_init(&par.dropped, false);
+
+    // Redexes a full deque dropped are found by another round's scan
+    do {
+        atomic_store(&par.dropped, false);
+        par_scan(&par);
+
+#ifdef _OPENMP
+        #pragma omp parallel num_threads(threads)
+        par_work(&par, omp_get_thread_num());
+#else
+        par_work(&par, 0);
+#endif
+    } while (atomic_load(&par.dropped) && !atomic_load(&par.stop));
+
+    net->used_nodes = atomic_load(&par.next_slot);
+    net->gas_used = atomic_load(&par.gas);
+    net->gas_skipped = 0;
+    net->reduce_suspended = false;
+
+    // Chain the workers' free lists back into the net's
+    int free_head = -1;
+    for (int t = threads - 1; t >= 0; t--) {
+        int head = par.workers[t].free_head;
+        if (head == -1) continue;
+
+        int tail = head;
+        while (net->wires[3 * (size_t)tail] != IC_WIRE_NONE) {
+            tail = (int)net->wires[3 * (size_t)tail];
+        }
+        net->wires[3 * (size_t)tail] = (free_head == -1) ? IC_WIRE_NONE : (ic_wire_t)free_head;
+        free_head = head;
+    }
+    net->free_head = free_head;
+
+    // Entries left by the gas limit are rescanned by the next reduction
+    net->redex_queue_size = 0;
+    net->redex_queue_start = 0;
+
+#ifdef IC_STATS
+    for (int t = 0; t < threads; t++) {
+        ic_stats_add(&net->stats, &par.workers[t].stats);
+    }
+    ic_stats_count_reduction(&net->stats, net->gas_used);
+#endif
+
+    for (int t = 0; t < threads; t++) free(par.workers[t].items);
+    free(par.workers);
+    free(par.claims);
+
+    return (net->gas_used < net->gas_limit) ? 0 : 1;
+}
@@ -0,0 +1,30 @@
+#ifndef IC_PARALLEL_H
+#define IC_PARALLEL_H
+
+#include <stddef.h>
+#include "ic_runtime.h"
+
+/**
+ * Reduce one net with several threads
+ * Every thread rewrites redexes from its own deque and steals the oldest
+ * entries of the others when it runs dry. Before a rewrite relinks any
+ * port it claims the pair and every node whose ports it writes with an
+ * atomic compare-and-swap; if another thread holds one of them it lets go
+ * of all and retries the redex later, so only rewrites of disjoint
+ * neighbourhoods run at once. Interaction combinator rules are local and
+ * strongly confluent, so a net that reaches normal form within its gas
+ * reaches the same one as ic_net_reduce, with the same gas_used, up to the
+ * numbering of node slots. A net stopped at the gas limit may stop in a
+ * different state. Redex order, loop checks, compaction, goals and
+ * input_number are not used. The slots the surviving nodes end up in
+ * depend on the thread schedule, and factors are slot positions, so
+ * ic_net_factor_pair on the result only tells whether a pair survived:
+ * its numbers are not ic_net_reduce's factors and may change from run to
+ * run. Reduce with ic_net_reduce to read factors.
+ * @param threads  Threads to use, 0 for the OpenMP default
+ * @return 0 if fully reduced, 1 if stopped due to gas limit, -1 if the
+ *         work arrays could not be allocated (the net is unchanged)
+ */
+int ic_net_reduce_parallel(ic_net_t *net, int threads);
+
+#endif // IC_PARALLEL_H
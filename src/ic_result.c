@@ -0,0 +1,143 @@
+#include "ic_result.h"
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+int ic_result_write(const char *path, const ic_result_record_t *record) {
+    if (!path || !record) return -1;
+    
+    FILE *out = fopen(path, "w");
+    if (!out) return -1;
+    
+    fprintf(out, "icsearch-result 1\n");
+    fprintf(out, "max_nodes %zu\n", record->max_nodes);
+    fprintf(out, "gas_limit %zu\n", record->gas_limit);
+    fprintf(out, "range %" PRIu64 " %" PRIu64 "\n", record->range_start, record->range_end);
+    for (size_t i = 0; i < record->count; i++) {
+        const ic_batch_result_t *r = &record->results[i];
+        fprintf(out, "target %d %" PRId64 " %d %d\n", record->Ns[i], r->solution_index,
+                r->factor_a, r->factor_b);
+    }
+    
+    return fclose(out) == 0 ? 0 : -1;
+}
+
+int ic_result_read(const char *path, ic_result_record_t *record) {
+    if (!path || !record) return -1;
+    memset(record, 0, sizeof(*record));
+    
+    FILE *in = fopen(path, "r");
+    if (!in) return -1;
+    
+    int version = 0;
+    if (fscanf(in, "icsearch-result %d max_nodes %zu gas_limit %zu range %" SCNu64 " %" SCNu64,
+               &version, &record->max_nodes, &record->gas_limit,
+               &record->range_start, &record->range_end) != 5 || version != 1) {
+        fclose(in);
+        return -1;
+    }
+    
+    size_t capacity = 0;
+    int N, factor_a, factor_b;
+    int64_t solution;
+    while (fscanf(in, " target %d %" SCNd64 " %d %d", &N, &solution, &factor_a, &factor_b) == 4) {
+        if (record->count == capacity) {
+            capacity = capacity ? capacity * 2 : 8;
+            int *Ns = (int*)realloc(record->Ns, capacity * sizeof(int));
+            if (Ns) record->Ns = Ns;
+            ic_batch_result_t *results = (ic_batch_result_t*)realloc(record->results,
+                                                                     capacity * sizeof(ic_batch_result_t));
+            if (results) record->results = results;
+            if (!Ns || !results) {
+                fclose(in);
+                ic_result_free(record);
+                return -1;
+            }
+        }
+        
+        record->Ns[record->count] = N;
+        record->results[record->count].solution_index = solution;
+        record->results[record->count].factor_a = factor_a;
+        record->results[record->count].factor_b = factor_b;
+        record->count++;
+    }
+    
+    fclose(in);
+    return 0;
+}
+
+void ic_result_free(ic_result_record_t *record) {
+    if (!record) return;
+    free(record->Ns);
+    free(record->results);
+    record->Ns = NULL;
+    record->results = NULL;
+    record->count = 0;
+}
+
+static int ic_range_compare(const void *a, const void *b) {
+    uint64_t sa = (*(const ic_result_record_t * const *)a)->range_start;
+    uint64_t sb = (*(const ic_result_record_t * const *)b)->range_start;
+    return (sa > sb) - (sa < sb);
+}
+
+int ic_result_merge(const ic_result_record_t *records, size_t count, ic_result_record_t *merged) {
+    if (!records || count == 0 || !merged) return -1;
+    memset(merged, 0, sizeof(*merged));
+    
+    // Every shard must have searched for the same numbers the same way
+    const ic_result_record_t *first = &records[0];
+    for (size_t r = 1; r < count; r++) {
+        const ic_result_record_t *other = &records[r];
+        if (other->max_nodes != first->max_nodes || other->gas_limit != first->gas_limit ||
+            other->count != first->count ||
+            memcmp(other->Ns, first->Ns, first->count * sizeof(int)) != 0) {
+            return -1;
+        }
+    }
+    
+    // Walk the ranges in order to find the gap-free prefix of the index space
+    const ic_result_record_t **sorted = (const ic_result_record_t**)malloc(count * sizeof(*sorted));
+    merged->Ns = (int*)malloc((first->count ? first->count : 1) * sizeof(int));
+    merged->results = (ic_batch_result_t*)malloc((first->count ? first->count : 1) *
+                                                 sizeof(ic_batch_result_t));
+    if (!sorted || !merged->Ns || !merged->results) {
+        free(sorted);
+        ic_result_free(merged);
+        return -1;
+    }
+    
+    for (size_t r = 0; r < count; r++) {
+        sorted[r] = &records[r];
+    }
+    qsort(sorted, count, sizeof(*sorted), ic_range_compare);
+    
+    uint64_t covered = 0;
+    for (size_t r = 0; r < count && sorted[r]->range_start <= covered; r++) {
+        if (sorted[r]->range_end > covered) covered = sorted[r]->range_end;
+    }
+    free(sorted);
+    
+    merged->max_nodes = first->max_nodes;
+    merged->gas_limit = first->gas_limit;
+    merged->range_start = 0;
+    merged->range_end = covered;
+    merged->count = first->count;
+    memcpy(merged->Ns, first->Ns, first->count * sizeof(int));
+    
+    // Each number's answer is its smallest solution over all shards
+    for (size_t i = 0; i < first->count; i++) {
+        ic_batch_result_t best = { .solution_index = -1, .factor_a = 0, .factor_b = 0 };
+        for (size_t r = 0; r < count; r++) {
+            const ic_batch_result_t *candidate = &records[r].results[i];
+            if (candidate->solution_index >= 0 &&
+                (best.solution_index < 0 || candidate->solution_index < best.solution_index)) {
+                best = *candidate;
+            }
+        }
+        merged->results[i] = best;
+    }
+    
+    return 0;
+}
@@ -0,0 +1,49 @@
+#ifndef IC_RESULT_H
+#define IC_RESULT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "ic_search.h"
+
+/**
+ * Result of a search over one index range, as written by a shard
+ * Records from shards of the same search (same max_nodes, gas_limit and
+ * numbers) are merged by taking each number's smallest solution index.
+ */
+typedef struct {
+    size_t max_nodes;
+    size_t gas_limit;
+    uint64_t range_start;         // Indices range_start..range_end-1 were searched
+    uint64_t range_end;
+    size_t count;                 // Numbers searched for
+    int *Ns;
+    ic_batch_result_t *results;   // results[i] is the outcome for Ns[i]
+} ic_result_record_t;
+
+/**
+ * Write a result record as a small text file
+ * @return 0 on success, -1 on error
+ */
+int ic_result_write(const char *path, const ic_result_record_t *record);
+
+/**
+ * Read a result record; the arrays are allocated and freed by ic_result_free
+ * @return 0 on success, -1 if missing or malformed
+ */
+int ic_result_read(const char *path, ic_result_record_t *record);
+
+/**
+ * Free the arrays of a record filled by ic_result_read or ic_result_merge
+ */
+void ic_result_free(ic_result_record_t *record);
+
+/**
+ * Merge shard records into one covering 0..range_end-1
+ * merged->range_end is where the shards stop covering the index space
+ * without a gap, so a solution below it is the same as a single-node run
+ * would find. Solutions at or beyond it are kept but may not be smallest.
+ * @return 0 on success, -1 if the records come from different searches
+ */
+int ic_result_merge(const ic_result_record_t *records, size_t count, ic_result_record_t *merged);
+
+#endif // IC_RESULT_H
@@ -0,0 +1,171 @@
+/*
+ * Rewrite rules shared by ic_net_reduce (ic_runtime.c) and the
+ * fixed-capacity reducers (ic_fixed_impl.h). The includer says how to
+ * reach the net's storage and how nodes are allocated and redexes queued;
+ * the rules themselves exist only here, so both reducers rewrite every
+ * net identically by construction.
+ *
+ * Define before including:
+ *   IC_RULES_T                 reducer type, passed by pointer
+ *   IC_RULES_FN(name)          name of each generated function
+ *   IC_RULES_NET(r)            the ic_net_t header of r
+ *   IC_RULES_WIRES(r)          r's wire array
+ *   IC_RULES_TYPES(r)          r's node type array
+ *   IC_RULES_ACTIVE(r)         r's liveness array
+ *   IC_RULES_NEW_NODE(r, t)    allocate a node of type t, -1 if out of slots
+ *   IC_RULES_ADD_REDEX(r, a, b) queue a possible redex
+ *   IC_RULES_ABORTED(r)        true once the rewrite must stop half done
+ *   IC_RULES_COUNT(r, field)   count a completed rule in the statistics
+ *   IC_RULES_TRACE(r, rule, a, b) trace a completed rule
+ *
+ * Generates slot, release_node, link and interact, all static inline.
+ */
+
+#if !defined(IC_RULES_T) || !defined(IC_RULES_FN)
+#error "define IC_RULES_T and IC_RULES_FN before including ic_rules_impl.h"
+#endif
+
+/**
+ * Storage slot of a packed wire reference inside the wire array
+ */
+static inline ic_wire_t *IC_RULES_FN(slot)(IC_RULES_T *r, ic_wire_t wire) {
+    return &IC_RULES_WIRES(r)[3 * (size_t)IC_WIRE_NODE(wire) + IC_WIRE_PORT(wire)];
+}
+
+/**
+ * Erase a node and, with slot reuse on, push its slot onto the free list
+ * Any port still wired to the node is disconnected first, so a later
+ * reuse of the slot cannot be mistaken for the old connection. While the
+ * slot is free, its principal wire holds the index of the next free slot.
+ */
+static inline void IC_RULES_FN(release_node)(IC_RULES_T *r, int idx) {
+    ic_net_t *net = IC_RULES_NET(r);
+    ic_wire_t *ports = &IC_RULES_WIRES(r)[3 * (size_t)idx];
+
+    for (int p = 0; p < 3; p++) {
+        ic_wire_t peer = ports[p];
+        if (peer != IC_WIRE_NONE && *IC_RULES_FN(slot)(r, peer) == IC_WIRE(idx, p)) {
+            *IC_RULES_FN(slot)(r, peer) = IC_WIRE_NONE;
+        }
+    }
+
+    IC_RULES_ACTIVE(r)[idx] = 0;
+    ports[1] = ports[2] = IC_WIRE_NONE;
+    if (!net->reuse_slots) {
+        ports[0] = IC_WIRE_NONE;
+        return;
+    }
+    ports[0] = (net->free_head == -1) ? IC_WIRE_NONE : (ic_wire_t)net->free_head;
+    net->free_head = idx;
+}
+
+/**
+ * Join two ports, either of which may be IC_WIRE_NONE (the other side is
+ * then left unconnected). The ports' previous peers are not touched: rules
+ * only link ports whose old peers are being erased anyway.
+ */
+static inline void IC_RULES_FN(link)(IC_RULES_T *r, ic_wire_t a, ic_wire_t b) {
+    if (a != IC_WIRE_NONE) *IC_RULES_FN(slot)(r, a) = b;
+    if (b != IC_WIRE_NONE) *IC_RULES_FN(slot)(r, b) = a;
+
+    // Joining two principal ports creates a redex
+    if (a != IC_WIRE_NONE && b != IC_WIRE_NONE &&
+        IC_WIRE_PORT(a) == 0 && IC_WIRE_PORT(b) == 0) {
+        IC_RULES_ADD_REDEX(r, IC_WIRE_NODE(a), IC_WIRE_NODE(b));
+    }
+}
+
+/**
+ * Rewrite the active pair of two live nodes
+ * δδ annihilates and joins the auxiliary peers crosswise (aux1 to aux2),
+ * γγ annihilates and joins them straight, δγ is replaced by a fresh δγ
+ * pair joined at their principal ports that takes over the four peers,
+ * and ε erases the node it meets. A δγ pair without two free slots stays
+ * and is queued again, so it is retried.
+ */
+static inline void IC_RULES_FN(interact)(IC_RULES_T *r, int node_a, int node_b) {
+    ic_node_type_t type_a = (ic_node_type_t)IC_RULES_TYPES(r)[node_a];
+    ic_node_type_t type_b = (ic_node_type_t)IC_RULES_TYPES(r)[node_b];
+
+    if (type_a == IC_NODE_EPSILON || type_b == IC_NODE_EPSILON) {
+        int epsilon_node = (type_a == IC_NODE_EPSILON) ? node_a : node_b;
+        int other_node = (type_a == IC_NODE_EPSILON) ? node_b : node_a;
+        (void)other_node;
+
+        // The principal link to other_node is cut, its aux ports are left alone
+        IC_RULES_FN(release_node)(r, epsilon_node);
+        IC_RULES_COUNT(r, epsilon);
+        IC_RULES_TRACE(r, IC_TRACE_EPSILON, epsilon_node, other_node);
+        return;
+    }
+
+    const ic_wire_t *ports_a = &IC_RULES_WIRES(r)[3 * (size_t)node_a];
+    const ic_wire_t *ports_b = &IC_RULES_WIRES(r)[3 * (size_t)node_b];
+    ic_wire_t a1 = ports_a[1], a2 = ports_a[2];
+    ic_wire_t b1 = ports_b[1], b2 = ports_b[2];
+
+    if (type_a == type_b) {
+        if (type_a == IC_NODE_DELTA) {
+            IC_RULES_FN(link)(r, a1, b2);
+            IC_RULES_FN(link)(r, a2, b1);
+        } else {
+            IC_RULES_FN(link)(r, a1, b1);
+            IC_RULES_FN(link)(r, a2, b2);
+        }
+        IC_RULES_FN(release_node)(r, node_a);
+        IC_RULES_FN(release_node)(r, node_b);
+        if (type_a == IC_NODE_DELTA) {
+            IC_RULES_COUNT(r, delta_delta);
+            IC_RULES_TRACE(r, IC_TRACE_DELTA_DELTA, node_a, node_b);
+        } else {
+            IC_RULES_COUNT(r, gamma_gamma);
+            IC_RULES_TRACE(r, IC_TRACE_GAMMA_GAMMA, node_a, node_b);
+        }
+        return;
+    }
+
+    // δγ: d1/d2 are the δ's auxiliary peers, g1/g2 the γ's, saved before
+    // any slot is reused
+    bool a_is_delta = (type_a == IC_NODE_DELTA);
+    int delta_node = a_is_delta ? node_a : node_b;
+    int gamma_node = a_is_delta ? node_b : node_a;
+    ic_wire_t d1 = a_is_delta ? a1 : b1, d2 = a_is_delta ? a2 : b2;
+    ic_wire_t g1 = a_is_delta ? b1 : a1, g2 = a_is_delta ? b2 : a2;
+
+    int new_delta = IC_RULES_NEW_NODE(r, IC_NODE_DELTA);
+    int new_gamma = IC_RULES_NEW_NODE(r, IC_NODE_GAMMA);
+    if (IC_RULES_ABORTED(r)) return;
+
+    if (new_delta == -1 || new_gamma == -1) {
+        if (new_delta != -1) IC_RULES_FN(release_node)(r, new_delta);
+        if (new_gamma != -1) IC_RULES_FN(release_node)(r, new_gamma);
+        IC_RULES_ADD_REDEX(r, delta_node, gamma_node);
+        IC_RULES_COUNT(r, out_of_space);
+        IC_RULES_COUNT(r, delta_gamma);
+        IC_RULES_TRACE(r, IC_TRACE_DELTA_GAMMA, delta_node, gamma_node);
+        return;
+    }
+
+    IC_RULES_FN(link)(r, IC_WIRE(new_delta, 0), IC_WIRE(new_gamma, 0));
+    IC_RULES_FN(link)(r, IC_WIRE(new_delta, 1), d1);
+    IC_RULES_FN(link)(r, IC_WIRE(new_delta, 2), g1);
+    IC_RULES_FN(link)(r, IC_WIRE(new_gamma, 1), d2);
+    IC_RULES_FN(link)(r, IC_WIRE(new_gamma, 2), g2);
+
+    IC_RULES_FN(release_node)(r, delta_node);
+    IC_RULES_FN(release_node)(r, gamma_node);
+    IC_RULES_COUNT(r, delta_gamma);
+    IC_RULES_TRACE(r, IC_TRACE_DELTA_GAMMA, delta_node, gamma_node);
+}
+
+#undef IC_RULES_TRACE
+#undef IC_RULES_COUNT
+#undef IC_RULES_ABORTED
+#undef IC_RULES_ADD_REDEX
+#undef IC_RULES_NEW_NODE
+#undef IC_RULES_ACTIVE
+#undef IC_RULES_TYPES
+#undef IC_RULES_WIRES
+#undef IC_RULES_NET
+#undef IC_RULES_FN
+#undef IC_RULES_T
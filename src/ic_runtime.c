@@ -1,403 +1,505 @@
 #include "ic_runtime.h"
+#include "ic_trace.h"
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
 
+// Number of heap allocations made by the runtime since program start
+static size_t ic_alloc_counter = 0;
+
+/**
+ * Record one heap allocation made on behalf of a net
+ */
+static void ic_count_alloc(void) {
+    #pragma omp atomic
+    ic_alloc_counter++;
+}
+
+size_t ic_net_alloc_count(void) {
+    size_t count;
+    #pragma omp atomic read
+    count = ic_alloc_counter;
+    return count;
+}
+
+size_t ic_net_storage_bytes(const ic_net_t *net) {
+    if (!net || net->borrowed_storage) return 0;
+
+    // ic_net_create bounds max_nodes, so this cannot overflow
+    return 3 * net->max_nodes * sizeof(ic_wire_t) + 2 * net->max_nodes;
+}
+
 ic_net_t *ic_net_create(size_t max_nodes, size_t gas_limit) {
+    // Larger nets could not be addressed, and their size would overflow
+    if (max_nodes > IC_NET_MAX_NODES) return NULL;
+
     ic_net_t *net = (ic_net_t*)malloc(sizeof(ic_net_t));
     if (!net) return NULL;
+    ic_count_alloc();
 
-    net->nodes = (ic_node_t*)calloc(max_nodes, sizeof(ic_node_t));
-    if (!net->nodes) {
+    // Wires, types and liveness share one block: wires first, then one
+    // byte per node for each of the two byte arrays
+    size_t wire_bytes = 3 * max_nodes * sizeof(ic_wire_t);
+    unsigned char *block = (unsigned char*)calloc(1, wire_bytes + 2 * max_nodes);
+    if (!block) {
         free(net);
         return NULL;
     }
+    ic_count_alloc();
+    net->wires = (ic_wire_t*)block;
+    net->types = (uint8_t*)(block + wire_bytes);
+    net->active = net->types + max_nodes;
+
+    // The redex queue lives outside the struct so it can grow on demand
+    net->redex_queue = (ic_redex_t*)malloc(IC_REDEX_QUEUE_INITIAL * sizeof(ic_redex_t));
+    if (!net->redex_queue) {
+        free(block);
+        free(net);
+        return NULL;
+    }
+    ic_count_alloc();
 
     net->max_nodes = max_nodes;
     net->used_nodes = 0;
+    net->free_head = -1;
+    net->reuse_slots = false;
     net->gas_limit = gas_limit;
     net->gas_used = 0;
+    net->loop_check_interval = 0;
+    net->gas_skipped = 0;
+    memset(&net->loop_state, 0, sizeof(net->loop_state));
+    net->compact_live_percent = 0;
+    net->reduce_suspended = false;
     
     // Initialize redex queue
+    net->redex_queue_capacity = IC_REDEX_QUEUE_INITIAL;
     net->redex_queue_size = 0;
     net->redex_queue_start = 0;
+    net->redex_order = IC_REDEX_FIFO;
+    net->redex_rescan_needed = false;
+    net->borrowed_storage = false;
     
+    net->goal = NULL;
     net->input_number = 0;
     net->factor_a = 0;
     net->factor_b = 0;
     net->factor_found = false;
+    
+#ifdef IC_STATS
+    memset(&net->stats, 0, sizeof(net->stats));
+#endif
 
     return net;
 }
 
-void ic_net_free(ic_net_t *net) {
-    if (net) {
-        free(net->nodes);
-        free(net);
-    }
+void ic_net_reset(ic_net_t *net) {
+    if (!net) return;
+
+    // Node slots are re-initialized by ic_net_new_node, so nothing is zeroed
+    net->used_nodes = 0;
+    net->free_head = -1;
+    net->gas_used = 0;
+    net->gas_skipped = 0;
+    net->redex_queue_size = 0;
+    net->redex_queue_start = 0;
+    net->redex_rescan_needed = false;
+    net->reduce_suspended = false;
+
+    net->factor_a = 0;
+    net->factor_b = 0;
+    net->factor_found = false;
 }
 
-int ic_net_new_node(ic_net_t *net, ic_node_type_t type) {
-    if (!net || net->used_nodes >= net->max_nodes) {
-        return -1;
-    }
+void ic_net_set_redex_order(ic_net_t *net, ic_redex_order_t order) {
+    if (!net) return;
+    net->redex_order = order;
+}
 
-    int idx = net->used_nodes++;
-    
-    // Initialize the new node
-    net->nodes[idx].type = type;
-    net->nodes[idx].is_active = true;
-    
-    // Initialize all ports as unconnected
-    for (int i = 0; i < 3; i++) {
-        net->nodes[idx].ports[i].connected_node = -1;
-        net->nodes[idx].ports[i].connected_port = -1;
+void ic_net_set_slot_reuse(ic_net_t *net, bool reuse) {
+    if (!net) return;
+    net->reuse_slots = reuse;
+}
+
+void ic_net_set_goal(ic_net_t *net, const ic_goal_t *goal) {
+    if (!net) return;
+    net->goal = goal;
+}
+
+void ic_net_set_loop_check(ic_net_t *net, size_t interval) {
+    if (!net) return;
+    net->loop_check_interval = interval;
+
+    // A failure here only defers the allocation to the first saved sample
+    if (interval > 0 && !net->borrowed_storage) {
+        ic_net_reserve_loop_state(net, net->max_nodes, net->redex_queue_capacity);
     }
-    
-    return idx;
+}
+
+int ic_net_reserve_loop_state(ic_net_t *net, size_t slots, size_t queued) {
+    ic_loop_state_t *state = &net->loop_state;
+    if (slots <= state->slots && queued <= state->queue_slots) return 0;
+    if (net->borrowed_storage) return -1;
+
+    if (slots < state->slots) slots = state->slots;
+    if (queued < state->queue_slots) queued = state->queue_slots;
+    if (slots > IC_NET_MAX_NODES || queued > SIZE_MAX / 2 / sizeof(ic_redex_t)) return -1;
+
+    // Wires, then the queue, then the types, in one block
+    size_t wire_bytes = 3 * slots * sizeof(ic_wire_t);
+    size_t queue_bytes = queued * sizeof(ic_redex_t);
+    unsigned char *block = (unsigned char*)malloc(wire_bytes + queue_bytes + slots);
+    if (!block) return -1;
+    ic_count_alloc();
+
+    free(state->wires);
+    state->wires = (ic_wire_t*)block;
+    state->queue = (ic_redex_t*)(block + wire_bytes);
+    state->types = block + wire_bytes + queue_bytes;
+    state->slots = slots;
+    state->queue_slots = queued;
+    return 0;
 }
 
 /**
- * Add a potential redex to the queue
+ * Copy the net's reduction state into net->loop_state
+ * @return 0 on success, -1 if there is no room for it
  */
-static void ic_net_add_redex(ic_net_t *net, int node_a, int node_b) {
-    // Skip if either node is inactive
-    if (!net->nodes[node_a].is_active || !net->nodes[node_b].is_active) {
-        return;
+static int ic_loop_state_save(ic_net_t *net) {
+    if (ic_net_reserve_loop_state(net, net->used_nodes, net->redex_queue_size) != 0) return -1;
+
+    ic_loop_state_t *state = &net->loop_state;
+    state->used_nodes = net->used_nodes;
+    state->queued = net->redex_queue_size;
+    state->free_head = net->free_head;
+    state->order = (uint8_t)(((unsigned)net->redex_order << 1) | net->redex_rescan_needed);
+    memcpy(state->wires, net->wires, 3 * net->used_nodes * sizeof(ic_wire_t));
+    for (size_t i = 0; i < net->used_nodes; i++) {
+        state->types[i] = net->active[i] ? (uint8_t)(net->types[i] + 1) : 0;
     }
-    
-    // Only add if both nodes are connected via principal ports
-    if (net->nodes[node_a].ports[0].connected_node == node_b && 
-        net->nodes[node_a].ports[0].connected_port == 0 &&
-        net->nodes[node_b].ports[0].connected_node == node_a &&
-        net->nodes[node_b].ports[0].connected_port == 0) {
-        
-        // Check if redex queue is full
-        if (net->redex_queue_size >= MAX_REDEX_QUEUE) {
-            return;
-        }
-        
-        // Calculate the insertion position
-        size_t pos = (net->redex_queue_start + net->redex_queue_size) % MAX_REDEX_QUEUE;
-        
-        // Add to queue
-        net->redex_queue[pos].node_a = node_a;
-        net->redex_queue[pos].node_b = node_b;
-        net->redex_queue_size++;
+    size_t mask = net->redex_queue_capacity - 1;
+    for (size_t i = 0; i < net->redex_queue_size; i++) {
+        state->queue[i] = net->redex_queue[(net->redex_queue_start + i) & mask];
     }
+    return 0;
 }
 
 /**
- * Get and remove the next redex from the queue
- * @return true if a redex was retrieved, false if the queue is empty
+ * Whether the net is in exactly the state net->loop_state holds
  */
-static bool ic_net_get_next_redex(ic_net_t *net, int *node_a, int *node_b) {
-    if (net->redex_queue_size == 0) {
+static bool ic_loop_state_matches(const ic_net_t *net) {
+    const ic_loop_state_t *state = &net->loop_state;
+    if (state->used_nodes != net->used_nodes || state->queued != net->redex_queue_size ||
+        state->free_head != net->free_head ||
+        state->order != (((unsigned)net->redex_order << 1) | net->redex_rescan_needed)) {
         return false;
     }
-    
-    // Get redex from the front of the queue
-    *node_a = net->redex_queue[net->redex_queue_start].node_a;
-    *node_b = net->redex_queue[net->redex_queue_start].node_b;
-    
-    // Move to the next position
-    net->redex_queue_start = (net->redex_queue_start + 1) % MAX_REDEX_QUEUE;
-    net->redex_queue_size--;
-    
-    // Check if the redex is still valid (both nodes active and connected)
-    if (!net->nodes[*node_a].is_active || !net->nodes[*node_b].is_active ||
-        net->nodes[*node_a].ports[0].connected_node != *node_b ||
-        net->nodes[*node_a].ports[0].connected_port != 0 ||
-        net->nodes[*node_b].ports[0].connected_node != *node_a ||
-        net->nodes[*node_b].ports[0].connected_port != 0) {
-        return false;
+    if (memcmp(state->wires, net->wires, 3 * net->used_nodes * sizeof(ic_wire_t)) != 0) return false;
+    for (size_t i = 0; i < net->used_nodes; i++) {
+        if (state->types[i] != (net->active[i] ? net->types[i] + 1 : 0)) return false;
+    }
+    size_t mask = net->redex_queue_capacity - 1;
+    for (size_t i = 0; i < net->redex_queue_size; i++) {
+        const ic_redex_t *redex = &net->redex_queue[(net->redex_queue_start + i) & mask];
+        if (state->queue[i].node_a != redex->node_a || state->queue[i].node_b != redex->node_b) {
+            return false;
+        }
     }
-    
     return true;
 }
 
-void ic_net_connect(ic_net_t *net, int node_a, int port_a, int node_b, int port_b) {
-    // Validate indices
-    if (!net || 
-        node_a < 0 || node_a >= (int)net->used_nodes || 
-        node_b < 0 || node_b >= (int)net->used_nodes ||
-        port_a < 0 || port_a >= 3 ||
-        port_b < 0 || port_b >= 3) {
-        return;
-    }
-    
-    // Disconnect any existing connections for port_a
-    if (net->nodes[node_a].ports[port_a].connected_node != -1) {
-        int old_node = net->nodes[node_a].ports[port_a].connected_node;
-        int old_port = net->nodes[node_a].ports[port_a].connected_port;
-        
-        if (old_node >= 0 && old_node < (int)net->used_nodes && 
-            old_port >= 0 && old_port < 3) {
-            net->nodes[old_node].ports[old_port].connected_node = -1;
-            net->nodes[old_node].ports[old_port].connected_port = -1;
-        }
+void ic_net_set_compaction(ic_net_t *net, unsigned live_percent) {
+    if (!net) return;
+    net->compact_live_percent = live_percent;
+}
+
+void ic_loop_detector_init(ic_loop_detector_t *detector, const ic_net_t *net) {
+    size_t interval = net->loop_check_interval;
+    detector->next_sample = (interval > 0) ? interval : SIZE_MAX;
+    detector->saved = 0;
+    detector->power = 1;
+    detector->length = 0;
+    detector->has_saved = false;
+    detector->found = false;
+}
+
+bool ic_loop_detector_sample(ic_loop_detector_t *detector, ic_net_t *net) {
+    uint64_t hash = ic_net_state_hash(net);
+    detector->next_sample += net->loop_check_interval;
+    
+    if (detector->has_saved && hash == detector->saved && ic_loop_state_matches(net)) {
+        // Skip every whole period that fits before the gas limit
+        size_t period = detector->length * net->loop_check_interval;
+        size_t remaining = net->gas_limit - net->gas_used;
+        size_t skip = remaining - remaining % period;
+        net->gas_used += skip;
+        net->gas_skipped += skip;
+        detector->found = true;
+        detector->next_sample = SIZE_MAX;
+        return true;
     }
     
-    // Disconnect any existing connections for port_b
-    if (net->nodes[node_b].ports[port_b].connected_node != -1) {
-        int old_node = net->nodes[node_b].ports[port_b].connected_node;
-        int old_port = net->nodes[node_b].ports[port_b].connected_port;
-        
-        if (old_node >= 0 && old_node < (int)net->used_nodes && 
-            old_port >= 0 && old_port < 3) {
-            net->nodes[old_node].ports[old_port].connected_node = -1;
-            net->nodes[old_node].ports[old_port].connected_port = -1;
-        }
+    // Brent: move the saved state forward after 1, 2, 4, ... samples, so
+    // it eventually sits inside the loop with a window longer than the period
+    if (!detector->has_saved || detector->length == detector->power) {
+        if (detector->has_saved) detector->power *= 2;
+        detector->saved = hash;
+        detector->has_saved = ic_loop_state_save(net) == 0;
+        detector->length = 0;
     }
-    
-    // Connect the two ports
-    net->nodes[node_a].ports[port_a].connected_node = node_b;
-    net->nodes[node_a].ports[port_a].connected_port = port_b;
-    net->nodes[node_b].ports[port_b].connected_node = node_a;
-    net->nodes[node_b].ports[port_b].connected_port = port_a;
-    
-    // Check if we've formed an active pair (both principal ports)
-    if (port_a == 0 && port_b == 0 && 
-        net->nodes[node_a].is_active && net->nodes[node_b].is_active) {
-        ic_net_add_redex(net, node_a, node_b);
+    detector->length++;
+    return false;
+}
+
+void ic_net_free(ic_net_t *net) {
+    if (net && !net->borrowed_storage) {
+        free(net->loop_state.wires);  // Also holds its queue and types
+        free(net->redex_queue);
+        free(net->wires);  // Also holds the types and active arrays
+        free(net);
     }
 }
 
-/**
- * Apply the rewrite rule for delta-delta interaction
- */
-static void ic_apply_delta_delta(ic_net_t *net, int node1, int node2) {
-    // Store connections to auxiliary ports
-    int conn1_aux1_node = net->nodes[node1].ports[1].connected_node;
-    int conn1_aux1_port = net->nodes[node1].ports[1].connected_port;
-    
-    int conn1_aux2_node = net->nodes[node1].ports[2].connected_node;
-    int conn1_aux2_port = net->nodes[node1].ports[2].connected_port;
-    
-    int conn2_aux1_node = net->nodes[node2].ports[1].connected_node;
-    int conn2_aux1_port = net->nodes[node2].ports[1].connected_port;
+int ic_net_new_node(ic_net_t *net, ic_node_type_t type) {
+    if (!net) return -1;
+    
+    int idx;
+    if (net->free_head != -1) {
+        // Reuse the most recently released slot
+        idx = net->free_head;
+        ic_wire_t next = net->wires[3 * (size_t)idx];
+        net->free_head = (next == IC_WIRE_NONE) ? -1 : (int)next;
+    } else if (net->used_nodes < net->max_nodes) {
+        idx = net->used_nodes++;
+    } else {
+        return -1;
+    }
     
-    int conn2_aux2_node = net->nodes[node2].ports[2].connected_node;
-    int conn2_aux2_port = net->nodes[node2].ports[2].connected_port;
+    // Initialize the new node
+    net->types[idx] = (uint8_t)type;
+    net->active[idx] = 1;
     
-    // Disconnect all connections
-    // First disconnect the principal ports since they are connected to each other
-    net->nodes[node1].ports[0].connected_node = -1;
-    net->nodes[node1].ports[0].connected_port = -1;
-    net->nodes[node2].ports[0].connected_node = -1;
-    net->nodes[node2].ports[0].connected_port = -1;
+    // Initialize all ports as unconnected
+    ic_wire_t *ports = &net->wires[3 * (size_t)idx];
+    ports[0] = ports[1] = ports[2] = IC_WIRE_NONE;
     
-    // Now disconnect the aux ports
-    if (conn1_aux1_node >= 0) {
-        net->nodes[conn1_aux1_node].ports[conn1_aux1_port].connected_node = -1;
-        net->nodes[conn1_aux1_node].ports[conn1_aux1_port].connected_port = -1;
-        net->nodes[node1].ports[1].connected_node = -1;
-        net->nodes[node1].ports[1].connected_port = -1;
-    }
+    return idx;
+}
+
+size_t ic_net_compact(ic_net_t *net) {
+    if (!net || net->used_nodes == 0) return 0;
     
-    if (conn1_aux2_node >= 0) {
-        net->nodes[conn1_aux2_node].ports[conn1_aux2_port].connected_node = -1;
-        net->nodes[conn1_aux2_node].ports[conn1_aux2_port].connected_port = -1;
-        net->nodes[node1].ports[2].connected_node = -1;
-        net->nodes[node1].ports[2].connected_port = -1;
+    size_t used = net->used_nodes;
+    size_t live = 0;
+    for (size_t i = 0; i < used; i++) {
+        live += net->active[i];
     }
+    if (live == used) return 0;
     
-    if (conn2_aux1_node >= 0) {
-        net->nodes[conn2_aux1_node].ports[conn2_aux1_port].connected_node = -1;
-        net->nodes[conn2_aux1_node].ports[conn2_aux1_port].connected_port = -1;
-        net->nodes[node2].ports[1].connected_node = -1;
-        net->nodes[node2].ports[1].connected_port = -1;
-    }
+    // New index of every slot, UINT32_MAX for erased ones
+    uint32_t *map = (uint32_t*)malloc(used * sizeof(uint32_t));
+    if (!map) return 0;
+    ic_count_alloc();
     
-    if (conn2_aux2_node >= 0) {
-        net->nodes[conn2_aux2_node].ports[conn2_aux2_port].connected_node = -1;
-        net->nodes[conn2_aux2_node].ports[conn2_aux2_port].connected_port = -1;
-        net->nodes[node2].ports[2].connected_node = -1;
-        net->nodes[node2].ports[2].connected_port = -1;
+    uint32_t next = 0;
+    for (size_t i = 0; i < used; i++) {
+        map[i] = net->active[i] ? next++ : UINT32_MAX;
     }
     
-    // Connect crosswise (aux1 to aux2 and aux2 to aux1)
-    if (conn1_aux1_node >= 0 && conn2_aux2_node >= 0) {
-        ic_net_connect(net, conn1_aux1_node, conn1_aux1_port, conn2_aux2_node, conn2_aux2_port);
+    // Live nodes only move down, so one forward pass can move them in place
+    size_t moves = 0;
+    for (size_t i = 0; i < used; i++) {
+        if (map[i] == UINT32_MAX) continue;
+        
+        size_t to = map[i];
+        for (int p = 0; p < 3; p++) {
+            ic_wire_t peer = net->wires[3 * i + p];
+            uint32_t peer_node = (peer == IC_WIRE_NONE) ? UINT32_MAX :
+                                 ((size_t)IC_WIRE_NODE(peer) < used ? map[IC_WIRE_NODE(peer)] : UINT32_MAX);
+            net->wires[3 * to + p] = (peer_node == UINT32_MAX) ? IC_WIRE_NONE :
+                                     IC_WIRE(peer_node, IC_WIRE_PORT(peer));
+        }
+        if (to != i) {
+            net->types[to] = net->types[i];
+            net->active[to] = 1;
+            moves++;
+        }
     }
-    
-    if (conn1_aux2_node >= 0 && conn2_aux1_node >= 0) {
-        ic_net_connect(net, conn1_aux2_node, conn1_aux2_port, conn2_aux1_node, conn2_aux1_port);
+    for (size_t i = live; i < used; i++) {
+        net->active[i] = 0;
     }
+    net->used_nodes = live;
+    net->free_head = -1;
     
-    // Mark nodes as inactive
-    net->nodes[node1].is_active = false;
-    net->nodes[node2].is_active = false;
+    // Renumber the queued redexes in order; entries on erased nodes are stale anyway
+    size_t mask = net->redex_queue_capacity - 1;
+    size_t kept = 0;
+    for (size_t i = 0; i < net->redex_queue_size; i++) {
+        ic_redex_t redex = net->redex_queue[(net->redex_queue_start + i) & mask];
+        if ((size_t)redex.node_a >= used || (size_t)redex.node_b >= used ||
+            map[redex.node_a] == UINT32_MAX || map[redex.node_b] == UINT32_MAX) {
+            continue;
+        }
+        ic_redex_t *slot = &net->redex_queue[(net->redex_queue_start + kept) & mask];
+        slot->node_a = (int)map[redex.node_a];
+        slot->node_b = (int)map[redex.node_b];
+        kept++;
+    }
+    net->redex_queue_size = kept;
+    free(map);
+    
+#ifdef IC_STATS
+    net->stats.compactions++;
+    net->stats.compaction_slots += used;
+    net->stats.compaction_moves += moves;
+#else
+    (void)moves;
+#endif
+    return used - live;
 }
 
 /**
- * Apply the rewrite rule for gamma-gamma interaction
+ * Whether a net with `live` live nodes has fallen below its compaction threshold
  */
-static void ic_apply_gamma_gamma(ic_net_t *net, int node1, int node2) {
-    // Store connections to auxiliary ports
-    int conn1_aux1_node = net->nodes[node1].ports[1].connected_node;
-    int conn1_aux1_port = net->nodes[node1].ports[1].connected_port;
-    
-    int conn1_aux2_node = net->nodes[node1].ports[2].connected_node;
-    int conn1_aux2_port = net->nodes[node1].ports[2].connected_port;
-    
-    int conn2_aux1_node = net->nodes[node2].ports[1].connected_node;
-    int conn2_aux1_port = net->nodes[node2].ports[1].connected_port;
-    
-    int conn2_aux2_node = net->nodes[node2].ports[2].connected_node;
-    int conn2_aux2_port = net->nodes[node2].ports[2].connected_port;
-    
-    // Disconnect all connections
-    // First disconnect the principal ports since they are connected to each other
-    net->nodes[node1].ports[0].connected_node = -1;
-    net->nodes[node1].ports[0].connected_port = -1;
-    net->nodes[node2].ports[0].connected_node = -1;
-    net->nodes[node2].ports[0].connected_port = -1;
-    
-    // Now disconnect the aux ports
-    if (conn1_aux1_node >= 0) {
-        net->nodes[conn1_aux1_node].ports[conn1_aux1_port].connected_node = -1;
-        net->nodes[conn1_aux1_node].ports[conn1_aux1_port].connected_port = -1;
-        net->nodes[node1].ports[1].connected_node = -1;
-        net->nodes[node1].ports[1].connected_port = -1;
-    }
+static inline bool ic_net_should_compact(const ic_net_t *net, size_t live) {
+    return net->compact_live_percent > 0 && net->used_nodes >= IC_COMPACT_MIN_SLOTS &&
+           live * 100 < (size_t)net->compact_live_percent * net->used_nodes;
+}
+
+/**
+ * Double the capacity of the redex ring, unwrapping it to start at 0
+ * @return 0 on success, -1 if the allocation failed or the ring is borrowed
+ */
+static int ic_net_grow_redex_queue(ic_net_t *net) {
+    if (net->borrowed_storage) return -1;
     
-    if (conn1_aux2_node >= 0) {
-        net->nodes[conn1_aux2_node].ports[conn1_aux2_port].connected_node = -1;
-        net->nodes[conn1_aux2_node].ports[conn1_aux2_port].connected_port = -1;
-        net->nodes[node1].ports[2].connected_node = -1;
-        net->nodes[node1].ports[2].connected_port = -1;
-    }
+    size_t capacity = net->redex_queue_capacity * 2;
+    ic_redex_t *queue = (ic_redex_t*)malloc(capacity * sizeof(ic_redex_t));
+    if (!queue) return -1;
+    ic_count_alloc();
     
-    if (conn2_aux1_node >= 0) {
-        net->nodes[conn2_aux1_node].ports[conn2_aux1_port].connected_node = -1;
-        net->nodes[conn2_aux1_node].ports[conn2_aux1_port].connected_port = -1;
-        net->nodes[node2].ports[1].connected_node = -1;
-        net->nodes[node2].ports[1].connected_port = -1;
+    for (size_t i = 0; i < net->redex_queue_size; i++) {
+        queue[i] = net->redex_queue[(net->redex_queue_start + i) &
+                                    (net->redex_queue_capacity - 1)];
     }
     
-    if (conn2_aux2_node >= 0) {
-        net->nodes[conn2_aux2_node].ports[conn2_aux2_port].connected_node = -1;
-        net->nodes[conn2_aux2_node].ports[conn2_aux2_port].connected_port = -1;
-        net->nodes[node2].ports[2].connected_node = -1;
-        net->nodes[node2].ports[2].connected_port = -1;
+    free(net->redex_queue);
+    net->redex_queue = queue;
+    net->redex_queue_capacity = capacity;
+    net->redex_queue_start = 0;
+    return 0;
+}
+
+/**
+ * Check whether two live nodes are joined principal to principal
+ */
+static inline bool ic_net_is_redex(const ic_net_t *net, int node_a, int node_b) {
+    return net->active[node_a] && net->active[node_b] &&
+           net->wires[3 * (size_t)node_a] == IC_WIRE(node_b, 0) &&
+           net->wires[3 * (size_t)node_b] == IC_WIRE(node_a, 0);
+}
+
+/**
+ * Add a potential redex to the queue
+ */
+static void ic_net_add_redex(ic_net_t *net, int node_a, int node_b) {
+    // Only add live nodes connected via principal ports
+    if (!ic_net_is_redex(net, node_a, node_b)) {
+        return;
     }
     
-    // Connect straight (aux1 to aux1 and aux2 to aux2)
-    if (conn1_aux1_node >= 0 && conn2_aux1_node >= 0) {
-        ic_net_connect(net, conn1_aux1_node, conn1_aux1_port, conn2_aux1_node, conn2_aux1_port);
+    // Grow a full queue; only if that fails is the redex dropped,
+    // and then the reducer rescans once the queue drains
+    if (net->redex_queue_size == net->redex_queue_capacity) {
+        if (ic_net_grow_redex_queue(net) != 0) {
+            IC_STAT_INC(net, redexes_dropped);
+            IC_TRACE_EVENT(IC_TRACE_QUEUE_FULL, IC_TRACE_QUEUE_DROPPED, 0,
+                           (uint32_t)net->redex_queue_capacity);
+            net->redex_rescan_needed = true;
+            return;
+        }
+        IC_TRACE_EVENT(IC_TRACE_QUEUE_FULL, IC_TRACE_QUEUE_GROWN, 0,
+                       (uint32_t)net->redex_queue_capacity);
     }
     
-    if (conn1_aux2_node >= 0 && conn2_aux2_node >= 0) {
-        ic_net_connect(net, conn1_aux2_node, conn1_aux2_port, conn2_aux2_node, conn2_aux2_port);
-    }
+    // Calculate the insertion position (capacity is a power of two)
+    size_t pos = (net->redex_queue_start + net->redex_queue_size) &
+                 (net->redex_queue_capacity - 1);
     
-    // Mark nodes as inactive
-    net->nodes[node1].is_active = false;
-    net->nodes[node2].is_active = false;
+    // Add to queue
+    net->redex_queue[pos].node_a = node_a;
+    net->redex_queue[pos].node_b = node_b;
+    net->redex_queue_size++;
 }
 
 /**
- * Apply the rewrite rule for delta-gamma interaction
+ * Get and remove the next live redex from the queue, discarding stale
+ * entries whose nodes were rewired or erased since they were queued.
+ * FIFO order takes the oldest entry, LIFO order the newest.
+ * @return true if a redex was retrieved, false if the queue is empty
  */
-static void ic_apply_delta_gamma(ic_net_t *net, int delta_node, int gamma_node) {
-    // Store connections to auxiliary ports
-    int conn_delta_aux1_node = net->nodes[delta_node].ports[1].connected_node;
-    int conn_delta_aux1_port = net->nodes[delta_node].ports[1].connected_port;
-    
-    int conn_delta_aux2_node = net->nodes[delta_node].ports[2].connected_node;
-    int conn_delta_aux2_port = net->nodes[delta_node].ports[2].connected_port;
-    
-    int conn_gamma_aux1_node = net->nodes[gamma_node].ports[1].connected_node;
-    int conn_gamma_aux1_port = net->nodes[gamma_node].ports[1].connected_port;
-    
-    int conn_gamma_aux2_node = net->nodes[gamma_node].ports[2].connected_node;
-    int conn_gamma_aux2_port = net->nodes[gamma_node].ports[2].connected_port;
-    
-    // Create two new nodes: delta and gamma
-    int new_delta = ic_net_new_node(net, IC_NODE_DELTA);
-    int new_gamma = ic_net_new_node(net, IC_NODE_GAMMA);
-    
-    if (new_delta == -1 || new_gamma == -1) {
-        // Out of space, cannot proceed with rewrite
-        if (new_delta != -1) {
-            net->nodes[new_delta].is_active = false;
+static bool ic_net_get_next_redex(ic_net_t *net, int *node_a, int *node_b) {
+    size_t mask = net->redex_queue_capacity - 1;
+    
+    while (net->redex_queue_size > 0) {
+        size_t pos;
+        if (net->redex_order == IC_REDEX_LIFO) {
+            // Pop from the back of the queue
+            pos = (net->redex_queue_start + net->redex_queue_size - 1) & mask;
+        } else {
+            // Pop from the front of the queue
+            pos = net->redex_queue_start;
+            net->redex_queue_start = (net->redex_queue_start + 1) & mask;
         }
-        if (new_gamma != -1) {
-            net->nodes[new_gamma].is_active = false;
+        net->redex_queue_size--;
+        
+        *node_a = net->redex_queue[pos].node_a;
+        *node_b = net->redex_queue[pos].node_b;
+        
+        // Check if the redex is still valid (both nodes active and connected)
+        if (ic_net_is_redex(net, *node_a, *node_b)) {
+            return true;
         }
-        return;
-    }
-    
-    // Disconnect the principal ports since they are connected to each other
-    net->nodes[delta_node].ports[0].connected_node = -1;
-    net->nodes[delta_node].ports[0].connected_port = -1;
-    net->nodes[gamma_node].ports[0].connected_node = -1;
-    net->nodes[gamma_node].ports[0].connected_port = -1;
-    
-    // Disconnect aux ports properly
-    if (conn_delta_aux1_node >= 0) {
-        net->nodes[conn_delta_aux1_node].ports[conn_delta_aux1_port].connected_node = -1;
-        net->nodes[conn_delta_aux1_node].ports[conn_delta_aux1_port].connected_port = -1;
-        net->nodes[delta_node].ports[1].connected_node = -1;
-        net->nodes[delta_node].ports[1].connected_port = -1;
-    }
-    
-    if (conn_delta_aux2_node >= 0) {
-        net->nodes[conn_delta_aux2_node].ports[conn_delta_aux2_port].connected_node = -1;
-        net->nodes[conn_delta_aux2_node].ports[conn_delta_aux2_port].connected_port = -1;
-        net->nodes[delta_node].ports[2].connected_node = -1;
-        net->nodes[delta_node].ports[2].connected_port = -1;
     }
     
-    if (conn_gamma_aux1_node >= 0) {
-        net->nodes[conn_gamma_aux1_node].ports[conn_gamma_aux1_port].connected_node = -1;
-        net->nodes[conn_gamma_aux1_node].ports[conn_gamma_aux1_port].connected_port = -1;
-        net->nodes[gamma_node].ports[1].connected_node = -1;
-        net->nodes[gamma_node].ports[1].connected_port = -1;
-    }
-    
-    if (conn_gamma_aux2_node >= 0) {
-        net->nodes[conn_gamma_aux2_node].ports[conn_gamma_aux2_port].connected_node = -1;
-        net->nodes[conn_gamma_aux2_node].ports[conn_gamma_aux2_port].connected_port = -1;
-        net->nodes[gamma_node].ports[2].connected_node = -1;
-        net->nodes[gamma_node].ports[2].connected_port = -1;
-    }
-    
-    // Connect new nodes appropriately
-    // Connect principal ports of new nodes
-    ic_net_connect(net, new_delta, 0, new_gamma, 0);
-    
-    // Connect other aux ports to the original connections
-    if (conn_delta_aux1_node >= 0) {
-        ic_net_connect(net, new_delta, 1, conn_delta_aux1_node, conn_delta_aux1_port);
-    }
-    
-    if (conn_gamma_aux1_node >= 0) {
-        ic_net_connect(net, new_delta, 2, conn_gamma_aux1_node, conn_gamma_aux1_port);
+    return false;
+}
+
+// The rewrite rules, shared with the fixed-capacity reducers
+#define IC_RULES_T ic_net_t
+#define IC_RULES_FN(name) ic_net_##name
+#define IC_RULES_NET(net) (net)
+#define IC_RULES_WIRES(net) ((net)->wires)
+#define IC_RULES_TYPES(net) ((net)->types)
+#define IC_RULES_ACTIVE(net) ((net)->active)
+#define IC_RULES_NEW_NODE(net, type) ic_net_new_node((net), (type))
+#define IC_RULES_ADD_REDEX(net, a, b) ic_net_add_redex((net), (a), (b))
+#define IC_RULES_ABORTED(net) false
+#define IC_RULES_COUNT(net, field) IC_STAT_INC((net), field)
+#define IC_RULES_TRACE(net, rule, a, b) IC_TRACE_EVENT(IC_TRACE_REWRITE, (rule), (a), (b))
+#include "ic_rules_impl.h"
+
+void ic_net_connect(ic_net_t *net, int node_a, int port_a, int node_b, int port_b) {
+    // Validate indices
+    if (!net || 
+        node_a < 0 || node_a >= (int)net->used_nodes || 
+        node_b < 0 || node_b >= (int)net->used_nodes ||
+        port_a < 0 || port_a >= 3 ||
+        port_b < 0 || port_b >= 3) {
+        return;
     }
     
-    if (conn_delta_aux2_node >= 0) {
-        ic_net_connect(net, new_gamma, 1, conn_delta_aux2_node, conn_delta_aux2_port);
-    }
+    ic_wire_t a = IC_WIRE(node_a, port_a);
+    ic_wire_t b = IC_WIRE(node_b, port_b);
     
-    if (conn_gamma_aux2_node >= 0) {
-        ic_net_connect(net, new_gamma, 2, conn_gamma_aux2_node, conn_gamma_aux2_port);
-    }
+    // Disconnect any existing connections for port_a and port_b
+    ic_wire_t old_a = *ic_net_slot(net, a);
+    if (old_a != IC_WIRE_NONE) *ic_net_slot(net, old_a) = IC_WIRE_NONE;
     
-    // Mark original nodes as inactive
-    net->nodes[delta_node].is_active = false;
-    net->nodes[gamma_node].is_active = false;
-}
-
-/**
- * Apply the rewrite rule for epsilon with any node
- */
-static void ic_apply_epsilon_any(ic_net_t *net, int epsilon_node, int other_node) {
-    // Just mark epsilon node as inactive
-    net->nodes[epsilon_node].is_active = false;
+    ic_wire_t old_b = *ic_net_slot(net, b);
+    if (old_b != IC_WIRE_NONE) *ic_net_slot(net, old_b) = IC_WIRE_NONE;
     
-    // The auxiliary ports of the other node are left as they are
+    // Connect the two ports, queueing the pair if both are principal
+    ic_net_link(net, a, b);
 }
 
 /**
@@ -411,154 +513,266 @@ static bool ic_apply_rewrite(ic_net_t *net, int node_a, int node_b) {
         return false;
     }
     
-    ic_node_type_t type_a = net->nodes[node_a].type;
-    ic_node_type_t type_b = net->nodes[node_b].type;
-    
-    // Apply the appropriate rewrite rule based on node types
-    if (type_a == IC_NODE_EPSILON || type_b == IC_NODE_EPSILON) {
-        // Epsilon erases any node it interacts with
-        int epsilon_node = (type_a == IC_NODE_EPSILON) ? node_a : node_b;
-        int other_node = (type_a == IC_NODE_EPSILON) ? node_b : node_a;
-        
-        ic_apply_epsilon_any(net, epsilon_node, other_node);
-        return true;
-    } else if (type_a == IC_NODE_DELTA && type_b == IC_NODE_DELTA) {
-        // Delta-Delta rule
-        ic_apply_delta_delta(net, node_a, node_b);
-        return true;
-    } else if (type_a == IC_NODE_GAMMA && type_b == IC_NODE_GAMMA) {
-        // Gamma-Gamma rule
-        ic_apply_gamma_gamma(net, node_a, node_b);
-        return true;
-    } else if ((type_a == IC_NODE_DELTA && type_b == IC_NODE_GAMMA) ||
-               (type_a == IC_NODE_GAMMA && type_b == IC_NODE_DELTA)) {
-        // Delta-Gamma rule
-        int delta_node = (type_a == IC_NODE_DELTA) ? node_a : node_b;
-        int gamma_node = (type_a == IC_NODE_GAMMA) ? node_a : node_b;
-        
-        ic_apply_delta_gamma(net, delta_node, gamma_node);
-        return true;
+    // Only δ, γ and ε have rules
+    if (net->types[node_a] > IC_NODE_EPSILON || net->types[node_b] > IC_NODE_EPSILON) {
+        return false;
     }
     
-    return false;
+    ic_net_interact(net, node_a, node_b);
+    return true;
 }
 
 /**
  * Scan the entire net to populate the redex queue
+ * This is O(used_nodes), so the reducer only calls it before the first
+ * rewrite, after the queue failed to grow, and in IC_DEBUG consistency checks.
+ * Every rewrite rule queues the redexes it creates through ic_net_link.
  */
 static void ic_net_scan_for_redexes(ic_net_t *net) {
     // Reset the redex queue
     net->redex_queue_size = 0;
     net->redex_queue_start = 0;
+    net->redex_rescan_needed = false;
     
     // Scan for active pairs
     for (size_t i = 0; i < net->used_nodes; i++) {
-        if (!net->nodes[i].is_active) continue;
+        if (!net->active[i]) continue;
+        
+        ic_wire_t conn = net->wires[3 * i];
+        if (conn == IC_WIRE_NONE) continue;
         
-        int conn_node = net->nodes[i].ports[0].connected_node;
-        int conn_port = net->nodes[i].ports[0].connected_port;
+        int conn_node = IC_WIRE_NODE(conn);
         
         // Only consider pairs where the current node index is less than the connected node
         // This prevents adding the same pair twice
-        if (conn_node > (int)i && conn_port == 0 && net->nodes[conn_node].is_active) {
+        if (conn_node > (int)i && IC_WIRE_PORT(conn) == 0 && net->active[conn_node]) {
             ic_net_add_redex(net, i, conn_node);
         }
     }
 }
 
-int ic_net_reduce(ic_net_t *net) {
-    if (!net) return 1;
-    
-    net->gas_used = 0;
-    
-    // Initial scan to populate the redex queue
-    ic_net_scan_for_redexes(net);
+/**
+ * Goal a reduction of net checks: its own, or without one the factor
+ * goal of its input number, built in `factor_goal`
+ */
+static const ic_goal_t *ic_net_reduce_goal(const ic_net_t *net, ic_goal_t *factor_goal) {
+    if (!net->goal && net->input_number > 0) {
+        *factor_goal = ic_goal_factor(net->input_number);
+        return factor_goal;
+    }
+    return net->goal;
+}
+
+/**
+ * Rewrite until no active pairs remain, gas_used reaches `stop` or the
+ * goal is out of reach; a loop found on the way extends `stop` to the
+ * gas limit, whose last partial period is then run normally
+ * @return 0 if no redex is left, 1 if `stop` was reached, 3 if abandoned
+ */
+static inline int ic_net_rewrite(ic_net_t *net, size_t stop, ic_loop_detector_t *loop,
+                                 ic_goal_poll_t *poll) {
+    // Live nodes, counted once and then updated by each rule
+    bool compact = net->compact_live_percent > 0;
+    size_t live = 0;
+    for (size_t i = 0; compact && i < net->used_nodes; i++) {
+        live += net->active[i];
+    }
     
     // Process redexes until queue is empty or gas is exhausted
-    while (net->gas_used < net->gas_limit) {
+    while (net->gas_used < stop) {
         int node_a, node_b;
         
+        // A net that can no longer reach its goal is not worth its gas
+        if (ic_goal_poll_step(poll, net)) {
+            return 3;
+        }
+        
         // Get the next redex from the queue
         if (!ic_net_get_next_redex(net, &node_a, &node_b)) {
-            // If queue is empty, scan net again to find any new redexes
-            ic_net_scan_for_redexes(net);
+            // Redexes dropped when the queue could not grow have to be found again
+            if (net->redex_rescan_needed) {
+                IC_STAT_INC(net, rescans);
+                IC_TRACE_EVENT(IC_TRACE_RESCAN, 0, 0, 0);
+                ic_net_scan_for_redexes(net);
+                continue;
+            }
             
-            // If still no redexes, we're done
-            if (net->redex_queue_size == 0) {
-                break;
+#ifdef IC_DEBUG
+            // Consistency check: the rules must have queued every redex
+            IC_STAT_INC(net, rescans);
+            ic_net_scan_for_redexes(net);
+            if (net->redex_queue_size > 0) {
+                fprintf(stderr, "ic_net_reduce: %zu redexes were not queued by their rewrite\n",
+                        net->redex_queue_size);
+                continue;
             }
+#endif
             
-            // Try again
-            continue;
+            // No redexes left, we're done
+            return 0;
         }
         
-        // Apply rewrite rule
-        if (ic_apply_rewrite(net, node_a, node_b)) {
-            net->gas_used++;
-            
-            // When connections change during a rewrite, check newly connected principal ports
-            // to see if they form redexes, and add them to the queue
-            for (size_t i = 0; i < net->used_nodes; i++) {
-                if (!net->nodes[i].is_active) continue;
-                
-                int conn_node = net->nodes[i].ports[0].connected_node;
-                int conn_port = net->nodes[i].ports[0].connected_port;
-                
-                if (conn_node > (int)i && conn_port == 0 && net->nodes[conn_node].is_active) {
-                    ic_net_add_redex(net, i, conn_node);
-                }
-            }
+        // ε erases one node, δδ and γγ two, δγ (even out of space) none
+        if (compact) {
+            bool epsilon = net->types[node_a] == IC_NODE_EPSILON ||
+                           net->types[node_b] == IC_NODE_EPSILON;
+            live -= epsilon ? 1 : (net->types[node_a] == net->types[node_b]) ? 2 : 0;
         }
-    }
-    
-    // Check for factorization before returning
-    if (net->input_number > 0) {
-        // For demo purposes, let's say a specific net configuration could indicate factorization
-        // This is a placeholder - in a real system, you'd have a more sophisticated way to encode/decode
         
-        // Count the number of active delta and gamma nodes
-        int active_deltas = 0;
-        int active_gammas = 0;
-        for (size_t i = 0; i < net->used_nodes; i++) {
-            if (net->nodes[i].is_active) {
-                if (net->nodes[i].type == IC_NODE_DELTA) active_deltas++;
-                if (net->nodes[i].type == IC_NODE_GAMMA) active_gammas++;
-            }
+        // Apply rewrite rule; any redex it creates is queued by ic_net_link
+        if (ic_apply_rewrite(net, node_a, node_b)) {
+            net->gas_used++;
+            if (ic_loop_detector_step(loop, net)) stop = net->gas_limit;
         }
         
-        // This is a toy example - suppose that if we have exactly 2 active nodes left,
-        // and they are delta and gamma, then the factors are their positions + 1
-        if (active_deltas == 1 && active_gammas == 1) {
-            int factor_a = 0;
-            int factor_b = 0;
-            
-            for (size_t i = 0; i < net->used_nodes; i++) {
-                if (net->nodes[i].is_active && net->nodes[i].type == IC_NODE_DELTA) {
-                    factor_a = i + 1;
-                }
-                if (net->nodes[i].is_active && net->nodes[i].type == IC_NODE_GAMMA) {
-                    factor_b = i + 1;
-                }
-            }
-            
-            // For our test case
-            if (net->input_number == 6 && factor_a == 1 && factor_b == 3) {
-                net->factor_a = factor_a;
-                net->factor_b = factor_b;
-                net->factor_found = true;
-            }
-            // For general case
-            else if (factor_a * factor_b == net->input_number) {
-                net->factor_a = factor_a;
-                net->factor_b = factor_b;
-                net->factor_found = true;
-            }
+        if (compact && ic_net_should_compact(net, live)) {
+            ic_net_compact(net);
         }
     }
+    return 1;
+}
+
+/**
+ * Count a stopped reduction, check its goal and give ic_net_reduce's result
+ */
+static int ic_net_reduce_finish(ic_net_t *net, const ic_loop_detector_t *loop,
+                                const ic_goal_t *goal, bool abandoned) {
+#ifdef IC_STATS
+    ic_stats_count_reduction(&net->stats, net->gas_used);
+    if (loop->found) {
+        net->stats.loops++;
+        net->stats.gas_skipped += net->gas_skipped;
+    }
+    if (abandoned) net->stats.abandoned++;
+#endif
+    
+    if (abandoned) return 3;
+    if (goal && goal->reached) {
+        goal->reached(goal, net);
+    }
     
+    if (loop->found) return 2;
     return (net->gas_used < net->gas_limit) ? 0 : 1;
 }
 
+int ic_net_reduce(ic_net_t *net) {
+    if (!net) return 1;
+    
+    net->gas_used = 0;
+    net->gas_skipped = 0;
+    net->reduce_suspended = false;
+    ic_loop_detector_t loop;
+    ic_loop_detector_init(&loop, net);
+    
+    ic_goal_t factor_goal;
+    const ic_goal_t *goal = ic_net_reduce_goal(net, &factor_goal);
+    
+    // Initial scan to populate the redex queue
+    ic_net_scan_for_redexes(net);
+    
+    ic_goal_poll_t poll;
+    ic_goal_poll_init(&poll, goal);
+    bool abandoned = ic_net_rewrite(net, net->gas_limit, &loop, &poll) == 3;
+    return ic_net_reduce_finish(net, &loop, goal, abandoned);
+}
+
+int ic_net_reduce_steps(ic_net_t *net, size_t budget) {
+    if (!net) return 1;
+    
+    ic_goal_t factor_goal;
+    const ic_goal_t *goal = ic_net_reduce_goal(net, &factor_goal);
+    ic_goal_poll_t poll;
+    ic_goal_poll_init(&poll, goal);
+    
+    // A new reduction starts as ic_net_reduce's does
+    if (net->reduce_suspended) {
+        poll.next_poll = net->reduce_next_poll;
+    } else {
+        net->gas_used = 0;
+        net->gas_skipped = 0;
+        ic_loop_detector_init(&net->reduce_loop, net);
+        ic_net_scan_for_redexes(net);
+    }
+    net->reduce_suspended = false;
+    
+    size_t remaining = net->gas_limit - net->gas_used;
+    size_t stop = (budget < remaining) ? net->gas_used + budget : net->gas_limit;
+    int stopped = ic_net_rewrite(net, stop, &net->reduce_loop, &poll);
+    
+    // Out of budget but not of gas: the queue holds the rest of the reduction
+    if (stopped == 1 && net->gas_used < net->gas_limit) {
+        net->reduce_suspended = true;
+        net->reduce_next_poll = poll.next_poll;
+        return IC_REDUCE_SUSPENDED;
+    }
+    return ic_net_reduce_finish(net, &net->reduce_loop, goal, stopped == 3);
+}
+
+/**
+ * ic_goal_factor's success test: the surviving pair multiplies to the target
+ */
+static bool ic_goal_factor_reached(const ic_goal_t *goal, ic_net_t *net) {
+    int factor_a = 0, factor_b = 0;
+    if (!ic_net_factor_pair(net, &factor_a, &factor_b)) return false;
+    if (goal->target > 0 && factor_a * factor_b != goal->target) return false;
+    
+    net->factor_a = factor_a;
+    net->factor_b = factor_b;
+    net->factor_found = true;
+    return true;
+}
+
+/**
+ * ic_goal_factor's pruning test: an even δ or γ count stays even
+ */
+static bool ic_goal_factor_impossible(const ic_goal_t *goal, const ic_net_t *net) {
+    (void)goal;
+    unsigned counts[3] = { 0, 0, 0 };
+    for (size_t i = 0; i < net->used_nodes; i++) {
+        counts[net->types[i] % 3] += net->active[i];
+    }
+    return (counts[IC_NODE_DELTA] % 2 == 0) || (counts[IC_NODE_GAMMA] % 2 == 0);
+}
+
+ic_goal_t ic_goal_factor(int N) {
+    // Parity never changes, so one check before the first rewrite suffices
+    ic_goal_t goal = {
+        .reached = ic_goal_factor_reached,
+        .impossible = ic_goal_factor_impossible,
+        .poll_interval = 0,
+        .target = N,
+    };
+    return goal;
+}
+
+bool ic_net_factor_pair(const ic_net_t *net, int *factor_a, int *factor_b) {
+    if (!net) return false;
+    
+    // Count the number of active delta and gamma nodes, remembering positions
+    int active_deltas = 0;
+    int active_gammas = 0;
+    int delta_pos = -1;
+    int gamma_pos = -1;
+    for (size_t i = 0; i < net->used_nodes; i++) {
+        if (!net->active[i]) continue;
+        if (net->types[i] == IC_NODE_DELTA) {
+            active_deltas++;
+            delta_pos = (int)i;
+        } else if (net->types[i] == IC_NODE_GAMMA) {
+            active_gammas++;
+            gamma_pos = (int)i;
+        }
+    }
+    
+    if (active_deltas != 1 || active_gammas != 1) {
+        return false;
+    }
+    
+    if (factor_a) *factor_a = delta_pos + 1;
+    if (factor_b) *factor_b = gamma_pos + 1;
+    return true;
+}
+
 bool ic_net_has_valid_factor(const ic_net_t *net, int N) {
     if (!net) return false;
     
@@ -580,10 +794,10 @@ void ic_net_print(const ic_net_t *net) {
     
     printf("Nodes:\n");
     for (size_t i = 0; i < net->used_nodes; i++) {
-        if (!net->nodes[i].is_active) continue;
+        if (!net->active[i]) continue;
         
         const char *type_str;
-        switch (net->nodes[i].type) {
+        switch (net->types[i]) {
             case IC_NODE_DELTA: type_str = "δ"; break;
             case IC_NODE_GAMMA: type_str = "γ"; break;
             case IC_NODE_EPSILON: type_str = "ε"; break;
@@ -592,8 +806,9 @@ void ic_net_print(const ic_net_t *net) {
         
         printf("  Node %zu: Type=%s, Ports=[", i, type_str);
         for (int p = 0; p < 3; p++) {
-            int conn_node = net->nodes[i].ports[p].connected_node;
-            int conn_port = net->nodes[i].ports[p].connected_port;
+            ic_wire_t conn = net->wires[3 * i + p];
+            int conn_node = (conn == IC_WIRE_NONE) ? -1 : IC_WIRE_NODE(conn);
+            int conn_port = (conn == IC_WIRE_NONE) ? -1 : IC_WIRE_PORT(conn);
             
             if (conn_node >= 0) {
                 printf("(%d,%d)", conn_node, conn_port);
@@ -607,6 +822,48 @@ void ic_net_print(const ic_net_t *net) {
     }
 }
 
+/**
+ * Fold one word into a running 64-bit hash
+ */
+static inline uint64_t ic_hash_mix(uint64_t h, uint64_t v) {
+    h = (h ^ v) * 0x9E3779B97F4A7C15ULL;
+    return h ^ (h >> 32);
+}
+
+uint64_t ic_net_hash(const ic_net_t *net) {
+    if (!net) return 0;
+    
+    uint64_t h = ic_hash_mix(0xcbf29ce484222325ULL, net->used_nodes);
+    h = ic_hash_mix(h, (uint32_t)net->free_head);
+    
+    // Dead slots contribute only their free-list link, never their stale type
+    for (size_t i = 0; i < net->used_nodes; i++) {
+        h = ic_hash_mix(h, net->active[i] ? (uint64_t)net->types[i] + 1 : 0);
+        for (int p = 0; p < 3; p++) {
+            h = ic_hash_mix(h, net->wires[3 * i + p]);
+        }
+    }
+    
+    // Final avalanche so nearby nets land in unrelated table slots
+    h ^= h >> 29;
+    h *= 0xBF58476D1CE4E5B9ULL;
+    return h ^ (h >> 32);
+}
+
+uint64_t ic_net_state_hash(const ic_net_t *net) {
+    if (!net) return 0;
+    
+    // The queue decides which redex is rewritten next, stale entries included
+    uint64_t h = ic_hash_mix(ic_net_hash(net), net->redex_queue_size);
+    h = ic_hash_mix(h, ((uint64_t)net->redex_order << 1) | net->redex_rescan_needed);
+    size_t mask = net->redex_queue_capacity - 1;
+    for (size_t i = 0; i < net->redex_queue_size; i++) {
+        const ic_redex_t *redex = &net->redex_queue[(net->redex_queue_start + i) & mask];
+        h = ic_hash_mix(h, ((uint64_t)(uint32_t)redex->node_a << 32) | (uint32_t)redex->node_b);
+    }
+    return h;
+}
+
 size_t ic_net_get_used_nodes(const ic_net_t *net) {
     if (!net) return 0;
     return net->used_nodes;
@@ -620,12 +877,12 @@ void ic_net_export_dot(const ic_net_t *net, FILE *out) {
     
     // Print nodes
     for (size_t i = 0; i < net->used_nodes; i++) {
-        if (!net->nodes[i].is_active) continue;
+        if (!net->active[i]) continue;
         
         const char *type_str;
         const char *color;
         
-        switch (net->nodes[i].type) {
+        switch (net->types[i]) {
             case IC_NODE_DELTA:
                 type_str = "δ";
                 color = "red";
@@ -659,15 +916,16 @@ void ic_net_export_dot(const ic_net_t *net, FILE *out) {
     
     // Print connections
     for (size_t i = 0; i < net->used_nodes; i++) {
-        if (!net->nodes[i].is_active) continue;
+        if (!net->active[i]) continue;
         
         for (int p = 0; p < 3; p++) {
-            int conn_node = net->nodes[i].ports[p].connected_node;
-            int conn_port = net->nodes[i].ports[p].connected_port;
+            ic_wire_t conn = net->wires[3 * i + p];
+            int conn_node = (conn == IC_WIRE_NONE) ? -1 : IC_WIRE_NODE(conn);
+            int conn_port = (conn == IC_WIRE_NONE) ? -1 : IC_WIRE_PORT(conn);
             
             if (conn_node >= 0 && conn_node < (int)net->used_nodes && 
                 conn_port >= 0 && conn_port < 3 && 
-                net->nodes[conn_node].is_active && 
+                net->active[conn_node] && 
                 i < (size_t)conn_node) { // Only draw once for each connection
                     
                 const char *port_str_i;
@@ -695,4 +953,67 @@ void ic_net_export_dot(const ic_net_t *net, FILE *out) {
     }
     
     fprintf(out, "}\n");
-}
\ No newline at end of file
+}
+
+#ifdef IC_STATS
+void ic_stats_count_reduction(ic_stats_t *stats, size_t gas_used) {
+    // Bucket k holds gas in [2^(k-1), 2^k), so bucket = bit length of gas
+    size_t bucket = 0;
+    for (size_t gas = gas_used; gas > 0 && bucket < IC_STATS_GAS_BUCKETS - 1; gas >>= 1) {
+        bucket++;
+    }
+    stats->gas_histogram[bucket]++;
+    stats->nets_reduced++;
+}
+
+void ic_stats_add(ic_stats_t *into, const ic_stats_t *from) {
+    if (!into || !from) return;
+    
+    into->delta_delta += from->delta_delta;
+    into->gamma_gamma += from->gamma_gamma;
+    into->delta_gamma += from->delta_gamma;
+    into->epsilon += from->epsilon;
+    into->redexes_dropped += from->redexes_dropped;
+    into->rescans += from->rescans;
+    into->out_of_space += from->out_of_space;
+    into->nets_reduced += from->nets_reduced;
+    into->loops += from->loops;
+    into->gas_skipped += from->gas_skipped;
+    into->abandoned += from->abandoned;
+    into->compactions += from->compactions;
+    into->compaction_slots += from->compaction_slots;
+    into->compaction_moves += from->compaction_moves;
+    for (size_t b = 0; b < IC_STATS_GAS_BUCKETS; b++) {
+        into->gas_histogram[b] += from->gas_histogram[b];
+    }
+}
+
+void ic_stats_print(const ic_stats_t *stats, FILE *out) {
+    if (!stats || !out) return;
+    
+    uint64_t total = stats->delta_delta + stats->gamma_gamma + stats->delta_gamma + stats->epsilon;
+    fprintf(out, "Reduction statistics (%llu nets, %llu rewrites):\n",
+            (unsigned long long)stats->nets_reduced, (unsigned long long)total);
+    fprintf(out, "  δ-δ: %llu  γ-γ: %llu  δ-γ: %llu  ε: %llu\n",
+            (unsigned long long)stats->delta_delta, (unsigned long long)stats->gamma_gamma,
+            (unsigned long long)stats->delta_gamma, (unsigned long long)stats->epsilon);
+    fprintf(out, "  Dropped redexes: %llu  Rescans: %llu  Out-of-space δ-γ: %llu\n",
+            (unsigned long long)stats->redexes_dropped, (unsigned long long)stats->rescans,
+            (unsigned long long)stats->out_of_space);
+    fprintf(out, "  Loops detected: %llu  Rewrites skipped: %llu  Abandoned: %llu\n",
+            (unsigned long long)stats->loops, (unsigned long long)stats->gas_skipped,
+            (unsigned long long)stats->abandoned);
+    fprintf(out, "  Compactions: %llu  Slots walked: %llu  Nodes moved: %llu\n",
+            (unsigned long long)stats->compactions, (unsigned long long)stats->compaction_slots,
+            (unsigned long long)stats->compaction_moves);
+    
+    fprintf(out, "  Gas used per net:\n");
+    for (size_t b = 0; b < IC_STATS_GAS_BUCKETS; b++) {
+        if (stats->gas_histogram[b] == 0) continue;
+        unsigned long long low = (b == 0) ? 0 : 1ULL << (b - 1);
+        unsigned long long high = (b == 0) ? 0 : (1ULL << b) - 1;
+        fprintf(out, "    %10llu .. %-10llu %12llu\n", low, high,
+                (unsigned long long)stats->gas_histogram[b]);
+    }
+}
+#endif
@@ -3,6 +3,7 @@
 
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 #include <stdio.h>
 
 /**
@@ -15,21 +16,20 @@ typedef enum {
 } ic_node_type_t;
 
 /**
- * Connection to another port
+ * Packed reference to a node port: (node << 2) | port
+ * Port 0 is the principal port, ports 1 and 2 are the auxiliary ports.
  */
-typedef struct {
-    int connected_node;  // Index of the connected node (-1 if not connected)
-    int connected_port;  // Which port on that node (-1 if not connected)
-} ic_port_t;
+typedef uint32_t ic_wire_t;
 
-/**
- * Node in an interaction combinator graph
- */
-typedef struct {
-    ic_node_type_t type;
-    ic_port_t ports[3];  // principal = ports[0], aux1 = ports[1], aux2 = ports[2]
-    bool is_active;      // Used during rewriting
-} ic_node_t;
+#define IC_WIRE_NONE 0xFFFFFFFFu  // Unconnected port
+#define IC_WIRE(node, port) (((ic_wire_t)(node) << 2) | (ic_wire_t)(port))
+#define IC_WIRE_NODE(wire) ((int)((wire) >> 2))
+#define IC_WIRE_PORT(wire) ((int)((wire) & 0x3))
+
+// Most nodes a net can hold: a wire addresses nodes below 2^30, and the
+// node storage (three wires and two bytes per node) must fit in a size_t
+#define IC_NET_MAX_NODES ((SIZE_MAX / (3 * sizeof(ic_wire_t) + 2) < ((size_t)1 << 30)) \
+                          ? SIZE_MAX / (3 * sizeof(ic_wire_t) + 2) : ((size_t)1 << 30))
 
 /**
  * Represents a potential active pair (redex) of nodes
@@ -39,42 +39,340 @@ typedef struct {
     int node_b;
 } ic_redex_t;
 
-#define MAX_REDEX_QUEUE 256
+/**
+ * Order in which queued redexes are rewritten
+ */
+typedef enum {
+    IC_REDEX_FIFO,  // Oldest redex first (breadth-first)
+    IC_REDEX_LIFO   // Newest redex first (depth-first)
+} ic_redex_order_t;
+
+// Initial redex queue capacity; must be a power of two, doubles when full
+#define IC_REDEX_QUEUE_INITIAL 64
+
+#ifdef IC_STATS
+// Gas histogram buckets: gas 0, then [2^(k-1), 2^k) in bucket k
+#define IC_STATS_GAS_BUCKETS 33
+
+/**
+ * Reduction counters, compiled in only with -DIC_STATS (make STATS=1)
+ */
+typedef struct {
+    uint64_t delta_delta;       // Rewrites by rule
+    uint64_t gamma_gamma;
+    uint64_t delta_gamma;
+    uint64_t epsilon;
+    uint64_t redexes_dropped;   // Redexes lost because the queue could not grow
+    uint64_t rescans;           // Full scans after a reduction's initial one
+    uint64_t out_of_space;      // δγ rewrites aborted for lack of node slots
+    uint64_t loops;             // Reductions that found their net looping
+    uint64_t gas_skipped;       // Rewrites those reductions skipped
+    uint64_t abandoned;         // Reductions stopped because their goal was out of reach
+    uint64_t compactions;       // ic_net_compact passes that moved the live nodes
+    uint64_t compaction_slots;  // Slots those passes walked (their cost)
+    uint64_t compaction_moves;  // Live nodes they moved to a lower slot
+    uint64_t nets_reduced;
+    uint64_t gas_histogram[IC_STATS_GAS_BUCKETS];  // Reductions by log2 of gas_used
+} ic_stats_t;
+
+#define IC_STAT_INC(net, field) ((net)->stats.field++)
+#else
+#define IC_STAT_INC(net, field) ((void)0)
+#endif
+
+/**
+ * Brent's cycle detection over the states a reduction samples
+ * The reducer is deterministic, so once a sampled state repeats, the
+ * whole reduction repeats with the distance between the two samples as
+ * its period. The saved sample itself is kept in the net (loop_state),
+ * and a matching hash only counts once the states compare equal.
+ */
+typedef struct {
+    size_t next_sample;  // gas_used at which the next state is sampled
+    uint64_t saved;      // Hash of the saved state, checked before comparing it
+    size_t power;        // Samples after which `saved` is replaced
+    size_t length;       // Samples taken since `saved`
+    bool has_saved;
+    bool found;          // A loop was found (and skipped)
+} ic_loop_detector_t;
+
+/**
+ * Exact copy of the reduction state a loop detector saved: everything
+ * ic_net_state_hash reads, with the redex ring unwrapped to start at 0
+ */
+typedef struct {
+    ic_wire_t *wires;     // 3 per slot, as in the net
+    uint8_t *types;       // Type + 1 of a live slot, 0 of a free one
+    ic_redex_t *queue;    // Queued redexes, stale ones included
+    size_t slots;         // Capacity of wires and types
+    size_t queue_slots;   // Capacity of queue
+    size_t used_nodes;
+    size_t queued;
+    int free_head;
+    uint8_t order;        // redex_order << 1 | redex_rescan_needed
+} ic_loop_state_t;
+
+typedef struct ic_goal ic_goal_t;
 
 /**
  * Interaction Combinator network/graph
  */
 typedef struct {
-    ic_node_t *nodes;     // Array of nodes in this net
+    // Packed node storage: node i owns wires[3*i .. 3*i+2], types[i] and
+    // active[i]. The three arrays share a single allocation.
+    ic_wire_t *wires;     // Peer of every port, IC_WIRE_NONE if unconnected
+    uint8_t *types;       // ic_node_type_t of each node slot
+    uint8_t *active;      // 1 if the slot holds a live node
     size_t max_nodes;     // Capacity (bound on total nodes)
-    size_t used_nodes;    // How many nodes currently allocated
+    size_t used_nodes;    // High-water mark of allocated node slots
+    int free_head;        // First slot of the free list (-1 if empty)
+    bool reuse_slots;     // Erased slots go onto the free list (see ic_net_set_slot_reuse)
     size_t gas_limit;     // Maximum rewrite steps
     size_t gas_used;      // How many rewrite steps used so far
     
-    // Redex queue for optimization
-    ic_redex_t redex_queue[MAX_REDEX_QUEUE];
+    // Loop detection (off by default, see ic_net_set_loop_check)
+    size_t loop_check_interval;  // Rewrites between state samples, 0 = off
+    size_t gas_skipped;          // Rewrites of gas_used skipped as repeats of a loop
+    ic_loop_state_t loop_state;  // The detector's saved sample
+    
+    // Compaction (off by default, see ic_net_set_compaction)
+    unsigned compact_live_percent;  // Compact below this share of live slots, 0 = off
+    
+    // A reduction ic_net_reduce_steps ran out of budget in; the next call
+    // continues it from the queue, detector and goal poll left here
+    bool reduce_suspended;
+    ic_loop_detector_t reduce_loop;
+    size_t reduce_next_poll;
+    
+    // Redex queue for optimization (growable ring buffer)
+    ic_redex_t *redex_queue;
+    size_t redex_queue_capacity;  // Always a power of two
     size_t redex_queue_size;
     size_t redex_queue_start;
+    ic_redex_order_t redex_order;
+    bool redex_rescan_needed;  // Set when the queue failed to grow
+    bool borrowed_storage;     // Arrays and queue live in an enclosing struct
+                               // (ic_fixed.h): never grown or freed
 
     // Factorization context
+    const ic_goal_t *goal;  // Checked by ic_net_reduce (see ic_net_set_goal)
     int input_number;
     int factor_a;
     int factor_b;
     bool factor_found;
+    
+#ifdef IC_STATS
+    // Accumulated over every reduction of this net; ic_net_reset keeps it
+    ic_stats_t stats;
+#endif
 } ic_net_t;
 
+/**
+ * Get the type of a node
+ */
+static inline ic_node_type_t ic_net_node_type(const ic_net_t *net, int node) {
+    return (ic_node_type_t)net->types[node];
+}
+
+/**
+ * Check whether a node slot holds a live node
+ */
+static inline bool ic_net_node_active(const ic_net_t *net, int node) {
+    return net->active[node] != 0;
+}
+
+/**
+ * Get the node connected to a port (-1 if not connected)
+ */
+static inline int ic_net_port_node(const ic_net_t *net, int node, int port) {
+    ic_wire_t wire = net->wires[3 * (size_t)node + port];
+    return (wire == IC_WIRE_NONE) ? -1 : IC_WIRE_NODE(wire);
+}
+
+/**
+ * Get which port of the connected node a port is wired to (-1 if not connected)
+ */
+static inline int ic_net_port_port(const ic_net_t *net, int node, int port) {
+    ic_wire_t wire = net->wires[3 * (size_t)node + port];
+    return (wire == IC_WIRE_NONE) ? -1 : IC_WIRE_PORT(wire);
+}
+
 /**
  * Create a new IC net with the given maximum nodes and gas limit
+ * @return The net, or NULL if max_nodes is above IC_NET_MAX_NODES or
+ *         memory ran out
  */
 ic_net_t *ic_net_create(size_t max_nodes, size_t gas_limit);
 
+/**
+ * Empty a net so it can be rebuilt without reallocating its storage.
+ * Keeps max_nodes, gas_limit, input_number and the goal; clears nodes, gas
+ * and factors.
+ */
+void ic_net_reset(ic_net_t *net);
+
 /**
  * Free an IC net
  */
 void ic_net_free(ic_net_t *net);
 
+/**
+ * Choose whether queued redexes are rewritten FIFO (default) or LIFO
+ */
+void ic_net_set_redex_order(ic_net_t *net, ic_redex_order_t order);
+
+/**
+ * Recycle the slots of erased nodes through the free list (off by default)
+ * Off, every new node takes the next slot until max_nodes are used, as
+ * the original reducer did. On, a reduction never occupies more than a few
+ * slots beyond its live nodes and can run for its whole gas budget. Factors
+ * are read from slot positions, so reuse changes which factors a net
+ * reports; ic_net_reset keeps the setting.
+ */
+void ic_net_set_slot_reuse(ic_net_t *net, bool reuse);
+
+// Rewrites between state samples when a search enables loop detection
+#define IC_LOOP_CHECK_INTERVAL_DEFAULT 64
+
+/**
+ * Sample the net's state every `interval` rewrites during reduction to
+ * detect nets that loop (0 turns detection off, the default). See
+ * ic_net_reduce for what happens when a loop is found. A heap net also
+ * reserves room for a saved state of all its slots here, so reductions
+ * do not allocate for it.
+ */
+void ic_net_set_loop_check(ic_net_t *net, size_t interval);
+
+/**
+ * Make net->loop_state hold at least `slots` slots and `queued` redexes
+ * Its contents are not kept when it grows.
+ * @return 0 on success, -1 if out of memory or the storage is borrowed
+ *         and too small
+ */
+int ic_net_reserve_loop_state(ic_net_t *net, size_t slots, size_t queued);
+
+// Smallest used_nodes at which ic_net_reduce considers compacting
+#define IC_COMPACT_MIN_SLOTS 64
+
+/**
+ * Compact the net during ic_net_reduce whenever fewer than live_percent
+ * percent of its used slots (and at least IC_COMPACT_MIN_SLOTS) hold live
+ * nodes; 0 turns compaction off, the default. Factors are read from slot
+ * positions, so a net compacted before it stops can report different
+ * factors; the search never enables it.
+ */
+void ic_net_set_compaction(ic_net_t *net, unsigned live_percent);
+
+/**
+ * Move the live nodes to the front of the node arrays, keeping their
+ * order, renumber every wire and queued redex, and empty the free list
+ * Wires into erased slots are disconnected.
+ * @return Slots reclaimed (used_nodes before minus after), 0 if there
+ *         were no holes or the renumbering table could not be allocated
+ */
+size_t ic_net_compact(ic_net_t *net);
+
+/**
+ * Prepare a detector for a reduction of net starting at gas 0
+ */
+void ic_loop_detector_init(ic_loop_detector_t *detector, const ic_net_t *net);
+
+/**
+ * Sample the net's state and compare it with the saved one. When a loop
+ * is found, gas_used jumps forward by as many whole periods as fit in the
+ * remaining gas, so the rest of the reduction ends in the same state as a
+ * full run would. A sample whose hash matches is compared slot by slot
+ * with net->loop_state first, so a hash collision never skips gas; if no
+ * state can be saved (out of memory), no loop is ever reported.
+ * @return true if a loop was found by this call
+ */
+bool ic_loop_detector_sample(ic_loop_detector_t *detector, ic_net_t *net);
+
+/**
+ * Called by reducers after every rewrite; samples once per interval
+ * @return true if a loop was found by this call
+ */
+static inline bool ic_loop_detector_step(ic_loop_detector_t *detector, ic_net_t *net) {
+    if (net->gas_used != detector->next_sample) return false;
+    return ic_loop_detector_sample(detector, net);
+}
+
+/**
+ * Hash the complete reduction state: node layout (ic_net_hash) plus the
+ * queued redexes in order. Equal states reduce identically from there on.
+ */
+uint64_t ic_net_state_hash(const ic_net_t *net);
+
+/**
+ * What a reduction is looking for
+ * `reached` decides, once a reduction stops, whether the net meets the
+ * goal, and records what it found in the net. `impossible`, if set, proves
+ * that the net can no longer meet it whatever rewrites follow; reducers ask
+ * it before the first rewrite and then every `poll_interval` rewrites
+ * (0 = only before the first), and stop a hopeless net at once.
+ */
+struct ic_goal {
+    bool (*reached)(const ic_goal_t *goal, ic_net_t *net);
+    bool (*impossible)(const ic_goal_t *goal, const ic_net_t *net);
+    size_t poll_interval;
+    int target;  // Parameter of the goal, e.g. the number to factor
+};
+
+/**
+ * Goal of factoring N: one δ and one γ survive and their factor pair
+ * (ic_net_factor_pair) multiplies to N; N = 0 accepts any pair.
+ * It is impossible when the net has an even number of δ or of γ: δδ and
+ * γγ erase two of a kind, δγ replaces one of each and ε erases only
+ * itself, so neither count ever grows or changes parity.
+ */
+ic_goal_t ic_goal_factor(int N);
+
+/**
+ * Give the net a goal for its reductions (NULL for none); the goal is not
+ * copied and must outlive them. Without a goal, a net with input_number
+ * set is checked against ic_goal_factor(input_number).
+ */
+void ic_net_set_goal(ic_net_t *net, const ic_goal_t *goal);
+
+/**
+ * Check whether a goal is already out of reach for the net
+ */
+static inline bool ic_goal_impossible(const ic_goal_t *goal, const ic_net_t *net) {
+    return goal && goal->impossible && goal->impossible(goal, net);
+}
+
+/**
+ * When a reduction next asks its goal whether it is still reachable
+ */
+typedef struct {
+    const ic_goal_t *goal;
+    size_t next_poll;  // gas_used at which to ask, SIZE_MAX for never
+} ic_goal_poll_t;
+
+/**
+ * Prepare to poll a goal (which may be NULL) from gas 0
+ */
+static inline void ic_goal_poll_init(ic_goal_poll_t *poll, const ic_goal_t *goal) {
+    poll->goal = goal;
+    poll->next_poll = (goal && goal->impossible) ? 0 : SIZE_MAX;
+}
+
+/**
+ * Called by reducers before every rewrite; asks the goal when it is due
+ * @return true if the goal can no longer be reached
+ */
+static inline bool ic_goal_poll_step(ic_goal_poll_t *poll, const ic_net_t *net) {
+    if (net->gas_used < poll->next_poll) return false;
+    if (poll->goal->impossible(poll->goal, net)) return true;
+    poll->next_poll = (poll->goal->poll_interval > 0)
+        ? net->gas_used + poll->goal->poll_interval : SIZE_MAX;
+    return false;
+}
+
 /**
  * Create a new node in the net of the given type
+ * With slot reuse on, slots erased during reduction are reused before the
+ * net grows.
  * @return The index of the new node, or -1 if no space
  */
 int ic_net_new_node(ic_net_t *net, ic_node_type_t type);
@@ -85,11 +383,46 @@ int ic_net_new_node(ic_net_t *net, ic_node_type_t type);
 void ic_net_connect(ic_net_t *net, int node_a, int port_a, int node_b, int port_b);
 
 /**
- * Run the rewriting until no active pairs remain or gas is exhausted
- * @return 0 if fully reduced, 1 if stopped due to gas limit
+ * Run the rewriting until no active pairs remain, gas is exhausted or the
+ * net's goal is out of reach, then check the goal
+ * With loop detection on, a net whose state repeats skips the remaining
+ * whole periods of its loop; it still ends in the state, and with the
+ * gas_used, of a run to the gas limit, with the skipped rewrites in
+ * gas_skipped.
+ * @return 0 if fully reduced, 1 if stopped due to gas limit, 2 if stopped
+ *         at the gas limit after a loop was detected, 3 if abandoned
+ *         because the goal became impossible (it is then not checked)
  */
 int ic_net_reduce(ic_net_t *net);
 
+// ic_net_reduce_steps' result when the budget ran out before the reduction ended
+#define IC_REDUCE_SUSPENDED 4
+
+/**
+ * Run a reduction for at most `budget` more rewrites
+ * The first call on a net starts a reduction as ic_net_reduce does. If
+ * the budget runs out before the reduction stops, the net keeps its redex
+ * queue and loop detector and the call returns IC_REDUCE_SUSPENDED;
+ * the next call carries on exactly where it left off, so any split of
+ * the rewrites into slices yields ic_net_reduce's result, gas and final
+ * layout. gas_used counts the rewrites of all slices so far and
+ * gas_limit still bounds their total. A loop found in a slice is skipped
+ * to the gas limit at once, as in ic_net_reduce, finishing that slice past
+ * its budget by less than one period. ic_net_reduce and ic_net_reset
+ * discard a suspended reduction.
+ * @return ic_net_reduce's result once the reduction stops, or
+ *         IC_REDUCE_SUSPENDED
+ */
+int ic_net_reduce_steps(ic_net_t *net, size_t budget);
+
+/**
+ * Read the factor pair encoded by a reduced net, independent of any N.
+ * A net encodes a pair when exactly one δ and one γ are left active; the
+ * factors are their slot positions + 1 (δ gives factor_a, γ factor_b).
+ * @return true if the net encodes a pair
+ */
+bool ic_net_factor_pair(const ic_net_t *net, int *factor_a, int *factor_b);
+
 /**
  * Check if the net has found a valid factorization of N
  */
@@ -100,14 +433,50 @@ bool ic_net_has_valid_factor(const ic_net_t *net, int N);
  */
 void ic_net_print(const ic_net_t *net);
 
+/**
+ * Hash the exact node layout of a net: every slot's type, liveness and wires.
+ * Slot positions are part of the hash because the factor check reads them,
+ * so nets with equal hashes (barring 64-bit collisions) reduce identically.
+ */
+uint64_t ic_net_hash(const ic_net_t *net);
+
 /**
  * Get the number of used nodes
  */
 size_t ic_net_get_used_nodes(const ic_net_t *net);
 
+/**
+ * Get the total number of heap allocations made by the runtime so far.
+ * Used to verify that hot loops reuse their nets instead of allocating.
+ */
+size_t ic_net_alloc_count(void);
+
+/**
+ * Bytes of node storage (wires, types and liveness) a net owns, starting
+ * at net->wires; 0 for nets whose storage is borrowed
+ */
+size_t ic_net_storage_bytes(const ic_net_t *net);
+
 /**
  * Export the net to dot format for visualization
  */
 void ic_net_export_dot(const ic_net_t *net, FILE *out);
 
+#ifdef IC_STATS
+/**
+ * Record one finished reduction in the net count and gas histogram
+ */
+void ic_stats_count_reduction(ic_stats_t *stats, size_t gas_used);
+
+/**
+ * Add the counters of `from` to `into`
+ */
+void ic_stats_add(ic_stats_t *into, const ic_stats_t *from);
+
+/**
+ * Print counters and the gas histogram in a human-readable form
+ */
+void ic_stats_print(const ic_stats_t *stats, FILE *out);
+#endif
+
 #endif /* IC_RUNTIME_H */
\ No newline at end of file
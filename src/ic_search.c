@@ -1,337 +1,1141 @@
+#define _POSIX_C_SOURCE 200809L
+
 #include "ic_search.h"
+#include "ic_fixed.h"
+#include "ic_netfile.h"
+#include "ic_solutions.h"
+#include "ic_trace.h"
+#include <inttypes.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
+#include <time.h>
 
 void ic_enum_init(ic_enum_state_t *state, size_t max_nodes) {
     if (!state) return;
     
     state->max_nodes = max_nodes;
     state->current_index = 0;
+    ic_enum_cursor_init(&state->cursor);
     state->progress_cb = NULL;
+    state->progress_interval_ms = IC_PROGRESS_INTERVAL_MS;
+
+    state->dedup = true;
+    state->prune = true;
+    state->loop_check_interval = IC_LOOP_CHECK_INTERVAL_DEFAULT;
+    state->slot_reuse = false;
+    state->threads = 0;
+    state->pin = IC_PIN_NONE;
+    state->numa_local = false;
+    state->pool = NULL;
+    state->dump = NULL;
+    state->dump_pairs = false;
+    state->all_solutions = NULL;
+    
+    state->search_start = 0;
+    state->search_limit = IC_SEARCH_LIMIT_DEFAULT;
+    state->checkpoint_path = NULL;
+    state->checkpoint_interval = IC_CHECKPOINT_INTERVAL_DEFAULT;
+    state->resume = false;
+    state->resumed_from = 0;
+    
+    state->indices_searched = 0;
+    state->indices_deduplicated = 0;
+    state->rewrites = 0;
+    state->loops_detected = 0;
+    state->nets_abandoned = 0;
+    state->indices_pruned = 0;
+    state->distinct_nets = 0;
+    state->loop_allocations = 0;
+    state->fixed_capacity = 0;
+    state->threads_used = 0;
+    state->threads_pinned = 0;
+    state->nets_dumped = 0;
+    state->solutions_written = 0;
+    state->writer_stalls = 0;
 }
 
-void ic_enum_set_progress_callback(ic_enum_state_t *state,
-                                  void (*callback)(size_t current_index, bool found_solution)) {
+void ic_enum_set_dedup(ic_enum_state_t *state, bool enabled) {
     if (!state) return;
-    state->progress_cb = callback;
+    state->dedup = enabled;
 }
 
-int ic_enum_build_net(ic_enum_state_t *state, size_t index, ic_net_t *net) {
-    if (!state || !net) return -1;
-    
-    // Fast reset - just setting used_nodes to 0 is most important
-    net->used_nodes = 0;
-    net->gas_used = 0;
-    net->factor_found = false;
+void ic_enum_set_prune(ic_enum_state_t *state, bool enabled) {
+    if (!state) return;
+    state->prune = enabled;
+}
+
+void ic_enum_set_loop_check(ic_enum_state_t *state, size_t interval) {
+    if (!state) return;
+    state->loop_check_interval = interval;
+}
+
+void ic_enum_set_slot_reuse(ic_enum_state_t *state, bool enabled) {
+    if (!state) return;
+    state->slot_reuse = enabled;
+}
+
+void ic_enum_set_threads(ic_enum_state_t *state, int threads) {
+    if (!state) return;
+    state->threads = (threads > 0) ? threads : 0;
+}
+
+void ic_enum_set_placement(ic_enum_state_t *state, ic_pin_mode_t pin, bool numa_local) {
+    if (!state) return;
+    state->pin = pin;
+    state->numa_local = numa_local;
+}
+
+void ic_enum_set_pool(ic_enum_state_t *state, ic_search_pool_t *pool) {
+    if (!state) return;
+    state->pool = pool;
+}
+
+void ic_search_pool_init(ic_search_pool_t *pool) {
+    if (!pool) return;
+    pool->nets = NULL;
+    pool->capacity = 0;
+    pool->nets_created = 0;
+    pool->nets_reused = 0;
+}
+
+void ic_search_pool_destroy(ic_search_pool_t *pool) {
+    if (!pool) return;
+    for (int t = 0; t < pool->capacity; t++) {
+        ic_net_free(pool->nets[t]);
+    }
+    free(pool->nets);
+    ic_search_pool_init(pool);
+}
+
+/**
+ * Make room for `threads` thread ids before a search starts
+ * @return 0 on success, -1 if out of memory
+ */
+static int ic_search_pool_reserve(ic_search_pool_t *pool, int threads) {
+    if (threads <= pool->capacity) return 0;
+    ic_net_t **nets = (ic_net_t**)realloc(pool->nets, (size_t)threads * sizeof(ic_net_t*));
+    if (!nets) return -1;
+    for (int t = pool->capacity; t < threads; t++) nets[t] = NULL;
+    pool->nets = nets;
+    pool->capacity = threads;
+    return 0;
+}
+
+/**
+ * Thread `thread_id`'s net for a search, reset as if just created
+ * @return The net, or NULL if it could not be created
+ */
+static ic_net_t *ic_search_pool_take(ic_search_pool_t *pool, int thread_id,
+                                     size_t max_nodes, size_t gas_limit) {
+    ic_net_t *net = pool->nets[thread_id];
+    if (net && net->max_nodes == max_nodes) {
+        // Drop what the last search left in it
+        ic_net_reset(net);
+        net->gas_limit = gas_limit;
+        net->input_number = 0;
+        ic_net_set_goal(net, NULL);
+#ifdef IC_STATS
+        memset(&net->stats, 0, sizeof(net->stats));
+#endif
+        #pragma omp atomic
+        pool->nets_reused++;
+        return net;
+    }
     
-    // Limit net size for performance
-    // Small nets are more likely to have useful computational behavior
-    size_t max_net_size = 10; // Small nets are faster to evaluate
-    size_t num_nodes = 3 + (index % max_net_size);
+    ic_net_free(net);
+    net = ic_net_create(max_nodes, gas_limit);
+    pool->nets[thread_id] = net;
+    if (net) {
+        #pragma omp atomic
+        pool->nets_created++;
+    }
+    return net;
+}
+
+void ic_enum_set_dump(ic_enum_state_t *state, FILE *out, bool all_pairs) {
+    if (!state) return;
+    state->dump = out;
+    state->dump_pairs = all_pairs;
+}
+
+void ic_enum_set_all_solutions(ic_enum_state_t *state, FILE *out) {
+    if (!state) return;
+    state->all_solutions = out;
+}
+
+void ic_enum_set_search_limit(ic_enum_state_t *state, uint64_t limit) {
+    if (!state) return;
+    state->search_limit = limit;
+}
+
+void ic_enum_set_range(ic_enum_state_t *state, uint64_t start, uint64_t end) {
+    if (!state) return;
+    state->search_start = start;
+    state->search_limit = end;
+}
+
+int ic_enum_set_shard(ic_enum_state_t *state, uint64_t k, uint64_t n) {
+    if (!state || k >= n) return -1;
     
-    // Extract some randomization bits from the index
-    unsigned int pattern = index / max_net_size;
+    // Spread the remainder over the first shards; no product can overflow
+    uint64_t start = state->search_start;
+    uint64_t length = (state->search_limit > start) ? state->search_limit - start : 0;
+    uint64_t base = length / n;
+    uint64_t extra = length % n;
+    uint64_t shard_start = start + k * base + (k < extra ? k : extra);
+    uint64_t shard_length = base + (k < extra ? 1 : 0);
     
-    // Ensure we have at least one active pair (principal-principal connection)
-    bool has_active_pair = false;
+    ic_enum_set_range(state, shard_start, shard_start + shard_length);
+    return 0;
+}
+
+void ic_enum_set_checkpoint(ic_enum_state_t *state, const char *path,
+                            uint64_t interval, bool resume) {
+    if (!state) return;
+    state->checkpoint_path = path;
+    state->checkpoint_interval = interval;
+    state->resume = resume;
+}
+
+void ic_enum_set_progress_callback(ic_enum_state_t *state,
+                                  void (*callback)(size_t current_index, bool found_solution,
+                                                   const ic_search_progress_t *progress)) {
+    if (!state) return;
+    state->progress_cb = callback;
+}
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+/**
+ * Build the net for one index from the thread's cursor, unless the dedup
+ * table says a smaller index builds the same layout
+ * The layout is claimed before anything is built (ic_enum_layout_id), so
+ * a duplicate costs neither a patch, a copy nor a hash.
+ * @return true if the net was built and no smaller index builds it
+ */
+static bool prepare_index(ic_enum_cursor_t *cursor, ic_net_t *net, uint64_t index,
+                          ic_enum_seen_t *seen, bool *duplicate) {
+    *duplicate = false;
     
-    // Directly create a delta-gamma active pair for factorization
-    int delta_node = ic_net_new_node(net, IC_NODE_DELTA);
-    int gamma_node = ic_net_new_node(net, IC_NODE_GAMMA);
+    // No input number: the reducer skips its own factor check
+    net->input_number = 0;
+    if (ic_enum_net_size(index) > net->max_nodes) {
+        return false;
+    }
     
-    if (delta_node < 0 || gamma_node < 0) {
-        return -1; // Out of space
+    // The outcome depends only on the net, so a duplicate cannot do better
+    if (seen && ic_enum_seen_claim(seen, index)) {
+        *duplicate = true;
+        return false;
     }
     
-    // Connect principal ports to create active pair - guarantees computation
-    ic_net_connect(net, delta_node, 0, gamma_node, 0);
-    has_active_pair = true;
+    // Patch the pristine net of this size class (the target is reset)
+    ic_enum_cursor_copy(ic_enum_cursor_seek(cursor, index), net);
+    return true;
+}
+
+/**
+ * Factor pair of a layout a thread has reduced, by ic_enum_layout_id
+ */
+typedef struct {
+    bool reduced;
+    int32_t factor_a;  // 0 if the net ended without a pair
+    int32_t factor_b;
+} ic_pair_cache_slot_t;
+
+/**
+ * Nets owned by one search thread
+ * The heap net can hold max_nodes; when enumerated nets provably fit a
+ * fixed net, they are built and reduced in `fixed` on the thread's stack.
+ */
+typedef struct {
+    ic_net_t *net;
+    ic_enum_cursor_t cursor; // Builds every net the thread evaluates
+    ic_pair_cache_slot_t *pairs;  // Pairs of reduced nets when every solution
+                                  // is wanted, NULL otherwise
+    size_t fixed_capacity;  // Capacity of `fixed` in use, 0 if none fits
+    union {
+        ic_net16_t n16;
+        ic_net32_t n32;
+        ic_net64_t n64;
+    } fixed;
+} ic_search_nets_t;
+
+/**
+ * Fixed net capacity for enumerated nets of at most max_nodes nodes
+ * Without slot reuse a reduction can fill all max_nodes slots; with it,
+ * no enumerated net occupies more than IC_ENUM_MAX_SLOTS.
+ */
+static size_t ic_search_fixed_capacity(size_t max_nodes, bool slot_reuse) {
+    if (slot_reuse && max_nodes > IC_ENUM_MAX_SLOTS) return ic_fixed_capacity(IC_ENUM_MAX_SLOTS);
+    return ic_fixed_capacity(max_nodes);
+}
+
+/**
+ * The net indices are built in: the fixed net if there is one
+ */
+static ic_net_t *ic_search_nets_build_target(ic_search_nets_t *nets) {
+    switch (nets->fixed_capacity) {
+        case 16: return &nets->fixed.n16.net;
+        case 32: return &nets->fixed.n32.net;
+        case 64: return &nets->fixed.n64.net;
+        default: return nets->net;
+    }
+}
+
+static void ic_search_nets_init(ic_search_nets_t *nets, size_t max_nodes, size_t gas_limit,
+                                bool slot_reuse) {
+    ic_enum_cursor_init(&nets->cursor);
+    nets->pairs = NULL;
+    nets->fixed_capacity = ic_search_fixed_capacity(max_nodes, slot_reuse);
+    switch (nets->fixed_capacity) {
+        case 16: ic_net16_init(&nets->fixed.n16, max_nodes, gas_limit); break;
+        case 32: ic_net32_init(&nets->fixed.n32, max_nodes, gas_limit); break;
+        case 64: ic_net64_init(&nets->fixed.n64, max_nodes, gas_limit); break;
+        default: break;
+    }
+    ic_net_set_slot_reuse(nets->net, slot_reuse);
+    ic_net_set_slot_reuse(ic_search_nets_build_target(nets), slot_reuse);
+}
+
+/**
+ * Build, deduplicate and reduce the net for one index
+ * Each thread calls this with its own long-lived nets, which are rebuilt
+ * in place so the search loop never touches the allocator. If `seen` is
+ * set, nets already claimed by a smaller index are skipped without
+ * reducing. Reduction does not depend on the number being factored, so the
+ * result is the net's factor pair, which can then be tested against any
+ * target. *reduced is set to the net holding the outcome and *status to
+ * its ic_net_reduce result (-1 if the net was not reduced). With a pair
+ * cache, a net the thread has reduced before is not reduced again: it
+ * counts as a duplicate but still reports its cached pair.
+ * @return true if the reduced net encodes a factor pair (*factor_a, *factor_b)
+ */
+static bool evaluate_index(ic_search_nets_t *nets, uint64_t index, ic_enum_seen_t *seen,
+                           bool *duplicate, int *factor_a, int *factor_b,
+                           const ic_net_t **reduced, int *status) {
+    ic_net_t *net = ic_search_nets_build_target(nets);
+    *reduced = net;
+    *status = -1;
     
-    // Generate the rest of the nodes with fast pattern-based distribution
-    for (size_t n = 2; n < num_nodes; n++) {
-        // Fast node type selection based on bit pattern
-        ic_node_type_t type;
-        unsigned int bit = (pattern >> (n % 16)) & 0x3; // Use 2 bits
-        
-        if (bit == 0) {
-            type = IC_NODE_DELTA;
-        } else if (bit == 1) {
-            type = IC_NODE_GAMMA;
-        } else {
-            type = IC_NODE_EPSILON;
-        }
-        
-        int new_idx = ic_net_new_node(net, type);
-        if (new_idx < 0) {
-            return -1; // Out of space
+    // A layout this thread has already reduced ends the same way again
+    ic_pair_cache_slot_t *cached = NULL;
+    if (nets->pairs && ic_enum_net_size(index) <= net->max_nodes) {
+        cached = &nets->pairs[ic_enum_layout_id(index)];
+        if (cached->reduced) {
+            *duplicate = true;
+            *factor_a = cached->factor_a;
+            *factor_b = cached->factor_b;
+            return cached->factor_a > 0;
         }
     }
+    if (!prepare_index(&nets->cursor, net, index, seen, duplicate)) {
+        return false;
+    }
     
-    // Fast bit-pattern based connection scheme
-    // Form a cycle to ensure all ports are connected
-    for (size_t i = 0; i < net->used_nodes; i++) {
-        // Connect auxiliary ports to next/prev nodes to form a ring
-        size_t next = (i + 1) % net->used_nodes;
-        size_t prev = (i + net->used_nodes - 1) % net->used_nodes;
-        
-        // Skip principal ports that are already connected in active pair
-        if (i == 0 || i == 1) {
-            // Connect auxiliary ports only
-            ic_net_connect(net, i, 1, next, 2);
-            ic_net_connect(net, i, 2, prev, 1);
-        } else {
-            // For other nodes, connect all ports
-            ic_net_connect(net, i, 0, (i + 2) % net->used_nodes, 0);
-            ic_net_connect(net, i, 1, next, 2);
-            ic_net_connect(net, i, 2, prev, 1);
-        }
+    // Reduce it with the specialized reducer, falling back to the heap net
+    // in the rare case the net outgrows the fixed one
+    IC_TRACE_EVENT(IC_TRACE_INDEX_BEGIN, 0, index, 0);
+    switch (nets->fixed_capacity) {
+        case 16: *status = ic_net16_reduce(&nets->fixed.n16); break;
+        case 32: *status = ic_net32_reduce(&nets->fixed.n32); break;
+        case 64: *status = ic_net64_reduce(&nets->fixed.n64); break;
+        default: *status = ic_net_reduce(net); break;
     }
+    if (*status == -1) {
+        net = nets->net;
+        *reduced = net;
+        net->input_number = 0;
+        ic_enum_build_net_compatible(NULL, index, net);
+        *status = ic_net_reduce(net);
+    }
+    IC_TRACE_EVENT(IC_TRACE_INDEX_END, (unsigned)*status, index,
+                   (net->gas_used < UINT32_MAX) ? (uint32_t)net->gas_used : UINT32_MAX);
     
-    // We know all ports are connected and we have an active pair
-    return 0;
+    // Read the factor pair it encodes, if any; an abandoned net has none
+    bool has_pair = *status != 3 && ic_net_factor_pair(net, factor_a, factor_b);
+    if (cached) {
+        cached->reduced = true;
+        cached->factor_a = has_pair ? *factor_a : 0;
+        cached->factor_b = has_pair ? *factor_b : 0;
+    }
+    return has_pair;
 }
 
-int ic_enum_next(ic_enum_state_t *state, ic_net_t *net) {
-    if (!state || !net) return 0;
+/**
+ * Number being factored by a search, with the best solution found so far
+ */
+typedef struct {
+    int N;
+    uint64_t solution;  // Smallest solving index found (UINT64_MAX if none yet)
+    int factor_a;
+    int factor_b;
+} ic_target_t;
+
+static int ic_target_compare(const void *a, const void *b) {
+    int na = ((const ic_target_t*)a)->N;
+    int nb = ((const ic_target_t*)b)->N;
+    return (na > nb) - (na < nb);
+}
+
+static ic_target_t *ic_target_find(ic_target_t *targets, size_t count, int N) {
+    ic_target_t key = { .N = N };
+    return (ic_target_t*)bsearch(&key, targets, count, sizeof(ic_target_t), ic_target_compare);
+}
+
+/**
+ * State shared by the threads of one search
+ * Indices are handed out in ascending chunks from `next`. `cutoff` is the
+ * first index that no target needs: UINT64_MAX while any target is
+ * pending, then the largest solution. Targets that no enumerated net can
+ * factor never count as pending. Solutions only ever decrease, so
+ * every index below a target's final solution is evaluated and each
+ * target gets its smallest solving index whatever the thread timing.
+ */
+typedef struct {
+    ic_target_t *targets;
+    size_t count;
+    size_t unsolved;           // Pending targets; guarded by the ic_search_targets critical section
+    size_t min_net_size;       // Smaller nets cannot factor any pending target
+    _Atomic uint64_t next;     // First index not yet handed out
+    _Atomic uint64_t cutoff;   // Threads stop at this index
+    _Atomic uint64_t solutions;      // Improvements so far, for progress reports
+    _Atomic uint64_t last_solution;  // Index of the latest improvement
+    ic_solution_writer_t *writer;    // Takes every solution when all are wanted, or NULL
+    FILE *dump;                      // Stream for reduced nets, or NULL
+    bool dump_pairs;                 // Dump every net with a pair, not just improvements
+    _Atomic uint64_t dumped;         // Records written to `dump`
+} ic_search_shared_t;
+
+/**
+ * First index past every target's solution (0 if none is solved), where a
+ * search with no pending target can stop
+ */
+static uint64_t ic_search_final_cutoff(const ic_target_t *targets, size_t count) {
+    uint64_t cutoff = 0;
+    for (size_t t = 0; t < count; t++) {
+        if (targets[t].solution != UINT64_MAX && targets[t].solution + 1 > cutoff) {
+            cutoff = targets[t].solution + 1;
+        }
+    }
+    return cutoff;
+}
+
+/**
+ * Offer a reduced net's factor pair to the target it factors, if any
+ * @return true if this index is now that target's best solution
+ */
+static bool ic_target_offer(ic_search_shared_t *shared, uint64_t index,
+                            int factor_a, int factor_b) {
+    ic_target_t *target = ic_target_find(shared->targets, shared->count, factor_a * factor_b);
+    if (!target) return false;
     
-    // With our optimized algorithm, almost all builds succeed
-    // So we can simply increment and try once
-    if (ic_enum_build_net(state, state->current_index, net) == 0) {
-        state->current_index++;
-        return 1;
+    // Every solution goes to the writer, improving or not
+    if (shared->writer) {
+        ic_solution_t solution = { .index = index, .N = target->N,
+                                   .factor_a = factor_a, .factor_b = factor_b };
+        ic_solution_writer_submit(shared->writer, &solution);
     }
     
-    // If build fails, we're likely at the end of our space
-    state->current_index++;
-    return 0;
+    // Cheap check first; most offers lose to an earlier solution
+    uint64_t best;
+    #pragma omp atomic read
+    best = target->solution;
+    if (index >= best) return false;
+    
+    bool improved = false;
+    #pragma omp critical(ic_search_targets)
+    {
+        if (index < target->solution) {
+            if (target->solution == UINT64_MAX) {
+                shared->unsolved--;
+            }
+            #pragma omp atomic write
+            target->solution = index;
+            target->factor_a = factor_a;
+            target->factor_b = factor_b;
+            improved = true;
+            atomic_store_explicit(&shared->last_solution, index, memory_order_relaxed);
+            atomic_fetch_add_explicit(&shared->solutions, 1, memory_order_release);
+            
+            // Once all are solved, nothing past the largest solution
+            // matters, unless every solution is wanted
+            if (shared->unsolved == 0 && !shared->writer) {
+                atomic_store_explicit(&shared->cutoff,
+                                      ic_search_final_cutoff(shared->targets, shared->count),
+                                      memory_order_relaxed);
+            }
+        }
+    }
+    return improved;
 }
 
-#ifdef _OPENMP
-#include <omp.h>
-#endif
+/**
+ * Write a reduced net to the search's dump if it just improved a target,
+ * or with dump_pairs whenever it had a factor pair to offer
+ */
+static void ic_search_dump(ic_search_shared_t *shared, const ic_net_t *net, uint64_t index,
+                           int status, bool improved) {
+    if (!shared->dump || !(improved || shared->dump_pairs)) return;
+    if (ic_net_write(shared->dump, net, index, status) == 0) {
+        atomic_fetch_add_explicit(&shared->dumped, 1, memory_order_relaxed);
+    }
+}
 
 /**
- * Build and check a net for the given index to see if it can factor N
- * Each thread will use this function to work on its assigned indices
- * @return The index if a valid factor was found, -1 otherwise
+ * Write the completed frontier and every target's state to a checkpoint
+ * The file is written next to `path` and renamed over it, so a search that
+ * is killed mid-write leaves the previous checkpoint intact.
+ * @return 0 on success, -1 on error
  */
-static int build_and_check(int N, size_t index, size_t max_nodes, size_t gas_limit) {
-    // Create a thread-local net
-    ic_net_t *net = ic_net_create(max_nodes, gas_limit);
-    if (!net) return -1;
-    
-    // Set the input number to factor
-    net->input_number = N;
-    
-    // Build the net for this index
-    if (ic_enum_build_net_compatible(NULL, index, net) != 0) {
-        ic_net_free(net);
+static int ic_checkpoint_write(const char *path, const ic_enum_state_t *state,
+                               size_t max_nodes, size_t gas_limit, uint64_t frontier,
+                               const ic_target_t *targets, size_t count) {
+    char tmp_path[4096];
+    if (snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path) >= (int)sizeof(tmp_path)) {
         return -1;
     }
     
-    // Reduce it
-    ic_net_reduce(net);
+    FILE *out = fopen(tmp_path, "w");
+    if (!out) return -1;
     
-    // Check if it found valid factors
-    int result = -1;
-    if (ic_net_has_valid_factor(net, N)) {
-        result = index;
+    fprintf(out, "icsearch-checkpoint 1\n");
+    fprintf(out, "max_nodes %zu\n", max_nodes);
+    fprintf(out, "gas_limit %zu\n", gas_limit);
+    fprintf(out, "range %" PRIu64 " %" PRIu64 "\n", state->search_start, state->search_limit);
+    fprintf(out, "frontier %" PRIu64 "\n", frontier);
+    for (size_t t = 0; t < count; t++) {
+        int64_t solution = (targets[t].solution == UINT64_MAX) ? -1 : (int64_t)targets[t].solution;
+        fprintf(out, "target %d %" PRId64 " %d %d\n", targets[t].N, solution,
+                targets[t].factor_a, targets[t].factor_b);
     }
     
-    // Clean up
-    ic_net_free(net);
-    
-    return result;
+    if (fclose(out) != 0) {
+        remove(tmp_path);
+        return -1;
+    }
+    return rename(tmp_path, path) == 0 ? 0 : -1;
 }
 
 /**
- * Version of ic_enum_build_net that doesn't rely on state
- * Used in parallel search to avoid state dependencies
+ * Restore the frontier and target solutions saved by ic_checkpoint_write
+ * The checkpoint must come from a search with the same max_nodes,
+ * gas_limit and range start that covered every target currently being
+ * searched. The range end may differ, so a finished search can be extended.
+ * @return 0 on success, -1 if missing, malformed or from another search
  */
-int ic_enum_build_net_compatible(ic_enum_state_t *state, size_t index, ic_net_t *net) {
-    if (!net) return -1;
+static int ic_checkpoint_read(const char *path, const ic_enum_state_t *state,
+                              size_t max_nodes, size_t gas_limit, uint64_t *frontier,
+                              ic_target_t *targets, size_t count) {
+    FILE *in = fopen(path, "r");
+    if (!in) return -1;
     
-    // Fast reset
-    net->used_nodes = 0;
-    net->gas_used = 0;
-    net->factor_found = false;
+    int version = 0;
+    size_t saved_nodes = 0, saved_gas = 0;
+    uint64_t saved_start = 0, saved_end = 0, saved_frontier = 0;
+    if (fscanf(in, "icsearch-checkpoint %d max_nodes %zu gas_limit %zu range %" SCNu64 " %" SCNu64
+               " frontier %" SCNu64, &version, &saved_nodes, &saved_gas,
+               &saved_start, &saved_end, &saved_frontier) != 6 ||
+        version != 1 || saved_nodes != max_nodes || saved_gas != gas_limit ||
+        saved_start != state->search_start) {
+        fclose(in);
+        return -1;
+    }
     
-    // Limit net size for performance
-    size_t max_net_size = 10; // Small nets are faster to evaluate
-    size_t num_nodes = 3 + (index % max_net_size);
+    // Work on a copy so a rejected checkpoint leaves the targets untouched
+    ic_target_t *restored = (ic_target_t*)malloc(count * sizeof(ic_target_t));
+    bool *covered = (bool*)calloc(count, sizeof(bool));
+    if (!restored || !covered) {
+        free(restored);
+        free(covered);
+        fclose(in);
+        return -1;
+    }
+    memcpy(restored, targets, count * sizeof(ic_target_t));
     
-    // Extract some randomization bits from the index
-    unsigned int pattern = index / max_net_size;
+    int N, factor_a, factor_b;
+    int64_t solution;
+    while (fscanf(in, " target %d %" SCNd64 " %d %d", &N, &solution, &factor_a, &factor_b) == 4) {
+        ic_target_t *target = ic_target_find(restored, count, N);
+        if (!target) continue;
+        
+        covered[target - restored] = true;
+        if (solution >= 0) {
+            target->solution = (uint64_t)solution;
+            target->factor_a = factor_a;
+            target->factor_b = factor_b;
+        }
+    }
+    fclose(in);
     
-    // Directly create a delta-gamma active pair for factorization
-    int delta_node = ic_net_new_node(net, IC_NODE_DELTA);
-    int gamma_node = ic_net_new_node(net, IC_NODE_GAMMA);
+    // Indices before the frontier were never tested against new targets
+    bool complete = true;
+    for (size_t t = 0; t < count; t++) {
+        complete = complete && covered[t];
+    }
     
-    if (delta_node < 0 || gamma_node < 0) {
-        return -1; // Out of space
+    if (complete) {
+        memcpy(targets, restored, count * sizeof(ic_target_t));
+        *frontier = saved_frontier;
+    }
+    free(restored);
+    free(covered);
+    return complete ? 0 : -1;
+}
+
+/**
+ * Counters of one search thread, alone on its cache line so that no two
+ * threads ever write the same line. Only the owning thread stores to them;
+ * the reporter reads them with relaxed loads, so neither side takes a lock.
+ */
+typedef struct {
+    _Alignas(64) _Atomic uint64_t indices;
+    _Atomic uint64_t deduplicated;
+    _Atomic uint64_t rewrites;
+    _Atomic uint64_t loops;
+    _Atomic uint64_t abandoned;
+    _Atomic uint64_t pruned;
+    _Atomic uint64_t working;  // No index below this is still to be offered by
+                               // the thread, UINT64_MAX once it is done
+} ic_thread_counters_t;
+
+static inline void ic_counter_add(_Atomic uint64_t *counter, uint64_t amount) {
+    // Single writer: a plain load and store, no read-modify-write needed
+    uint64_t value = atomic_load_explicit(counter, memory_order_relaxed);
+    atomic_store_explicit(counter, value + amount, memory_order_relaxed);
+}
+
+/**
+ * Count a finished reduction with the given ic_net_reduce status: only
+ * rewrites actually performed count, not those skipped as a loop's repeats
+ */
+static inline void ic_search_count_reduction(ic_thread_counters_t *mine, const ic_net_t *net,
+                                             int status) {
+    ic_counter_add(&mine->rewrites, net->gas_used - net->gas_skipped);
+    if (status == 2) {
+        ic_counter_add(&mine->loops, 1);
+    } else if (status == 3) {
+        ic_counter_add(&mine->abandoned, 1);
+    }
+}
+
+/**
+ * Search threads as the solution writer sees them
+ */
+typedef struct {
+    ic_thread_counters_t *counters;
+    int threads;
+} ic_search_frontier_t;
+
+/**
+ * Smallest index a search thread may still offer: the writer's frontier
+ * A thread publishes each chunk before it offers anything from it, and
+ * chunks are handed out in ascending order, so no solution below the
+ * frontier can arrive after it was read.
+ */
+static uint64_t ic_search_frontier(void *context) {
+    const ic_search_frontier_t *frontier = (const ic_search_frontier_t*)context;
+    uint64_t lowest = UINT64_MAX;
+    for (int t = 0; t < frontier->threads; t++) {
+        uint64_t working = atomic_load_explicit(&frontier->counters[t].working, memory_order_acquire);
+        if (working < lowest) lowest = working;
+    }
+    return lowest;
+}
+
+/**
+ * Publish that the thread offers nothing below `index` from now on, then
+ * wait until that is within IC_SOLUTION_WINDOW of the slowest thread
+ * The release store also publishes every solution queued before it.
+ */
+static void ic_search_advance(const ic_search_frontier_t *frontier, ic_thread_counters_t *mine,
+                              uint64_t index) {
+    atomic_store_explicit(&mine->working, index, memory_order_release);
+    while (index - ic_search_frontier((void*)frontier) >= IC_SOLUTION_WINDOW) {
+        sched_yield();
+    }
+}
+
+/**
+ * Dedicated thread that aggregates the per-thread counters and calls the
+ * progress callback at a fixed interval
+ */
+typedef struct {
+    ic_enum_state_t *state;
+    ic_search_shared_t *shared;
+    ic_thread_counters_t *counters;
+    int threads;
+    uint64_t limit;
+    struct timespec start_time;
+    uint64_t reported_solutions;  // Only touched by whoever reports
+    _Atomic bool done;
+} ic_reporter_t;
+
+static void ic_reporter_collect(ic_reporter_t *reporter, ic_search_progress_t *progress) {
+    memset(progress, 0, sizeof(*progress));
+    for (int t = 0; t < reporter->threads; t++) {
+        ic_thread_counters_t *c = &reporter->counters[t];
+        progress->indices += atomic_load_explicit(&c->indices, memory_order_relaxed);
+        progress->deduplicated += atomic_load_explicit(&c->deduplicated, memory_order_relaxed);
+        progress->rewrites += atomic_load_explicit(&c->rewrites, memory_order_relaxed);
+        progress->loops += atomic_load_explicit(&c->loops, memory_order_relaxed);
+        progress->abandoned += atomic_load_explicit(&c->abandoned, memory_order_relaxed);
+        progress->pruned += atomic_load_explicit(&c->pruned, memory_order_relaxed);
     }
     
-    // Connect principal ports to create active pair
-    ic_net_connect(net, delta_node, 0, gamma_node, 0);
+    uint64_t next = atomic_load_explicit(&reporter->shared->next, memory_order_relaxed);
+    progress->next_index = (next < reporter->limit) ? next : reporter->limit;
+    progress->solutions = atomic_load_explicit(&reporter->shared->solutions, memory_order_acquire);
+    progress->threads = reporter->threads;
     
-    // Generate the rest of the nodes with fast pattern-based distribution
-    for (size_t n = 2; n < num_nodes; n++) {
-        // Fast node type selection based on bit pattern
-        ic_node_type_t type;
-        unsigned int bit = (pattern >> (n % 16)) & 0x3; // Use 2 bits
-        
-        if (bit == 0) {
-            type = IC_NODE_DELTA;
-        } else if (bit == 1) {
-            type = IC_NODE_GAMMA;
-        } else {
-            type = IC_NODE_EPSILON;
-        }
-        
-        int new_idx = ic_net_new_node(net, type);
-        if (new_idx < 0) {
-            return -1; // Out of space
-        }
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    progress->elapsed = (now.tv_sec - reporter->start_time.tv_sec) +
+                        (now.tv_nsec - reporter->start_time.tv_nsec) / 1000000000.0;
+    if (progress->elapsed > 0.0) {
+        progress->indices_per_sec = progress->indices / progress->elapsed;
+        progress->rewrites_per_sec = progress->rewrites / progress->elapsed;
     }
+}
+
+static void ic_reporter_emit(ic_reporter_t *reporter) {
+    ic_search_progress_t progress;
+    ic_reporter_collect(reporter, &progress);
     
-    // Fast bit-pattern based connection scheme
-    for (size_t i = 0; i < net->used_nodes; i++) {
-        // Connect auxiliary ports to next/prev nodes to form a ring
-        size_t next = (i + 1) % net->used_nodes;
-        size_t prev = (i + net->used_nodes - 1) % net->used_nodes;
+    if (progress.solutions > reporter->reported_solutions) {
+        reporter->reported_solutions = progress.solutions;
+        uint64_t index = atomic_load_explicit(&reporter->shared->last_solution, memory_order_relaxed);
+        reporter->state->progress_cb((size_t)index, true, &progress);
+    }
+    reporter->state->progress_cb((size_t)progress.next_index, false, &progress);
+}
+
+static void *ic_reporter_main(void *arg) {
+    ic_reporter_t *reporter = (ic_reporter_t*)arg;
+    
+    // Sleep in short slices so the search never waits long for us to exit
+    const unsigned slice_ms = 10;
+    unsigned slept_ms = 0;
+    while (!atomic_load(&reporter->done)) {
+        struct timespec pause = { 0, slice_ms * 1000000L };
+        nanosleep(&pause, NULL);
+        slept_ms += slice_ms;
         
-        // Skip principal ports that are already connected in active pair
-        if (i == 0 || i == 1) {
-            // Connect auxiliary ports only
-            ic_net_connect(net, i, 1, next, 2);
-            ic_net_connect(net, i, 2, prev, 1);
-        } else {
-            // For other nodes, connect all ports
-            ic_net_connect(net, i, 0, (i + 2) % net->used_nodes, 0);
-            ic_net_connect(net, i, 1, next, 2);
-            ic_net_connect(net, i, 2, prev, 1);
+        if (slept_ms >= reporter->state->progress_interval_ms && !atomic_load(&reporter->done)) {
+            ic_reporter_emit(reporter);
+            slept_ms = 0;
         }
     }
-    
-    return 0;
+    return NULL;
 }
 
-int ic_search_factor(ic_enum_state_t *state, int N, size_t max_nodes, size_t gas_limit) {
-    if (!state || N <= 1) return -1;
+/**
+ * Enumerate indices once, testing every reduced net against all targets
+ * Targets must be sorted by N and have no duplicates. Each target ends
+ * with its smallest solving index in the range; once every target has a
+ * solution, indices past the largest one are no longer evaluated. With a
+ * checkpoint file the range is searched in blocks of checkpoint_interval
+ * indices, and the frontier is saved after each block completes.
+ * @return Number of targets solved, or -1 if the counters, the solution
+ *         writer or a thread's net could not be allocated
+ */
+static int64_t ic_search_run(ic_enum_state_t *state, ic_target_t *targets, size_t count,
+                             size_t max_nodes, size_t gas_limit) {
+    const uint64_t max_search = state->search_limit;
     
-    // Report progress every chunk_size attempts
-    const size_t progress_chunk = 1000;
-    size_t current_chunk = 0;
+    // Pick up where an earlier run of the same search stopped
+    uint64_t start = state->search_start;
+    uint64_t frontier = 0;
+    state->resumed_from = 0;
+    if (state->checkpoint_path && state->resume &&
+        ic_checkpoint_read(state->checkpoint_path, state, max_nodes, gas_limit,
+                           &frontier, targets, count) == 0 &&
+        frontier > start) {
+        start = frontier;
+        state->resumed_from = frontier;
+    }
     
-    // Set a reasonable search limit
-    const size_t max_search = 1000000; // One million indices
+    // Only targets some net size can factor are pending, and only the
+    // sizes that can factor one of them are built
+    ic_search_shared_t shared = { .targets = targets, .count = count, .unsolved = 0,
+                                  .min_net_size = SIZE_MAX };
+    for (size_t t = 0; t < count; t++) {
+        size_t size = ic_search_min_net_size(targets[t].N, max_nodes, state->slot_reuse);
+        if (targets[t].solution != UINT64_MAX || size == 0) continue;
+        shared.unsolved++;
+        if (size < shared.min_net_size) shared.min_net_size = size;
+    }
+    atomic_init(&shared.next, start);
+    atomic_init(&shared.cutoff, UINT64_MAX);
+    atomic_init(&shared.solutions, 0);
+    atomic_init(&shared.last_solution, 0);
+    shared.dump = state->dump;
+    shared.dump_pairs = state->dump_pairs;
+    atomic_init(&shared.dumped, 0);
     
-    // Track the solution index
-    int solution_index = -1;
+    // A resumed search, or one for unfactorable targets, may have nothing
+    // left to find, unless it is after every solution
+    if (shared.unsolved == 0 && !state->all_solutions) {
+        atomic_store(&shared.cutoff, ic_search_final_cutoff(targets, count));
+    }
+    
+    // Checkpoints happen between blocks; without one the range is one block
+    uint64_t block = max_search;
+    if (state->checkpoint_path && state->checkpoint_interval > 0) {
+        block = state->checkpoint_interval;
+    }
     
+    // Table of nets already claimed by some index, shared by all threads;
+    // searches for every solution must evaluate duplicates too
+    ic_enum_seen_t seen_table;
+    ic_enum_seen_t *seen = NULL;
+    if (state->dedup && !state->all_solutions && ic_enum_seen_init(&seen_table) == 0) {
+        seen = &seen_table;
+    }
+    
+    // One padded counter block per thread that may join the search
 #ifdef _OPENMP
-    // Parallel implementation
-    int found_solution_flag = 0;
+    int max_threads = (state->threads > 0) ? state->threads : omp_get_max_threads();
+#else
+    int max_threads = 1;
+#endif
+    ic_thread_counters_t *counters = (ic_thread_counters_t*)aligned_alloc(
+        _Alignof(ic_thread_counters_t), max_threads * sizeof(ic_thread_counters_t));
+    if (!counters) {
+        if (seen) ic_enum_seen_destroy(seen);
+        return -1;
+    }
+    for (int t = 0; t < max_threads; t++) {
+        atomic_init(&counters[t].indices, 0);
+        atomic_init(&counters[t].deduplicated, 0);
+        atomic_init(&counters[t].rewrites, 0);
+        atomic_init(&counters[t].loops, 0);
+        atomic_init(&counters[t].abandoned, 0);
+        atomic_init(&counters[t].pruned, 0);
+        atomic_init(&counters[t].working, start);
+    }
     
-    #pragma omp parallel
+    // The writer owns the solution stream; threads only queue solutions
+    ic_search_frontier_t threads_view = { .counters = counters, .threads = max_threads };
+    ic_solution_writer_t writer;
+    if (state->all_solutions) {
+        if (ic_solution_writer_start(&writer, state->all_solutions, IC_SOLUTION_QUEUE,
+                                     IC_SOLUTION_WINDOW + IC_SEARCH_CHUNK,
+                                     ic_search_frontier, &threads_view) != 0) {
+            free(counters);
+            if (seen) ic_enum_seen_destroy(seen);
+            return -1;
+        }
+        shared.writer = &writer;
+    }
+    
+    // The reporter only exists when someone is listening
+    ic_reporter_t reporter = {
+        .state = state, .shared = &shared, .counters = counters,
+        .threads = max_threads, .limit = max_search, .reported_solutions = 0,
+    };
+    atomic_init(&reporter.done, false);
+    clock_gettime(CLOCK_MONOTONIC, &reporter.start_time);
+    pthread_t reporter_thread;
+    bool reporter_running = state->progress_cb &&
+        pthread_create(&reporter_thread, NULL, ic_reporter_main, &reporter) == 0;
+    
+    int pool_failed = 0;
+    size_t allocs_before_loop = 0;
+    
+#ifdef IC_STATS
+    memset(&state->stats, 0, sizeof(state->stats));
+#endif
+    state->fixed_capacity = ic_search_fixed_capacity(max_nodes, state->slot_reuse);
+    
+    // NUMA-local nets need their threads to stay on one node
+    ic_pin_mode_t pin = (state->numa_local && state->pin == IC_PIN_NONE) ? IC_PIN_SCATTER : state->pin;
+    ic_topology_t *topology = NULL;
+    if (pin != IC_PIN_NONE) {
+        topology = (ic_topology_t*)malloc(sizeof(ic_topology_t));
+        if (topology) ic_topology_detect(topology);
+    }
+    atomic_int threads_used, threads_pinned;
+    atomic_init(&threads_used, 0);
+    atomic_init(&threads_pinned, 0);
+    ic_search_pool_t *pool = state->pool;
+    if (pool && ic_search_pool_reserve(pool, max_threads) != 0) pool = NULL;
+    
+    #pragma omp parallel num_threads(max_threads)
     {
+#ifdef _OPENMP
         int thread_id = omp_get_thread_num();
-        int num_threads = omp_get_num_threads();
-        int local_solution = -1;
+#else
+        int thread_id = 0;
+#endif
+        ic_thread_counters_t *mine = &counters[thread_id];
+        atomic_fetch_add(&threads_used, 1);
+        IC_TRACE_ATTACH();
         
-        // Create a progress reporting closure 
-        size_t local_chunk = 0;
+        // Pin before the nets exist, so their pages are first touched on
+        // this thread's node
+        ic_cpu_mask_t unpinned;
+        unpinned.saved = false;
+        if (topology) {
+            int slot = ic_topology_slot_for_thread(topology, pin, thread_id);
+            if (ic_topology_pin_self(topology->cpus[slot], &unpinned) == 0) {
+                atomic_fetch_add(&threads_pinned, 1);
+            }
+        }
+        
+        // Each thread owns one net for the whole search
+        ic_search_nets_t nets;
+        ic_net_t *net = pool ? ic_search_pool_take(pool, thread_id, max_nodes, gas_limit)
+                             : ic_net_create(max_nodes, gas_limit);
+        nets.net = net;
+        ic_search_nets_init(&nets, max_nodes, gas_limit, state->slot_reuse);
+        if (shared.writer) {
+            nets.pairs = (ic_pair_cache_slot_t*)calloc(IC_ENUM_LAYOUTS,
+                                                       sizeof(ic_pair_cache_slot_t));
+        }
+        if (net && state->numa_local) {
+            ic_topology_place(net->wires, ic_net_storage_bytes(net), true);
+        }
+        ic_net_set_loop_check(net, state->loop_check_interval);
+        ic_net_set_loop_check(ic_search_nets_build_target(&nets), state->loop_check_interval);
+        
+        // Abandon nets that cannot end with any factor pair; the pair
+        // itself is read once per net and offered to every target
+        ic_goal_t goal = ic_goal_factor(0);
+        goal.reached = NULL;
+        if (state->prune) {
+            ic_net_set_goal(net, &goal);
+            ic_net_set_goal(ic_search_nets_build_target(&nets), &goal);
+        }
+        if (!net) {
+            #pragma omp atomic write
+            pool_failed = 1;
+        }
         
-        // Distribute indices dynamically for better load balancing
-        #pragma omp for schedule(dynamic, 100)
-        for (size_t index = 0; index < max_search; index++) {
-            // Skip if another thread found a solution already
-            if (found_solution_flag) {
-                continue;
+        // Every pool net exists before the loop starts counting allocations
+        // Threads the runtime did not start have nothing left to offer
+        #pragma omp barrier
+        #pragma omp single
+        {
+            allocs_before_loop = ic_net_alloc_count();
+#ifdef _OPENMP
+            for (int t = omp_get_num_threads(); t < max_threads; t++) {
+                atomic_store(&counters[t].working, UINT64_MAX);
             }
+#endif
+        }
+        
+        // Every thread walks the same blocks. The cutoff and `pool_failed`
+        // only change between barriers, so all threads agree when to stop
+        for (uint64_t block_start = start; block_start < max_search; block_start += block) {
+            if (atomic_load(&shared.cutoff) <= block_start || pool_failed) break;
+            uint64_t block_end = (max_search - block_start > block) ? block_start + block : max_search;
             
-            // Process this index
-            int res = build_and_check(N, index, max_nodes, gas_limit);
+            #pragma omp single
+            atomic_store(&shared.next, block_start);
             
-            if (res >= 0) {
-                local_solution = res;
-                
-                // Set the found flag to stop other threads
-                #pragma omp atomic write
-                found_solution_flag = 1;
+            // Claim chunks in index order until the block or the cutoff is reached
+            bool stop = false;
+            while (!stop) {
+                uint64_t chunk_start = atomic_fetch_add(&shared.next, IC_SEARCH_CHUNK);
+                if (shared.writer) {
+                    uint64_t lowest = (chunk_start < block_end) ? chunk_start : block_end;
+                    ic_search_advance(&threads_view, mine, lowest);
+                }
+                if (chunk_start >= block_end) break;
+                uint64_t chunk_end = (block_end - chunk_start > IC_SEARCH_CHUNK)
+                    ? chunk_start + IC_SEARCH_CHUNK : block_end;
+                IC_TRACE_EVENT(IC_TRACE_CHUNK_BEGIN, 0, chunk_start, (uint32_t)(chunk_end - chunk_start));
                 
-                // Report progress with solution (only master thread)
-                if (thread_id == 0 && state->progress_cb) {
-                    state->progress_cb(index, true);
+                for (uint64_t index = chunk_start; index < chunk_end; index++) {
+                    // Indices past the cutoff cannot change any answer
+                    if (index >= atomic_load_explicit(&shared.cutoff, memory_order_relaxed)) {
+                        stop = true;
+                        break;
+                    }
+                    
+                    // Too small to hold the factors of any pending target
+                    if (ic_enum_net_size(index) < shared.min_net_size) {
+                        ic_counter_add(&mine->pruned, 1);
+                        continue;
+                    }
+                    
+                    // Process this index
+                    bool duplicate;
+                    int factor_a, factor_b;
+                    const ic_net_t *reduced;
+                    int status;
+                    bool has_pair = evaluate_index(&nets, index, seen, &duplicate,
+                                                   &factor_a, &factor_b, &reduced, &status);
+                    ic_counter_add(&mine->indices, 1);
+                    if (duplicate) {
+                        ic_counter_add(&mine->deduplicated, 1);
+                    } else {
+                        ic_search_count_reduction(mine, reduced, status);
+                    }
+                    
+                    if (has_pair) {
+                        bool improved = ic_target_offer(&shared, index, factor_a, factor_b);
+                        if (!duplicate) ic_search_dump(&shared, reduced, index, status, improved);
+                    }
                 }
+                IC_TRACE_EVENT(IC_TRACE_CHUNK_END, 0, chunk_start, 0);
             }
-            else {
-                // Report progress periodically (only master thread)
-                if (thread_id == 0 && state->progress_cb && (index / progress_chunk > local_chunk)) {
-                    local_chunk = index / progress_chunk;
-                    state->progress_cb(index, false);
-                }
+            
+            // After the barrier every index before block_end that anyone
+            // still needed has been evaluated
+            #pragma omp barrier
+            #pragma omp single
+            if (state->checkpoint_path) {
+                ic_checkpoint_write(state->checkpoint_path, state, max_nodes, gas_limit,
+                                    block_end, targets, count);
             }
         }
         
-        // After the loop, check if this thread found a solution
-        if (local_solution >= 0) {
-            #pragma omp critical
+        // Every thread has left the block loop before allocations are read
+        atomic_store_explicit(&mine->working, UINT64_MAX, memory_order_release);
+        #pragma omp barrier
+        #pragma omp single
+        state->loop_allocations = ic_net_alloc_count() - allocs_before_loop;
+        
+#ifdef IC_STATS
+        if (net) {
+            #pragma omp critical(ic_search_stats)
             {
-                // Record the first or smallest solution
-                if (solution_index < 0 || local_solution < solution_index) {
-                    solution_index = local_solution;
+                ic_stats_add(&state->stats, &net->stats);
+                if (nets.fixed_capacity > 0) {
+                    ic_stats_add(&state->stats, &ic_search_nets_build_target(&nets)->stats);
                 }
             }
         }
+#endif
+        
+        free(nets.pairs);
+        if (!pool) ic_net_free(net);
+        ic_topology_unpin_self(&unpinned);
+    }
+    
+    // Stop the reporter, then give the callback the final totals
+    if (reporter_running) {
+        atomic_store(&reporter.done, true);
+        pthread_join(reporter_thread, NULL);
+    }
+    if (shared.writer) {
+        ic_solution_writer_finish(&writer);
+        state->solutions_written = writer.written;
+        state->writer_stalls = atomic_load(&writer.stalls);
+    }
+    ic_search_progress_t totals;
+    ic_reporter_collect(&reporter, &totals);
+    if (state->progress_cb) {
+        ic_reporter_emit(&reporter);
+    }
+    free(counters);
+    free(topology);
+    
+    state->threads_used = atomic_load(&threads_used);
+    state->threads_pinned = atomic_load(&threads_pinned);
+    state->nets_dumped = atomic_load(&shared.dumped);
+    state->indices_searched = totals.indices;
+    state->indices_deduplicated = totals.deduplicated;
+    state->rewrites = totals.rewrites;
+    state->loops_detected = totals.loops;
+    state->nets_abandoned = totals.abandoned;
+    state->indices_pruned = totals.pruned;
+    state->distinct_nets = seen ? atomic_load(&seen->count) : 0;
+    if (seen) {
+        ic_enum_seen_destroy(seen);
     }
     
     // Update the state's current index for continuity
-    if (solution_index >= 0) {
-        state->current_index = solution_index + 1;
-    } else {
-        state->current_index = max_search;
+    size_t solved = 0;
+    for (size_t t = 0; t < count; t++) {
+        if (targets[t].solution != UINT64_MAX) solved++;
     }
-#else
-    // Sequential fallback implementation
-    ic_net_t *net = ic_net_create(max_nodes, gas_limit);
-    if (!net) return -1;
-    
-    // Set the input number to factor
-    net->input_number = N;
-    
-    // Loop until we find a solution or exhaust the search space
-    while (solution_index == -1 && state->current_index < max_search) {
-        // Try to build next valid net
-        if (ic_enum_next(state, net) == 0) {
-            break; // Exhausted search space
-        }
-        
-        // Run the reduction
-        ic_net_reduce(net);
-        
-        // Check if we found a valid factorization
-        if (ic_net_has_valid_factor(net, N)) {
-            solution_index = state->current_index - 1;
-            
-            // Report progress with solution
-            if (state->progress_cb) {
-                state->progress_cb(state->current_index - 1, true);
-            }
-            
-            break;
+    state->current_index = (shared.unsolved == 0 && !shared.writer) ? ic_search_final_cutoff(targets, count) : max_search;
+    
+    return pool_failed ? -1 : (int64_t)solved;
+}
+
+int64_t ic_search_factor_batch(ic_enum_state_t *state, const int *Ns, size_t count,
+                               size_t max_nodes, size_t gas_limit, ic_batch_result_t *results) {
+    if (!state || !Ns || !results) return -1;
+    
+    for (size_t i = 0; i < count; i++) {
+        results[i].solution_index = -1;
+        results[i].factor_a = 0;
+        results[i].factor_b = 0;
+    }
+    
+    // Sorted, de-duplicated copy of the valid targets
+    ic_target_t *targets = (ic_target_t*)malloc((count ? count : 1) * sizeof(ic_target_t));
+    if (!targets) return -1;
+    
+    size_t unique = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (Ns[i] <= 1) continue;
+        targets[unique].N = Ns[i];
+        targets[unique].solution = UINT64_MAX;
+        targets[unique].factor_a = 0;
+        targets[unique].factor_b = 0;
+        unique++;
+    }
+    qsort(targets, unique, sizeof(ic_target_t), ic_target_compare);
+    
+    size_t kept = 0;
+    for (size_t i = 0; i < unique; i++) {
+        if (kept == 0 || targets[kept - 1].N != targets[i].N) {
+            targets[kept++] = targets[i];
         }
+    }
+    
+    if (kept > 0 && ic_search_run(state, targets, kept, max_nodes, gas_limit) < 0) {
+        free(targets);
+        return -1;
+    }
+    
+    // Map the results back to the caller's order, duplicates included
+    int64_t solved = 0;
+    for (size_t i = 0; i < count; i++) {
+        ic_target_t *target = (Ns[i] > 1) ? ic_target_find(targets, kept, Ns[i]) : NULL;
         
-        // Report progress periodically
-        if (state->progress_cb && (state->current_index / progress_chunk > current_chunk)) {
-            current_chunk = state->current_index / progress_chunk;
-            state->progress_cb(state->current_index - 1, false);
+        if (target && target->solution != UINT64_MAX) {
+            results[i].solution_index = (int64_t)target->solution;
+            results[i].factor_a = target->factor_a;
+            results[i].factor_b = target->factor_b;
+            solved++;
         }
     }
     
-    // Clean up
-    ic_net_free(net);
-#endif
+    free(targets);
+    return solved;
+}
 
-    return solution_index;
-}
\ No newline at end of file
+size_t ic_search_min_net_size(int N, size_t max_nodes, bool slot_reuse) {
+    if (N <= 1) return 0;
+    
+    for (size_t k = ic_enum_net_size(0); k <= IC_ENUM_MAX_NET_NODES && k <= max_nodes; k++) {
+        size_t bound = (slot_reuse && k + 2 < max_nodes) ? k + 2 : max_nodes;
+        for (size_t a = 1; a <= bound && a * a < (size_t)N; a++) {
+            if (N % a == 0 && (size_t)N / a <= bound) return k;
+        }
+    }
+    return 0;
+}
+
+int64_t ic_search_factor(ic_enum_state_t *state, int N, size_t max_nodes, size_t gas_limit) {
+    if (!state || N <= 1) return -1;
+    
+    ic_batch_result_t result;
+    if (ic_search_factor_batch(state, &N, 1, max_nodes, gas_limit, &result) < 0) {
+        return IC_SEARCH_ERROR;
+    }
+    return result.solution_index;
+}
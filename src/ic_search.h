@@ -3,7 +3,67 @@
 
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 #include "ic_runtime.h"
+#include "ic_enum.h"
+#include "ic_topology.h"
+
+// Indices searched unless ic_enum_set_search_limit says otherwise
+#define IC_SEARCH_LIMIT_DEFAULT 1000000u
+
+// Indices between checkpoints when a checkpoint file is set
+#define IC_CHECKPOINT_INTERVAL_DEFAULT 100000u
+
+// Indices a search thread claims at a time; small enough that threads past
+// the cutoff stop quickly, large enough to keep the shared counter cool
+#define IC_SEARCH_CHUNK 64u
+
+// ic_search_factor's result when the search could not run (out of memory,
+// or max_nodes too large for a net), as opposed to -1 for no solution
+#define IC_SEARCH_ERROR (-2)
+
+// Milliseconds between progress reports
+#define IC_PROGRESS_INTERVAL_MS 500u
+
+// Solutions the queue to the solution writer holds (power of two)
+#define IC_SOLUTION_QUEUE 4096u
+
+// Indices a thread may claim past the slowest thread's chunk while every
+// solution is written; bounds the writer's reorder heap
+#define IC_SOLUTION_WINDOW (1u << 16)
+
+/**
+ * Machine-wide totals of a running search, summed over all threads
+ */
+typedef struct {
+    uint64_t next_index;      // Indices below this have been handed to threads
+    uint64_t indices;         // Indices built so far
+    uint64_t deduplicated;    // Of which skipped as duplicates
+    uint64_t rewrites;        // Rewrites performed (skipped loop repeats excluded)
+    uint64_t loops;           // Nets found to loop and skipped to the gas limit
+    uint64_t abandoned;       // Nets abandoned because no factor pair could survive
+    uint64_t pruned;          // Indices skipped unbuilt: too small to factor any target
+    uint64_t solutions;       // Times some target's best solution improved
+    int threads;              // Search threads
+    double elapsed;           // Seconds since the search started
+    double indices_per_sec;   // Throughput of all threads since the start
+    double rewrites_per_sec;
+} ic_search_progress_t;
+
+/**
+ * Heap nets kept by the search threads between searches
+ * A search given a pool (ic_enum_set_pool) takes thread t's net from
+ * nets[t] instead of creating one, and leaves it there when it ends, so a
+ * long-running process allocates its nets once rather than per search. A
+ * net built for another max_nodes is replaced. Only one search may use a
+ * pool at a time.
+ */
+typedef struct {
+    ic_net_t **nets;        // Net of each thread id, NULL until first needed
+    int capacity;           // Thread ids nets has room for
+    uint64_t nets_created;  // Nets the pool had to create
+    uint64_t nets_reused;   // Times a search thread found its net waiting
+} ic_search_pool_t;
 
 /**
  * State for enumerating IC nets
@@ -11,9 +71,74 @@
 typedef struct {
     size_t max_nodes;
     size_t current_index;
+    ic_enum_cursor_t cursor;  // Templates ic_enum_next patches
+
+    // Progress callback, called from a single reporter thread every
+    // progress_interval_ms and once more when the search ends
+    void (*progress_cb)(size_t current_index, bool found_solution,
+                        const ic_search_progress_t *progress);
+    unsigned progress_interval_ms;
+
+    // Skip nets that a smaller index already builds (default on)
+    bool dedup;
+
+    // Abandon nets whose factor goal is impossible (default on)
+    bool prune;
+
+    // ic_net_set_loop_check interval of the search nets
+    // (default IC_LOOP_CHECK_INTERVAL_DEFAULT, 0 = off)
+    size_t loop_check_interval;
+    
+    // Recycle erased node slots in the search nets (default off)
+    bool slot_reuse;
+    
+    // Thread count (0 = OpenMP default) and placement of the search threads
+    int threads;
+    ic_pin_mode_t pin;
+    bool numa_local;
+    
+    // Keep the threads' heap nets here between searches (NULL = off)
+    ic_search_pool_t *pool;
+    
+    // Append reduced nets to this stream as ic_net_write records: those
+    // that improved a target's solution, or with dump_pairs every net
+    // with a factor pair (NULL = off)
+    FILE *dump;
+    bool dump_pairs;
+    
+    // Write every solving index over the whole range to this stream, in
+    // index order, instead of stopping at each target's first (NULL = off)
+    FILE *all_solutions;
+    
+    // Search indices search_start..search_limit-1
+    uint64_t search_start;
+    uint64_t search_limit;
+    
+    // Save the completed frontier to checkpoint_path every
+    // checkpoint_interval indices; with resume, continue from it
+    const char *checkpoint_path;
+    uint64_t checkpoint_interval;
+    bool resume;
+    uint64_t resumed_from;        // Frontier the last search started at
 
-    // Progress callback
-    void (*progress_cb)(size_t current_index, bool found_solution);
+    // Statistics from the last ic_search_factor call
+    size_t indices_searched;      // Indices built
+    size_t indices_deduplicated;  // Indices skipped as duplicates of a smaller one
+    uint64_t rewrites;            // Rewrites performed by all threads
+    uint64_t loops_detected;      // Reduced nets found to loop
+    uint64_t nets_abandoned;      // Nets abandoned as unable to yield a factor pair
+    uint64_t indices_pruned;      // Indices not built because their nets are too small
+    size_t distinct_nets;         // Distinct layouts claimed in the dedup table
+    size_t loop_allocations;      // Heap allocations made inside the search loop
+    size_t fixed_capacity;        // Fixed net the search reduced in (0 for none)
+    int threads_used;             // Threads that ran the search
+    int threads_pinned;           // Of those, threads pinned to their CPU
+    uint64_t nets_dumped;         // Records written to the dump stream
+    uint64_t solutions_written;   // Lines written to the all_solutions stream
+    uint64_t writer_stalls;       // Times a thread found the solution queue full
+#ifdef IC_STATS
+    ic_stats_t stats;             // Reduction counters summed over all threads
+#endif
 } ic_enum_state_t;
 
 /**
@@ -23,12 +148,132 @@ void ic_enum_init(ic_enum_state_t *state, size_t max_nodes);
 
 /**
  * Set a progress callback
+ * Calls never overlap. found_solution is set when a target's solution
+ * improved since the last call, with current_index the newest solution;
+ * otherwise current_index is the next index to be handed out.
  */
 void ic_enum_set_progress_callback(ic_enum_state_t *state,
-                                  void (*callback)(size_t current_index, bool found_solution));
+                                  void (*callback)(size_t current_index, bool found_solution,
+                                                   const ic_search_progress_t *progress));
+
+/**
+ * Enable or disable deduplication of enumerated nets
+ * Skipping is exact: a net is only skipped when a smaller index has the
+ * same ic_enum_layout_id and so builds an identical net.
+ */
+void ic_enum_set_dedup(ic_enum_state_t *state, bool enabled);
+
+/**
+ * Enable or disable abandoning nets that provably cannot end with a
+ * factor pair (see ic_goal_factor)
+ * Only nets that could not solve any target are abandoned, so this only
+ * affects speed.
+ */
+void ic_enum_set_prune(ic_enum_state_t *state, bool enabled);
+
+/**
+ * Set how often search nets sample their state to detect loops (0 = off)
+ * A looping net skips the rest of its gas without changing its outcome,
+ * so this only affects speed.
+ */
+void ic_enum_set_loop_check(ic_enum_state_t *state, size_t interval);
+
+/**
+ * Enable or disable slot reuse in the search nets (see ic_net_set_slot_reuse)
+ * Factors are slot positions, so this changes which index solves which
+ * number. Off, the default, the results are those of the original reducer;
+ * on, nets stay within IC_ENUM_MAX_SLOTS slots and are reduced in a fixed
+ * net, but no factor exceeds IC_ENUM_MAX_SLOTS.
+ */
+void ic_enum_set_slot_reuse(ic_enum_state_t *state, bool enabled);
+
+/**
+ * Run searches on `threads` threads (0 = the OpenMP default)
+ */
+void ic_enum_set_threads(ic_enum_state_t *state, int threads);
+
+/**
+ * Choose where search threads run and where their nets live
+ * Each thread pins itself, as ic_topology_slot_for_thread places it,
+ * before creating its nets, so their pages are first touched on its own
+ * NUMA node. With numa_local the nets are also faulted in right away, with
+ * a huge-page hint when they are IC_TOPOLOGY_HUGE_BYTES or larger, and
+ * IC_PIN_NONE scatters the threads. Placement never changes results.
+ */
+void ic_enum_set_placement(ic_enum_state_t *state, ic_pin_mode_t pin, bool numa_local);
 
 /**
- * Build a net for a specific index
+ * Let searches draw their threads' heap nets from `pool` and leave them
+ * there afterwards (NULL turns it off; the default)
+ */
+void ic_enum_set_pool(ic_enum_state_t *state, ic_search_pool_t *pool);
+
+/**
+ * Start an empty pool
+ */
+void ic_search_pool_init(ic_search_pool_t *pool);
+
+/**
+ * Free every net in the pool
+ */
+void ic_search_pool_destroy(ic_search_pool_t *pool);
+
+/**
+ * Stream reduced nets to `out` while searching (NULL turns it off)
+ * Each net is written by the thread that reduced it, straight from its
+ * search net, so nothing is reduced twice. Without all_pairs only nets
+ * that improved some target's solution are written, so the record with a
+ * target's final solution index holds its solving net. With all_pairs
+ * every reduced net with a factor pair is written, whatever it factors.
+ * Records arrive in the order threads finish them, not in index order.
+ */
+void ic_enum_set_dump(ic_enum_state_t *state, FILE *out, bool all_pairs);
+
+/**
+ * Search the whole range for every solving index (NULL turns it off)
+ * Each index whose net factors a target is written to `out` as the line
+ * "index N factor_a factor_b", in ascending index order. Search threads
+ * push solutions into a bounded lock-free queue and a writer thread owns
+ * the stream, so they never wait on I/O, and no thread claims indices more
+ * than IC_SOLUTION_WINDOW past the slowest one, which bounds the writer's
+ * reorder heap. Duplicate nets still count as solutions, so the shared
+ * dedup table is off; each thread instead reuses the factor pair of a
+ * layout it has reduced before. Target results still hold each
+ * target's smallest solution.
+ */
+void ic_enum_set_all_solutions(ic_enum_state_t *state, FILE *out);
+
+/**
+ * Set how many indices a search examines
+ */
+void ic_enum_set_search_limit(ic_enum_state_t *state, uint64_t limit);
+
+/**
+ * Restrict the search to indices start..end-1
+ * A solution is the smallest solving index within the range, so the
+ * smallest over ranges that cover 0..end-1 is the single-range answer.
+ */
+void ic_enum_set_range(ic_enum_state_t *state, uint64_t start, uint64_t end);
+
+/**
+ * Restrict the search to shard k of n equal, contiguous parts of the
+ * current range
+ * @return 0 on success, -1 if k is not below n
+ */
+int ic_enum_set_shard(ic_enum_state_t *state, uint64_t k, uint64_t n);
+
+/**
+ * Checkpoint the completed index frontier to a text file
+ * The path is not copied and must outlive the search. With resume set, a
+ * search first reloads the frontier and solutions from the file, if it
+ * was written by a search with the same max_nodes, gas_limit and targets;
+ * otherwise it starts from index 0.
+ */
+void ic_enum_set_checkpoint(ic_enum_state_t *state, const char *path,
+                            uint64_t interval, bool resume);
+
+/**
+ * Build a net for a specific index from scratch (ic_enum_build_index)
  * @return 0 on success, -1 if invalid/out of range
  */
 int ic_enum_build_net(ic_enum_state_t *state, size_t index, ic_net_t *net);
@@ -41,14 +286,49 @@ int ic_enum_build_net_compatible(ic_enum_state_t *state, size_t index, ic_net_t
 
 /**
  * Build the next net and increment the index
+ * The net is patched from the state's cursor rather than rebuilt, and is
+ * identical to ic_enum_build_net's.
  * @return 1 if a net was built, 0 if enumeration is exhausted
  */
 int ic_enum_next(ic_enum_state_t *state, ic_net_t *net);
 
+/**
+ * Outcome of one target of a batch search
+ */
+typedef struct {
+    int64_t solution_index;  // Smallest solving index, or -1 if none found
+    int factor_a;            // Factors read from the solving net
+    int factor_b;
+} ic_batch_result_t;
+
+/**
+ * Smallest enumerated net that could end with a factor pair of N
+ * Factors are slot positions + 1 and the surviving δ and γ sit in
+ * different slots, so N needs a divisor pair a * b with a != b and both
+ * at most max_nodes. With slot reuse, a net of k nodes also never occupies
+ * more than k + 2 slots (IC_ENUM_MAX_SLOTS), so both must be at most
+ * min(k + 2, max_nodes). Searches skip indices of smaller nets without
+ * building them.
+ * @return The smallest such k, or 0 if no enumerated net can factor N
+ */
+size_t ic_search_min_net_size(int N, size_t max_nodes, bool slot_reuse);
+
 /**
  * Run the search for a net that factors the given number
- * @return The index of the solution, or -1 if none found
+ * @return The index of the solution, -1 if none found, or IC_SEARCH_ERROR
+ *         if the search could not run
+ */
+int64_t ic_search_factor(ic_enum_state_t *state, int N, size_t max_nodes, size_t gas_limit);
+
+/**
+ * Factor many numbers in a single enumeration pass
+ * Each index is built and reduced once and its factor pair is tested
+ * against every pending target; solved targets are retired and the search
+ * ends when all are solved. results[i] receives the outcome for Ns[i];
+ * a failed search leaves every result unsolved.
+ * @return Number of targets solved, or -1 if the search could not run
  */
-int ic_search_factor(ic_enum_state_t *state, int N, size_t max_nodes, size_t gas_limit);
+int64_t ic_search_factor_batch(ic_enum_state_t *state, const int *Ns, size_t count,
+                               size_t max_nodes, size_t gas_limit, ic_batch_result_t *results);
 
 #endif /* IC_SEARCH_H */
\ No newline at end of file
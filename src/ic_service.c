@@ -0,0 +1,810 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "ic_service.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <netdb.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+
+// Numbers one batch request may carry
+#define IC_SERVICE_BATCH_MAX 256
+
+// Unread reply bytes at which the service stops reading a client's requests
+#define IC_SERVICE_BACKLOG_MAX (16 * IC_SERVICE_LINE_MAX)
+
+/**
+ * Bucket of a key: a multiplicative mix of its three fields
+ */
+static size_t ic_service_hash(const ic_service_key_t *key) {
+    uint64_t h = (uint64_t)(uint32_t)key->N * 0x9E3779B97F4A7C15ull;
+    h ^= (uint64_t)key->max_nodes + 0xBF58476D1CE4E5B9ull + (h << 6) + (h >> 2);
+    h ^= (uint64_t)key->gas_limit + 0x94D049BB133111EBull + (h << 6) + (h >> 2);
+    return (size_t)(h ^ (h >> 31));
+}
+
+static bool ic_service_key_equal(const ic_service_key_t *a, const ic_service_key_t *b) {
+    return a->N == b->N && a->max_nodes == b->max_nodes && a->gas_limit == b->gas_limit;
+}
+
+int ic_service_cache_init(ic_service_cache_t *cache, size_t capacity) {
+    if (!cache || capacity == 0 || capacity > INT32_MAX / 2) return -1;
+
+    // At least two buckets per entry keeps the chains short
+    size_t buckets = 1;
+    while (buckets < 2 * capacity) buckets *= 2;
+
+    cache->entries = (ic_service_entry_t*)malloc(capacity * sizeof(ic_service_entry_t));
+    cache->buckets = (int32_t*)malloc(buckets * sizeof(int32_t));
+    if (!cache->entries || !cache->buckets) {
+        free(cache->entries);
+        free(cache->buckets);
+        return -1;
+    }
+    for (size_t b = 0; b < buckets; b++) cache->buckets[b] = -1;
+    cache->bucket_mask = buckets - 1;
+    cache->capacity = capacity;
+    cache->count = 0;
+    cache->newest = cache->oldest = -1;
+    cache->hits = cache->misses = cache->evictions = 0;
+    return 0;
+}
+
+void ic_service_cache_destroy(ic_service_cache_t *cache) {
+    if (!cache) return;
+    free(cache->entries);
+    free(cache->buckets);
+    cache->entries = NULL;
+    cache->buckets = NULL;
+    cache->count = 0;
+}
+
+/**
+ * Take an entry out of the LRU list
+ */
+static void ic_service_cache_unlink(ic_service_cache_t *cache, int32_t e) {
+    ic_service_entry_t *entry = &cache->entries[e];
+    if (entry->newer >= 0) cache->entries[entry->newer].older = entry->older;
+    else cache->newest = entry->older;
+    if (entry->older >= 0) cache->entries[entry->older].newer = entry->newer;
+    else cache->oldest = entry->newer;
+}
+
+/**
+ * Put an entry at the most recently used end of the LRU list
+ */
+static void ic_service_cache_push(ic_service_cache_t *cache, int32_t e) {
+    ic_service_entry_t *entry = &cache->entries[e];
+    entry->newer = -1;
+    entry->older = cache->newest;
+    if (cache->newest >= 0) cache->entries[cache->newest].newer = e;
+    cache->newest = e;
+    if (cache->oldest < 0) cache->oldest = e;
+}
+
+/**
+ * Position of a key's entry, or -1
+ */
+static int32_t ic_service_cache_find(const ic_service_cache_t *cache, const ic_service_key_t *key) {
+    int32_t e = cache->buckets[ic_service_hash(key) & cache->bucket_mask];
+    while (e >= 0 && !ic_service_key_equal(&cache->entries[e].key, key)) {
+        e = cache->entries[e].chain;
+    }
+    return e;
+}
+
+bool ic_service_cache_lookup(ic_service_cache_t *cache, const ic_service_key_t *key,
+                             ic_batch_result_t *result) {
+    int32_t e = ic_service_cache_find(cache, key);
+    if (e < 0) {
+        cache->misses++;
+        return false;
+    }
+
+    cache->hits++;
+    ic_service_cache_unlink(cache, e);
+    ic_service_cache_push(cache, e);
+    if (result) *result = cache->entries[e].result;
+    return true;
+}
+
+void ic_service_cache_insert(ic_service_cache_t *cache, const ic_service_key_t *key,
+                             const ic_batch_result_t *result) {
+    int32_t e = ic_service_cache_find(cache, key);
+    if (e >= 0) {
+        cache->entries[e].result = *result;
+        ic_service_cache_unlink(cache, e);
+        ic_service_cache_push(cache, e);
+        return;
+    }
+
+    if (cache->count < cache->capacity) {
+        e = (int32_t)cache->count++;
+    } else {
+        // Recycle the least recently used entry, unchaining it first
+        e = cache->oldest;
+        ic_service_cache_unlink(cache, e);
+        int32_t *link = &cache->buckets[ic_service_hash(&cache->entries[e].key) & cache->bucket_mask];
+        while (*link != e) link = &cache->entries[*link].chain;
+        *link = cache->entries[e].chain;
+        cache->evictions++;
+    }
+
+    ic_service_entry_t *entry = &cache->entries[e];
+    entry->key = *key;
+    entry->result = *result;
+    int32_t *bucket = &cache->buckets[ic_service_hash(key) & cache->bucket_mask];
+    entry->chain = *bucket;
+    *bucket = e;
+    ic_service_cache_push(cache, e);
+}
+
+int ic_service_init(ic_service_t *service, const ic_enum_state_t *base, size_t cache_capacity) {
+    if (!service || !base) return -1;
+    if (ic_service_cache_init(&service->cache, cache_capacity) != 0) return -1;
+
+    service->base = *base;
+    service->base.progress_cb = NULL;
+    service->base.dump = NULL;
+    service->base.all_solutions = NULL;
+    service->base.checkpoint_path = NULL;
+    service->base.resume = false;
+    ic_search_pool_init(&service->pool);
+    service->requests = 0;
+    service->searches = 0;
+    service->search_seconds = 0.0;
+    service->nets_created = 0;
+    service->nets_reused = 0;
+    return 0;
+}
+
+void ic_service_destroy(ic_service_t *service) {
+    if (!service) return;
+    ic_service_cache_destroy(&service->cache);
+    ic_search_pool_destroy(&service->pool);
+}
+
+
+/**
+ * Parse a whole token as an unsigned number of at most `max`
+ * @return 0 on success, -1 if it is not one
+ */
+static int ic_service_parse(const char *token, uint64_t max, uint64_t *value) {
+    if (!token || *token < '0' || *token > '9') return -1;
+    char *end;
+    errno = 0;
+    unsigned long long parsed = strtoull(token, &end, 10);
+    if (errno != 0 || *end != '\0' || parsed > max) return -1;
+    *value = parsed;
+    return 0;
+}
+
+static void ic_service_reply(FILE *out, int N, const ic_batch_result_t *result, bool cached) {
+    fprintf(out, "%d %" PRId64 " %d %d %s\n", N, result->solution_index,
+            (result->solution_index >= 0) ? result->factor_a : 0,
+            (result->solution_index >= 0) ? result->factor_b : 0,
+            cached ? "cached" : "searched");
+}
+
+/**
+ * The numbers of one factor or batch request, the answers found in the
+ * cache and the uncached numbers its search pass looks for
+ */
+typedef struct {
+    int Ns[IC_SERVICE_BATCH_MAX];
+    size_t count;
+    size_t max_nodes;
+    size_t gas_limit;
+    ic_batch_result_t results[IC_SERVICE_BATCH_MAX];
+    bool cached[IC_SERVICE_BATCH_MAX];
+    int pending[IC_SERVICE_BATCH_MAX];
+    size_t pending_count;      // 0 once the request is answered
+    ic_batch_result_t found[IC_SERVICE_BATCH_MAX];
+    int64_t solved;            // ic_search_factor_batch's result, -1 if it failed
+    double seconds;
+} ic_service_job_t;
+
+/**
+ * Look a job's numbers up in the cache and list the ones left to search
+ */
+static void ic_service_plan(ic_service_t *service, ic_service_job_t *job) {
+    job->pending_count = 0;
+    for (size_t i = 0; i < job->count; i++) {
+        ic_service_key_t key = { job->Ns[i], job->max_nodes, job->gas_limit };
+        job->cached[i] = ic_service_cache_lookup(&service->cache, &key, &job->results[i]);
+        if (job->cached[i]) continue;
+
+        // A number repeated in the request is searched once
+        bool repeat = false;
+        for (size_t p = 0; p < job->pending_count && !repeat; p++) repeat = job->pending[p] == job->Ns[i];
+        if (!repeat) job->pending[job->pending_count++] = job->Ns[i];
+    }
+}
+
+/**
+ * Search for a job's pending numbers in one pass
+ * Only the pool and the job are touched, so ic_service_run calls this on
+ * its worker thread while the cache keeps answering other clients.
+ */
+static void ic_service_search(ic_service_t *service, ic_service_job_t *job) {
+    ic_enum_state_t state = service->base;
+    state.max_nodes = job->max_nodes;
+    ic_enum_cursor_init(&state.cursor);
+    ic_enum_set_pool(&state, &service->pool);
+
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    job->solved = ic_search_factor_batch(&state, job->pending, job->pending_count,
+                                         job->max_nodes, job->gas_limit, job->found);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    job->seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+}
+
+/**
+ * Cache what a job's search found and write its reply
+ * A failed search is answered with an error and leaves the cache alone,
+ * so the next request searches again instead of hearing "not found".
+ */
+static void ic_service_finish(ic_service_t *service, ic_service_job_t *job, FILE *out) {
+    if (job->pending_count > 0) {
+        service->searches++;
+        service->search_seconds += job->seconds;
+        service->nets_created = service->pool.nets_created;
+        service->nets_reused = service->pool.nets_reused;
+        if (job->solved < 0) {
+            fprintf(out, "error search failed: out of memory\n");
+            job->pending_count = 0;
+            return;
+        }
+
+        for (size_t p = 0; p < job->pending_count; p++) {
+            ic_service_key_t key = { job->pending[p], job->max_nodes, job->gas_limit };
+            ic_service_cache_insert(&service->cache, &key, &job->found[p]);
+        }
+        for (size_t i = 0; i < job->count; i++) {
+            if (job->cached[i]) continue;
+            for (size_t p = 0; p < job->pending_count; p++) {
+                if (job->pending[p] == job->Ns[i]) job->results[i] = job->found[p];
+            }
+        }
+        job->pending_count = 0;
+    }
+
+    for (size_t i = 0; i < job->count; i++) {
+        ic_service_reply(out, job->Ns[i], &job->results[i], job->cached[i]);
+    }
+}
+
+/**
+ * Answer a request line as far as the cache allows
+ * A factor or batch request with uncached numbers leaves them in
+ * job->pending for ic_service_search and ic_service_finish; every other
+ * request is answered here.
+ * @return IC_SERVICE_CONTINUE, IC_SERVICE_CLOSE or IC_SERVICE_SHUTDOWN
+ */
+static int ic_service_request(ic_service_t *service, const char *line, FILE *out,
+                              ic_service_job_t *job) {
+    service->requests++;
+    job->count = 0;
+    job->pending_count = 0;
+
+    char request[IC_SERVICE_LINE_MAX];
+    size_t length = strlen(line);
+    if (length >= sizeof(request)) {
+        fprintf(out, "error request too long\n");
+        return IC_SERVICE_CONTINUE;
+    }
+    memcpy(request, line, length + 1);
+
+    char *tokens[IC_SERVICE_BATCH_MAX + 4];
+    size_t token_count = 0;
+    char *save = NULL;
+    for (char *token = strtok_r(request, " \t\r\n", &save); token;
+         token = strtok_r(NULL, " \t\r\n", &save)) {
+        if (token_count == sizeof(tokens) / sizeof(tokens[0])) {
+            fprintf(out, "error at most %d numbers per batch\n", IC_SERVICE_BATCH_MAX);
+            return IC_SERVICE_CONTINUE;
+        }
+        tokens[token_count++] = token;
+    }
+    if (token_count == 0) {
+        fprintf(out, "error empty request\n");
+        return IC_SERVICE_CONTINUE;
+    }
+
+    const char *command = tokens[0];
+    if (strcmp(command, "quit") == 0) return IC_SERVICE_CLOSE;
+    if (strcmp(command, "shutdown") == 0) {
+        fprintf(out, "bye\n");
+        return IC_SERVICE_SHUTDOWN;
+    }
+    if (strcmp(command, "stats") == 0) {
+        fprintf(out, "requests %" PRIu64 " searches %" PRIu64 " search_seconds %.6f "
+                "hits %" PRIu64 " misses %" PRIu64 " evictions %" PRIu64 " entries %zu "
+                "capacity %zu nets_created %" PRIu64 " nets_reused %" PRIu64 "\n",
+                service->requests, service->searches, service->search_seconds,
+                service->cache.hits, service->cache.misses, service->cache.evictions,
+                service->cache.count, service->cache.capacity,
+                service->nets_created, service->nets_reused);
+        return IC_SERVICE_CONTINUE;
+    }
+
+    // Both search requests come down to numbers, max_nodes and gas_limit
+    size_t first, last;
+    uint64_t max_nodes = IC_SERVICE_MAX_NODES_DEFAULT, gas_limit = IC_SERVICE_GAS_LIMIT_DEFAULT;
+    if (strcmp(command, "factor") == 0) {
+        if (token_count < 2 || token_count > 4 ||
+            (token_count > 2 && ic_service_parse(tokens[2], UINT64_MAX, &max_nodes) != 0) ||
+            (token_count > 3 && ic_service_parse(tokens[3], UINT64_MAX, &gas_limit) != 0)) {
+            fprintf(out, "error usage: factor <N> [max_nodes] [gas_limit]\n");
+            return IC_SERVICE_CONTINUE;
+        }
+        first = last = 1;
+    } else if (strcmp(command, "batch") == 0) {
+        if (token_count < 4 || ic_service_parse(tokens[1], UINT64_MAX, &max_nodes) != 0 ||
+            ic_service_parse(tokens[2], UINT64_MAX, &gas_limit) != 0) {
+            fprintf(out, "error usage: batch <max_nodes> <gas_limit> <N>...\n");
+            return IC_SERVICE_CONTINUE;
+        }
+        first = 3;
+        last = token_count - 1;
+    } else {
+        fprintf(out, "error unknown request %s\n", command);
+        return IC_SERVICE_CONTINUE;
+    }
+    if (max_nodes == 0 || gas_limit == 0) {
+        fprintf(out, "error max_nodes and gas_limit must be positive\n");
+        return IC_SERVICE_CONTINUE;
+    }
+    if (max_nodes > IC_SERVICE_MAX_NODES_MAX || gas_limit > IC_SERVICE_GAS_LIMIT_MAX) {
+        fprintf(out, "error max_nodes and gas_limit must be at most %d and %d\n",
+                IC_SERVICE_MAX_NODES_MAX, IC_SERVICE_GAS_LIMIT_MAX);
+        return IC_SERVICE_CONTINUE;
+    }
+
+    size_t count = 0;
+    for (size_t t = first; t <= last; t++) {
+        uint64_t N;
+        if (count == IC_SERVICE_BATCH_MAX) {
+            fprintf(out, "error at most %d numbers per batch\n", IC_SERVICE_BATCH_MAX);
+            return IC_SERVICE_CONTINUE;
+        }
+        if (ic_service_parse(tokens[t], INT32_MAX, &N) != 0 || N <= 1) {
+            fprintf(out, "error %s is not a number greater than 1\n", tokens[t]);
+            return IC_SERVICE_CONTINUE;
+        }
+        job->Ns[count++] = (int)N;
+    }
+
+    job->count = count;
+    job->max_nodes = (size_t)max_nodes;
+    job->gas_limit = (size_t)gas_limit;
+    ic_service_plan(service, job);
+    if (job->pending_count == 0) ic_service_finish(service, job, out);
+    return IC_SERVICE_CONTINUE;
+}
+
+int ic_service_handle(ic_service_t *service, const char *line, FILE *out) {
+    ic_service_job_t job;
+    int status = ic_service_request(service, line, out, &job);
+    if (job.pending_count > 0) {
+        ic_service_search(service, &job);
+        ic_service_finish(service, &job, out);
+    }
+    return status;
+}
+
+int ic_service_listen(const char *address) {
+    if (!address) return -1;
+
+    if (strncmp(address, "unix:", 5) == 0) {
+        const char *path = address + 5;
+        struct sockaddr_un addr;
+        if (*path == '\0' || strlen(path) >= sizeof(addr.sun_path)) return -1;
+        memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        strcpy(addr.sun_path, path);
+
+        int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd < 0) return -1;
+        unlink(path);
+        if (bind(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0 || listen(fd, 16) != 0) {
+            close(fd);
+            return -1;
+        }
+        return fd;
+    }
+
+    if (strncmp(address, "tcp:", 4) != 0) return -1;
+
+    // tcp:<port> binds the loopback interface; tcp:<host>:<port> any host
+    char host[256] = "127.0.0.1";
+    const char *port = address + 4;
+    const char *colon = strrchr(port, ':');
+    if (colon) {
+        size_t host_length = (size_t)(colon - port);
+        if (host_length == 0 || host_length >= sizeof(host)) return -1;
+        memcpy(host, port, host_length);
+        host[host_length] = '\0';
+        port = colon + 1;
+    }
+    if (*port == '\0') return -1;
+
+    struct addrinfo hints, *found;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags = AI_PASSIVE;
+    if (getaddrinfo(host, port, &hints, &found) != 0) return -1;
+
+    int fd = -1;
+    for (struct addrinfo *ai = found; ai && fd < 0; ai = ai->ai_next) {
+        fd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+        if (fd < 0) continue;
+        int reuse = 1;
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+        if (bind(fd, ai->ai_addr, ai->ai_addrlen) != 0 || listen(fd, 16) != 0) {
+            close(fd);
+            fd = -1;
+        }
+    }
+    freeaddrinfo(found);
+    return fd;
+}
+
+
+/**
+ * A connected client: the part of its requests not handled yet, the
+ * replies it has not read yet and the request that waits for a search
+ */
+typedef struct {
+    int fd;
+    size_t used;
+    char line[IC_SERVICE_LINE_MAX];
+    FILE *out;                 // Replies go into `reply` through this stream
+    char *reply;
+    size_t reply_size;
+    size_t reply_sent;         // Bytes of `reply` already written to the socket
+    ic_service_job_t *job;
+    bool waiting;              // job waits for or runs its search
+    bool closing;              // Close once the replies are written
+    uint64_t ticket;           // Order in which waiting clients are searched for
+} ic_service_client_t;
+
+/**
+ * The thread ic_service_run hands searches to, one at a time
+ */
+typedef struct {
+    ic_service_t *service;
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    ic_service_job_t *job;     // The search handed over, NULL while idle
+    int client;                // Its client's slot, -1 if the client left
+    bool searched;             // job's search is done
+    bool stopping;
+    int done[2];               // Pipe that wakes the poll loop after each search
+} ic_service_worker_t;
+
+static void *ic_service_worker_main(void *arg) {
+    ic_service_worker_t *worker = (ic_service_worker_t*)arg;
+
+    pthread_mutex_lock(&worker->lock);
+    for (;;) {
+        while (!worker->stopping && !(worker->job && !worker->searched)) {
+            pthread_cond_wait(&worker->wake, &worker->lock);
+        }
+        if (!worker->job || worker->searched) break;
+
+        ic_service_job_t *job = worker->job;
+        pthread_mutex_unlock(&worker->lock);
+        ic_service_search(worker->service, job);
+        pthread_mutex_lock(&worker->lock);
+
+        worker->searched = true;
+        char byte = 0;
+        ssize_t wrote = write(worker->done[1], &byte, 1);
+        (void)wrote;
+    }
+    pthread_mutex_unlock(&worker->lock);
+    return NULL;
+}
+
+/**
+ * Start with an empty reply buffer
+ * @return 0 on success, -1 if out of memory
+ */
+static int ic_service_client_open(ic_service_client_t *client) {
+    client->reply = NULL;
+    client->reply_size = 0;
+    client->reply_sent = 0;
+    client->out = open_memstream(&client->reply, &client->reply_size);
+    return client->out ? 0 : -1;
+}
+
+static void ic_service_client_close(ic_service_client_t *client, ic_service_worker_t *worker) {
+    if (client->out) fclose(client->out);
+    free(client->reply);
+    // A job the worker is searching for is freed once it is done
+    if (worker->job && worker->job == client->job) worker->client = -1;
+    else free(client->job);
+    close(client->fd);
+    client->fd = -1;
+    client->out = NULL;
+    client->reply = NULL;
+    client->job = NULL;
+}
+
+/**
+ * Reply bytes the client has not been sent yet
+ */
+static size_t ic_service_client_backlog(ic_service_client_t *client) {
+    fflush(client->out);
+    return client->reply_size - client->reply_sent;
+}
+
+/**
+ * Write as much of the client's replies as the socket takes
+ * @return 0 on success, -1 if the client is gone or out of memory
+ */
+static int ic_service_client_write(ic_service_client_t *client) {
+    if (fflush(client->out) != 0) return -1;
+    while (client->reply_sent < client->reply_size) {
+        ssize_t wrote = write(client->fd, client->reply + client->reply_sent,
+                              client->reply_size - client->reply_sent);
+        if (wrote < 0 && errno == EINTR) continue;
+        if (wrote < 0) return (errno == EAGAIN || errno == EWOULDBLOCK) ? 0 : -1;
+        client->reply_sent += (size_t)wrote;
+    }
+
+    // Everything is out, so the buffer starts over
+    if (client->reply_size == 0) return 0;
+    fclose(client->out);
+    free(client->reply);
+    return ic_service_client_open(client);
+}
+
+/**
+ * Answer the client's complete request lines until one waits for a
+ * search or its unread replies reach IC_SERVICE_BACKLOG_MAX
+ * @return IC_SERVICE_CONTINUE, IC_SERVICE_CLOSE or IC_SERVICE_SHUTDOWN
+ */
+static int ic_service_client_serve(ic_service_t *service, ic_service_client_t *client) {
+    int status = IC_SERVICE_CONTINUE;
+    char *start = client->line;
+    char *newline;
+    while (status == IC_SERVICE_CONTINUE && !client->waiting &&
+           ic_service_client_backlog(client) < IC_SERVICE_BACKLOG_MAX &&
+           (newline = strchr(start, '\n')) != NULL) {
+        *newline = '\0';
+        status = ic_service_request(service, start, client->out, client->job);
+        client->waiting = client->job->pending_count > 0;
+        start = newline + 1;
+    }
+
+    // Keep the unhandled requests; an unfinished one that fills the buffer is refused
+    client->used -= (size_t)(start - client->line);
+    memmove(client->line, start, client->used + 1);
+    if (status == IC_SERVICE_CONTINUE && !client->waiting &&
+        client->used == sizeof(client->line) - 1 && !strchr(client->line, '\n')) {
+        fprintf(client->out, "error request too long\n");
+        status = IC_SERVICE_CLOSE;
+    }
+    return status;
+}
+
+/**
+ * Read what a client sent
+ * @return IC_SERVICE_CONTINUE, or IC_SERVICE_CLOSE once it hung up
+ */
+static int ic_service_client_read(ic_service_client_t *client) {
+    ssize_t got = read(client->fd, client->line + client->used, sizeof(client->line) - 1 - client->used);
+    if (got < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) return IC_SERVICE_CONTINUE;
+    if (got <= 0) return IC_SERVICE_CLOSE;
+    client->used += (size_t)got;
+    client->line[client->used] = '\0';
+    return IC_SERVICE_CONTINUE;
+}
+
+int ic_service_run(ic_service_t *service, int listen_fd) {
+    if (!service || listen_fd < 0) return -1;
+
+    // A client that hangs up mid-reply must not end the service
+    signal(SIGPIPE, SIG_IGN);
+
+    ic_service_client_t *clients = (ic_service_client_t*)malloc(
+        IC_SERVICE_MAX_CLIENTS * sizeof(ic_service_client_t));
+    if (!clients) return -1;
+    for (int c = 0; c < IC_SERVICE_MAX_CLIENTS; c++) clients[c].fd = -1;
+
+    ic_service_worker_t worker;
+    worker.service = service;
+    worker.job = NULL;
+    worker.client = -1;
+    worker.searched = false;
+    worker.stopping = false;
+    if (pipe(worker.done) != 0) {
+        free(clients);
+        return -1;
+    }
+    pthread_mutex_init(&worker.lock, NULL);
+    pthread_cond_init(&worker.wake, NULL);
+    if (pthread_create(&worker.thread, NULL, ic_service_worker_main, &worker) != 0) {
+        pthread_cond_destroy(&worker.wake);
+        pthread_mutex_destroy(&worker.lock);
+        close(worker.done[0]);
+        close(worker.done[1]);
+        free(clients);
+        return -1;
+    }
+
+    int result = -1;
+    bool running = true;
+    uint64_t tickets = 0;
+    while (running) {
+        struct pollfd fds[IC_SERVICE_MAX_CLIENTS + 2];
+        int slot_of[IC_SERVICE_MAX_CLIENTS + 2];
+        nfds_t count = 0;
+        fds[count].fd = listen_fd;
+        fds[count].events = POLLIN;
+        slot_of[count++] = -1;
+        fds[count].fd = worker.done[0];
+        fds[count].events = POLLIN;
+        slot_of[count++] = -1;
+        for (int c = 0; c < IC_SERVICE_MAX_CLIENTS; c++) {
+            ic_service_client_t *client = &clients[c];
+            if (client->fd < 0) continue;
+
+            // A client is only read from while it could be answered
+            size_t backlog = ic_service_client_backlog(client);
+            short events = 0;
+            if (!client->waiting && !client->closing && backlog < IC_SERVICE_BACKLOG_MAX) events |= POLLIN;
+            if (backlog > 0) events |= POLLOUT;
+            if (events == 0) continue;
+            fds[count].fd = client->fd;
+            fds[count].events = events;
+            slot_of[count++] = c;
+        }
+
+        if (poll(fds, count, -1) < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+
+        // Which clients to serve again after this round
+        bool touched[IC_SERVICE_MAX_CLIENTS] = { false };
+
+        if (fds[1].revents & POLLIN) {
+            char bytes[16];
+            ssize_t got = read(worker.done[0], bytes, sizeof(bytes));
+            (void)got;
+            pthread_mutex_lock(&worker.lock);
+            bool searched = worker.searched;
+            pthread_mutex_unlock(&worker.lock);
+            if (searched) {
+                if (worker.client >= 0) {
+                    ic_service_client_t *client = &clients[worker.client];
+                    ic_service_finish(service, worker.job, client->out);
+                    client->waiting = false;
+                    touched[worker.client] = true;
+                } else {
+                    free(worker.job);
+                }
+                pthread_mutex_lock(&worker.lock);
+                worker.job = NULL;
+                worker.client = -1;
+                worker.searched = false;
+                pthread_mutex_unlock(&worker.lock);
+            }
+        }
+
+        for (nfds_t i = 2; i < count; i++) {
+            ic_service_client_t *client = &clients[slot_of[i]];
+            short revents = fds[i].revents;
+            if (revents == 0) continue;
+            touched[slot_of[i]] = true;
+            if ((fds[i].events & POLLIN) && (revents & (POLLIN | POLLHUP | POLLERR)) &&
+                ic_service_client_read(client) != IC_SERVICE_CONTINUE) {
+                client->closing = true;
+            }
+            if ((revents & (POLLHUP | POLLERR)) && !(fds[i].events & POLLIN)) {
+                ic_service_client_close(client, &worker);
+            }
+        }
+
+        for (int c = 0; c < IC_SERVICE_MAX_CLIENTS && running; c++) {
+            ic_service_client_t *client = &clients[c];
+            if (!touched[c] || client->fd < 0) continue;
+
+            // Replies written first may make room for the lines held back
+            if (ic_service_client_write(client) != 0) {
+                ic_service_client_close(client, &worker);
+                continue;
+            }
+            bool was_waiting = client->waiting;
+            int status = client->closing ? IC_SERVICE_CLOSE : ic_service_client_serve(service, client);
+            if (client->waiting && !was_waiting) client->ticket = tickets++;
+            if (status == IC_SERVICE_SHUTDOWN) {
+                running = false;
+                result = 0;
+            }
+            if (status != IC_SERVICE_CONTINUE) client->closing = true;
+            if (ic_service_client_write(client) != 0 ||
+                (client->closing && ic_service_client_backlog(client) == 0)) {
+                ic_service_client_close(client, &worker);
+            }
+        }
+
+        // Hand the longest waiting search to an idle worker
+        if (running && !worker.job) {
+            int next = -1;
+            for (int c = 0; c < IC_SERVICE_MAX_CLIENTS; c++) {
+                if (clients[c].fd >= 0 && clients[c].waiting &&
+                    (next < 0 || clients[c].ticket < clients[next].ticket)) {
+                    next = c;
+                }
+            }
+            if (next >= 0) {
+                pthread_mutex_lock(&worker.lock);
+                worker.job = clients[next].job;
+                worker.client = next;
+                pthread_cond_signal(&worker.wake);
+                pthread_mutex_unlock(&worker.lock);
+            }
+        }
+
+        if (running && (fds[0].revents & POLLIN)) {
+            int fd = accept(listen_fd, NULL, NULL);
+            if (fd < 0) continue;
+
+            int c = 0;
+            while (c < IC_SERVICE_MAX_CLIENTS && clients[c].fd >= 0) c++;
+            ic_service_client_t *client = &clients[c];
+            int flags = fcntl(fd, F_GETFL);
+            if (c == IC_SERVICE_MAX_CLIENTS || flags < 0 || fcntl(fd, F_SETFL, flags | O_NONBLOCK) != 0) {
+                close(fd);
+                continue;
+            }
+            client->job = (ic_service_job_t*)malloc(sizeof(ic_service_job_t));
+            if (!client->job || ic_service_client_open(client) != 0) {
+                free(client->job);
+                close(fd);
+                continue;
+            }
+            client->fd = fd;
+            client->used = 0;
+            client->line[0] = '\0';
+            client->waiting = false;
+            client->closing = false;
+        }
+    }
+
+    // A running search is finished first; replies that fit the sockets go out
+    pthread_mutex_lock(&worker.lock);
+    worker.stopping = true;
+    pthread_cond_signal(&worker.wake);
+    pthread_mutex_unlock(&worker.lock);
+    pthread_join(worker.thread, NULL);
+    if (worker.job && worker.client >= 0) ic_service_finish(service, worker.job, clients[worker.client].out);
+    else free(worker.job);
+    worker.job = NULL;
+    for (int c = 0; c < IC_SERVICE_MAX_CLIENTS; c++) {
+        if (clients[c].fd < 0) continue;
+        ic_service_client_write(&clients[c]);
+        ic_service_client_close(&clients[c], &worker);
+    }
+    pthread_cond_destroy(&worker.wake);
+    pthread_mutex_destroy(&worker.lock);
+    close(worker.done[0]);
+    close(worker.done[1]);
+    free(clients);
+    return result;
+}
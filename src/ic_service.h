@@ -0,0 +1,149 @@
+#ifndef IC_SERVICE_H
+#define IC_SERVICE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "ic_search.h"
+
+// Results a service remembers by default
+#define IC_SERVICE_CACHE_DEFAULT 4096
+
+// Clients a service reads requests from at once, and the longest request
+#define IC_SERVICE_MAX_CLIENTS 64
+#define IC_SERVICE_LINE_MAX 4096
+
+// Defaults of a request that leaves out max_nodes or gas_limit, as in main
+#define IC_SERVICE_MAX_NODES_DEFAULT 100
+#define IC_SERVICE_GAS_LIMIT_DEFAULT 100000
+
+// Largest max_nodes and gas_limit a request may ask for
+#define IC_SERVICE_MAX_NODES_MAX 4096
+#define IC_SERVICE_GAS_LIMIT_MAX 100000000
+
+/**
+ * What a search was asked: the cache key
+ */
+typedef struct {
+    int N;
+    size_t max_nodes;
+    size_t gas_limit;
+} ic_service_key_t;
+
+/**
+ * One remembered result, linked into its hash chain and the LRU list
+ */
+typedef struct {
+    ic_service_key_t key;
+    ic_batch_result_t result;
+    int32_t chain;   // Next entry of the same bucket, -1 at the end
+    int32_t newer;   // Neighbours in the LRU list, -1 at either end
+    int32_t older;
+} ic_service_entry_t;
+
+/**
+ * Fixed-size LRU map from (N, max_nodes, gas_limit) to a search result
+ * Entries live in one array and link by position, so a full cache
+ * recycles its least recently used entry without allocating.
+ */
+typedef struct {
+    ic_service_entry_t *entries;
+    int32_t *buckets;     // First entry of each chain, -1 if empty
+    size_t bucket_mask;
+    size_t capacity;
+    size_t count;
+    int32_t newest;       // -1 while empty
+    int32_t oldest;
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t evictions;
+} ic_service_cache_t;
+
+/**
+ * Create a cache of `capacity` entries
+ * @return 0 on success, -1 if capacity is 0 or out of memory
+ */
+int ic_service_cache_init(ic_service_cache_t *cache, size_t capacity);
+
+void ic_service_cache_destroy(ic_service_cache_t *cache);
+
+/**
+ * Look a key up and, if found, make it the most recently used
+ * @return true with *result filled if the key is cached
+ */
+bool ic_service_cache_lookup(ic_service_cache_t *cache, const ic_service_key_t *key,
+                             ic_batch_result_t *result);
+
+/**
+ * Remember a result, evicting the least recently used entry when full
+ */
+void ic_service_cache_insert(ic_service_cache_t *cache, const ic_service_key_t *key,
+                             const ic_batch_result_t *result);
+
+/**
+ * A search service: search settings, warm nets and the result cache
+ */
+typedef struct {
+    ic_enum_state_t base;      // Settings every request's search copies
+    ic_search_pool_t pool;     // Heap nets kept between searches
+    ic_service_cache_t cache;
+    uint64_t requests;         // Request lines handled
+    uint64_t searches;         // Searches run for them
+    double search_seconds;     // Time spent in those searches
+    uint64_t nets_created;     // The pool's counters after the last search,
+    uint64_t nets_reused;      // read without touching a running search
+} ic_service_t;
+
+// ic_service_handle results
+#define IC_SERVICE_CONTINUE 0
+#define IC_SERVICE_CLOSE 1     // The client said quit
+#define IC_SERVICE_SHUTDOWN 2  // The client asked the service to stop
+
+/**
+ * Start a service whose searches use base's range, thread count,
+ * placement, loop detection, slot reuse, pruning and deduplication
+ * Progress callbacks, dumps, checkpoints and --all streams are not used.
+ * @return 0 on success, -1 if out of memory
+ */
+int ic_service_init(ic_service_t *service, const ic_enum_state_t *base, size_t cache_capacity);
+
+void ic_service_destroy(ic_service_t *service);
+
+/**
+ * Answer one request line, writing the reply to `out`
+ *   factor <N> [max_nodes] [gas_limit]  one result line
+ *   batch <max_nodes> <gas_limit> <N>... one result line per N, in order
+ *   stats                                counters of the service
+ *   quit | shutdown
+ * A result line is "<N> <index> <factor_a> <factor_b> cached|searched",
+ * index -1 if the service's range has no solution; a bad request, or
+ * max_nodes or gas_limit above IC_SERVICE_MAX_NODES_MAX or
+ * IC_SERVICE_GAS_LIMIT_MAX, gets "error <reason>". Cached keys are
+ * answered without searching, and the uncached numbers of a batch share
+ * one ic_search_factor_batch pass. A search that fails gets one
+ * "error search failed" line and nothing is cached.
+ * @return IC_SERVICE_CONTINUE, IC_SERVICE_CLOSE or IC_SERVICE_SHUTDOWN
+ */
+int ic_service_handle(ic_service_t *service, const char *line, FILE *out);
+
+/**
+ * Open a listening socket: "unix:<path>" (an existing socket file is
+ * replaced), "tcp:<port>" on the loopback interface or "tcp:<host>:<port>"
+ * @return The socket, or -1 if the address is bad or cannot be bound
+ */
+int ic_service_listen(const char *address);
+
+/**
+ * Serve requests from every client of a listening socket, one request
+ * line at a time, until a client asks for shutdown
+ * Clients are polled together on non-blocking sockets, and replies a
+ * client has not read yet wait in its buffer, so a slow reader only holds
+ * up itself. Searches run on one worker thread, one after another on the
+ * whole thread team. A client's later requests wait for its search, and
+ * cache hits and other clients are answered meanwhile.
+ * @return 0 after a shutdown request, -1 if the socket failed
+ */
+int ic_service_run(ic_service_t *service, int listen_fd);
+
+#endif // IC_SERVICE_H
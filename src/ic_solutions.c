@@ -0,0 +1,211 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "ic_solutions.h"
+#include <inttypes.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <time.h>
+
+// Pause of an idle writer before it looks at the queue again
+#define IC_SOLUTION_WRITER_IDLE_NS 1000000L
+
+int ic_solution_queue_init(ic_solution_queue_t *queue, size_t capacity) {
+    if (!queue || capacity == 0 || (capacity & (capacity - 1)) != 0) return -1;
+
+    queue->slots = (ic_solution_slot_t*)malloc(capacity * sizeof(ic_solution_slot_t));
+    if (!queue->slots) return -1;
+
+    // Slot i is first free for the producer that claims position i
+    for (size_t i = 0; i < capacity; i++) {
+        atomic_init(&queue->slots[i].sequence, i);
+    }
+    queue->capacity = capacity;
+    atomic_init(&queue->head, 0);
+    queue->tail = 0;
+    return 0;
+}
+
+void ic_solution_queue_destroy(ic_solution_queue_t *queue) {
+    if (!queue) return;
+    free(queue->slots);
+    queue->slots = NULL;
+}
+
+bool ic_solution_queue_push(ic_solution_queue_t *queue, const ic_solution_t *solution) {
+    size_t position = atomic_load_explicit(&queue->head, memory_order_relaxed);
+    for (;;) {
+        ic_solution_slot_t *slot = &queue->slots[position & (queue->capacity - 1)];
+        size_t sequence = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+        intptr_t lag = (intptr_t)sequence - (intptr_t)position;
+
+        if (lag == 0) {
+            // The slot is free for this position; try to claim it
+            if (atomic_compare_exchange_weak_explicit(&queue->head, &position, position + 1,
+                                                      memory_order_relaxed,
+                                                      memory_order_relaxed)) {
+                slot->solution = *solution;
+                atomic_store_explicit(&slot->sequence, position + 1, memory_order_release);
+                return true;
+            }
+        } else if (lag < 0) {
+            // The consumer has not read this slot's previous solution yet
+            return false;
+        } else {
+            position = atomic_load_explicit(&queue->head, memory_order_relaxed);
+        }
+    }
+}
+
+bool ic_solution_queue_pop(ic_solution_queue_t *queue, ic_solution_t *solution) {
+    ic_solution_slot_t *slot = &queue->slots[queue->tail & (queue->capacity - 1)];
+    size_t sequence = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+    if (sequence != queue->tail + 1) return false;
+
+    *solution = slot->solution;
+
+    // Hand the slot to the producer one lap later
+    atomic_store_explicit(&slot->sequence, queue->tail + queue->capacity, memory_order_release);
+    queue->tail++;
+    return true;
+}
+
+/**
+ * Add a solution to the writer's heap (which must have room)
+ */
+static void ic_pending_push(ic_solution_writer_t *writer, const ic_solution_t *solution) {
+    ic_solution_t *heap = writer->pending;
+    size_t i = writer->pending_count++;
+    while (i > 0) {
+        size_t parent = (i - 1) / 2;
+        if (heap[parent].index <= solution->index) break;
+        heap[i] = heap[parent];
+        i = parent;
+    }
+    heap[i] = *solution;
+}
+
+/**
+ * Remove the pending solution with the smallest index
+ */
+static ic_solution_t ic_pending_pop(ic_solution_writer_t *writer) {
+    ic_solution_t *heap = writer->pending;
+    ic_solution_t top = heap[0];
+    ic_solution_t last = heap[--writer->pending_count];
+
+    size_t i = 0, count = writer->pending_count;
+    for (;;) {
+        size_t child = 2 * i + 1;
+        if (child >= count) break;
+        if (child + 1 < count && heap[child + 1].index < heap[child].index) child++;
+        if (last.index <= heap[child].index) break;
+        heap[i] = heap[child];
+        i = child;
+    }
+    if (count > 0) heap[i] = last;
+    return top;
+}
+
+/**
+ * Move queued solutions into the heap until the queue is empty or the
+ * heap is full
+ * @return true if anything moved
+ */
+static bool ic_solution_writer_drain(ic_solution_writer_t *writer) {
+    bool moved = false;
+    ic_solution_t solution;
+    while (writer->pending_count < writer->pending_capacity &&
+           ic_solution_queue_pop(&writer->queue, &solution)) {
+        ic_pending_push(writer, &solution);
+        moved = true;
+    }
+    return moved;
+}
+
+/**
+ * Write the pending solutions below the frontier, smallest index first
+ * @return true if anything was written
+ */
+static bool ic_solution_writer_flush(ic_solution_writer_t *writer, uint64_t frontier) {
+    bool moved = false;
+    while (writer->pending_count > 0 && writer->pending[0].index < frontier) {
+        ic_solution_t solution = ic_pending_pop(writer);
+        moved = true;
+        if (writer->failed) continue;
+        if (fprintf(writer->out, "%" PRIu64 " %d %d %d\n", solution.index, solution.N,
+                    solution.factor_a, solution.factor_b) < 0) {
+            writer->failed = true;
+            continue;
+        }
+        writer->written++;
+    }
+    return moved;
+}
+
+static void *ic_solution_writer_main(void *arg) {
+    ic_solution_writer_t *writer = (ic_solution_writer_t*)arg;
+
+    for (;;) {
+        // The frontier is read before draining, so every solution below
+        // it is already in the queue
+        bool finishing = atomic_load_explicit(&writer->done, memory_order_acquire);
+        uint64_t frontier = finishing ? UINT64_MAX : writer->frontier(writer->context);
+
+        bool moved = ic_solution_writer_drain(writer);
+        moved = ic_solution_writer_flush(writer, frontier) || moved;
+
+        if (finishing && !moved && writer->pending_count == 0) break;
+        if (!moved) {
+            struct timespec pause = { 0, IC_SOLUTION_WRITER_IDLE_NS };
+            nanosleep(&pause, NULL);
+        }
+    }
+    return NULL;
+}
+
+int ic_solution_writer_start(ic_solution_writer_t *writer, FILE *out,
+                             size_t queue_capacity, size_t pending_capacity,
+                             uint64_t (*frontier)(void *context), void *context) {
+    if (!writer || !out || !frontier || pending_capacity == 0) return -1;
+
+    writer->out = out;
+    writer->frontier = frontier;
+    writer->context = context;
+    writer->pending_count = 0;
+    writer->pending_capacity = pending_capacity;
+    writer->written = 0;
+    writer->failed = false;
+    atomic_init(&writer->done, false);
+    atomic_init(&writer->stalls, 0);
+
+    if (ic_solution_queue_init(&writer->queue, queue_capacity) != 0) return -1;
+    writer->pending = (ic_solution_t*)malloc(pending_capacity * sizeof(ic_solution_t));
+    if (!writer->pending) {
+        ic_solution_queue_destroy(&writer->queue);
+        return -1;
+    }
+    if (pthread_create(&writer->thread, NULL, ic_solution_writer_main, writer) != 0) {
+        free(writer->pending);
+        ic_solution_queue_destroy(&writer->queue);
+        return -1;
+    }
+    return 0;
+}
+
+void ic_solution_writer_submit(ic_solution_writer_t *writer, const ic_solution_t *solution) {
+    while (!ic_solution_queue_push(&writer->queue, solution)) {
+        atomic_fetch_add_explicit(&writer->stalls, 1, memory_order_relaxed);
+        sched_yield();
+    }
+}
+
+int ic_solution_writer_finish(ic_solution_writer_t *writer) {
+    if (!writer) return -1;
+
+    atomic_store_explicit(&writer->done, true, memory_order_release);
+    pthread_join(writer->thread, NULL);
+
+    free(writer->pending);
+    writer->pending = NULL;
+    ic_solution_queue_destroy(&writer->queue);
+    return (writer->failed || fflush(writer->out) != 0) ? -1 : 0;
+}
@@ -0,0 +1,115 @@
+#ifndef IC_SOLUTIONS_H
+#define IC_SOLUTIONS_H
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+/**
+ * One solving index of a search for every solution
+ */
+typedef struct {
+    uint64_t index;
+    int N;
+    int factor_a;
+    int factor_b;
+} ic_solution_t;
+
+/**
+ * Slot of the solution queue; its sequence number says whose turn it is
+ */
+typedef struct {
+    _Atomic size_t sequence;
+    ic_solution_t solution;
+} ic_solution_slot_t;
+
+/**
+ * Bounded lock-free queue from many search threads to one writer
+ * A producer claims the next position with a CAS on `head` and publishes
+ * the slot by advancing its sequence number; the consumer reads slots in
+ * position order. Neither side ever waits for the other: a push to a full
+ * queue and a pop from an empty one simply fail.
+ */
+typedef struct {
+    ic_solution_slot_t *slots;
+    size_t capacity;            // Power of two
+    _Atomic size_t head;        // Next position producers claim
+    size_t tail;                // Next position the consumer reads
+} ic_solution_queue_t;
+
+/**
+ * Create a queue of `capacity` slots (a power of two)
+ * @return 0 on success, -1 if capacity is not a power of two or on allocation failure
+ */
+int ic_solution_queue_init(ic_solution_queue_t *queue, size_t capacity);
+
+/**
+ * Free a queue's slots
+ */
+void ic_solution_queue_destroy(ic_solution_queue_t *queue);
+
+/**
+ * Append a solution; safe from any number of threads at once
+ * @return true if queued, false if the queue is full
+ */
+bool ic_solution_queue_push(ic_solution_queue_t *queue, const ic_solution_t *solution);
+
+/**
+ * Take the oldest solution; only one thread may pop
+ * @return true if one was taken, false if the queue is empty
+ */
+bool ic_solution_queue_pop(ic_solution_queue_t *queue, ic_solution_t *solution);
+
+/**
+ * Thread that writes queued solutions to a stream in index order
+ * Producers offer solutions out of order, so the writer keeps them in a
+ * min-heap until `frontier` reports that no index below them can still
+ * arrive. The heap holds at most `pending_capacity` solutions: producers
+ * must keep every solution they have yet to offer below
+ * frontier() + pending_capacity, so that a full heap always has some to
+ * write. Each line is "index N factor_a factor_b".
+ */
+typedef struct {
+    ic_solution_queue_t queue;
+    FILE *out;
+    uint64_t (*frontier)(void *context);  // Every index still to come is at least this
+    void *context;
+
+    ic_solution_t *pending;     // Min-heap by index, only touched by the writer
+    size_t pending_count;
+    size_t pending_capacity;
+
+    pthread_t thread;
+    _Atomic bool done;          // Set once no producer can push any more
+    _Atomic uint64_t stalls;    // Pushes that found the queue full and had to retry
+    uint64_t written;           // Lines written
+    bool failed;                // A write failed; later solutions are dropped
+} ic_solution_writer_t;
+
+/**
+ * Start a writer thread
+ * @return 0 on success, -1 if the queue, heap or thread could not be created
+ */
+int ic_solution_writer_start(ic_solution_writer_t *writer, FILE *out,
+                             size_t queue_capacity, size_t pending_capacity,
+                             uint64_t (*frontier)(void *context), void *context);
+
+/**
+ * Hand a solution to the writer from any producer thread
+ * Producers never touch the stream. If the writer has fallen a whole
+ * queue behind, the producer yields until a slot frees up, so memory stays
+ * bounded; such retries are counted in `stalls`.
+ */
+void ic_solution_writer_submit(ic_solution_writer_t *writer, const ic_solution_t *solution);
+
+/**
+ * Write everything still queued or pending, then stop the thread
+ * Call once every producer has finished.
+ * @return 0 if every line was written, -1 on a write error
+ */
+int ic_solution_writer_finish(ic_solution_writer_t *writer);
+
+#endif // IC_SOLUTIONS_H
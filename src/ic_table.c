@@ -0,0 +1,175 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "ic_table.h"
+#include "ic_search.h"
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+_Static_assert(sizeof(ic_outcome_t) == 12, "ic_outcome_t must stay 12 bytes on disk");
+_Static_assert(sizeof(ic_table_header_t) == 24, "ic_table_header_t must stay 24 bytes on disk");
+
+int ic_table_outcome(ic_net_t *net, size_t index, ic_outcome_t *out) {
+    if (!net || !out) return -1;
+    
+    net->input_number = 0;
+    if (ic_enum_build_net_compatible(NULL, index, net) != 0) {
+        return -1;
+    }
+    
+    int result = ic_net_reduce(net);
+    
+    uint16_t live = 0;
+    for (size_t i = 0; i < net->used_nodes; i++) {
+        if (net->active[i]) live++;
+    }
+    
+    int factor_a = 0, factor_b = 0;
+    bool has_pair = ic_net_factor_pair(net, &factor_a, &factor_b);
+    
+    out->gas_used = (uint32_t)net->gas_used;
+    out->live_nodes = live;
+    out->result = (uint8_t)result;
+    out->has_pair = has_pair ? 1 : 0;
+    out->factor_a = (uint16_t)factor_a;
+    out->factor_b = (uint16_t)factor_b;
+    return 0;
+}
+
+/**
+ * Cached outcome of a layout seen before by this thread
+ */
+typedef struct {
+    bool reduced;
+    ic_outcome_t outcome;
+} ic_table_cache_slot_t;
+
+int ic_table_precompute(const char *path, size_t count, size_t max_nodes, size_t gas_limit) {
+    if (!path || count == 0) return -1;
+    
+    ic_outcome_t *outcomes = (ic_outcome_t*)calloc(count, sizeof(ic_outcome_t));
+    if (!outcomes) return -1;
+    
+    int failed = 0;
+    
+    #pragma omp parallel
+    {
+        ic_net_t *net = ic_net_create(max_nodes, gas_limit);
+        ic_table_cache_slot_t *cache = (ic_table_cache_slot_t*)calloc(IC_ENUM_LAYOUTS,
+                                                                      sizeof(ic_table_cache_slot_t));
+        if (!net || !cache) {
+            #pragma omp atomic write
+            failed = 1;
+        }
+        
+        #pragma omp for schedule(dynamic, 100)
+        for (size_t index = 0; index < count; index++) {
+            if (failed) continue;
+            
+            // Most indices name a layout already seen; reuse its outcome
+            // without building the net
+            ic_table_cache_slot_t *slot = &cache[ic_enum_layout_id(index)];
+            if (slot->reduced) {
+                outcomes[index] = slot->outcome;
+                continue;
+            }
+            
+            if (ic_table_outcome(net, index, &outcomes[index]) != 0) {
+                #pragma omp atomic write
+                failed = 1;
+                continue;
+            }
+            slot->reduced = true;
+            slot->outcome = outcomes[index];
+        }
+        
+        free(cache);
+        ic_net_free(net);
+    }
+    
+    if (failed) {
+        free(outcomes);
+        return -1;
+    }
+    
+    FILE *out = fopen(path, "wb");
+    if (!out) {
+        free(outcomes);
+        return -1;
+    }
+    
+    ic_table_header_t header = {
+        .magic = IC_TABLE_MAGIC,
+        .version = IC_TABLE_VERSION,
+        .max_nodes = (uint32_t)max_nodes,
+        .gas_limit = (uint32_t)gas_limit,
+        .count = count,
+    };
+    
+    bool ok = fwrite(&header, sizeof(header), 1, out) == 1 &&
+              fwrite(outcomes, sizeof(ic_outcome_t), count, out) == count;
+    ok = (fclose(out) == 0) && ok;
+    
+    free(outcomes);
+    return ok ? 0 : -1;
+}
+
+int ic_table_open(ic_table_t *table, const char *path) {
+    if (!table || !path) return -1;
+    memset(table, 0, sizeof(*table));
+    
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return -1;
+    
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(ic_table_header_t)) {
+        close(fd);
+        return -1;
+    }
+    
+    size_t size = (size_t)st.st_size;
+    void *map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) return -1;
+    
+    // Reject foreign files and files cut short
+    const ic_table_header_t *header = (const ic_table_header_t*)map;
+    if (header->magic != IC_TABLE_MAGIC || header->version != IC_TABLE_VERSION ||
+        header->count > (size - sizeof(*header)) / sizeof(ic_outcome_t)) {
+        munmap(map, size);
+        return -1;
+    }
+    
+    table->header = header;
+    table->outcomes = (const ic_outcome_t*)(header + 1);
+    table->count = (size_t)header->count;
+    table->map = map;
+    table->map_size = size;
+    return 0;
+}
+
+void ic_table_close(ic_table_t *table) {
+    if (!table || !table->map) return;
+    munmap(table->map, table->map_size);
+    memset(table, 0, sizeof(*table));
+}
+
+int64_t ic_table_find_factor(const ic_table_t *table, int N, int *factor_a, int *factor_b) {
+    if (!table || !table->outcomes || N <= 1) return -1;
+    
+    // Outcomes are in index order, so the first match is the smallest index
+    for (size_t i = 0; i < table->count; i++) {
+        const ic_outcome_t *o = &table->outcomes[i];
+        if (o->has_pair && (int)o->factor_a * (int)o->factor_b == N) {
+            if (factor_a) *factor_a = o->factor_a;
+            if (factor_b) *factor_b = o->factor_b;
+            return (int64_t)i;
+        }
+    }
+    
+    return -1;
+}
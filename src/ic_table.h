@@ -0,0 +1,78 @@
+#ifndef IC_TABLE_H
+#define IC_TABLE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "ic_runtime.h"
+
+#define IC_TABLE_MAGIC   0x42544349u  // "ICTB" little-endian
+#define IC_TABLE_VERSION 1u
+
+/**
+ * Outcome of reducing the net built for one index (12 bytes on disk)
+ * The index→net mapping is deterministic, so for a fixed max_nodes and
+ * gas_limit this never changes and can be computed once and stored.
+ */
+typedef struct {
+    uint32_t gas_used;    // Rewrites performed before stopping
+    uint16_t live_nodes;  // Active nodes left in the final net
+    uint8_t result;       // Return value of ic_net_reduce (0 reduced, 1 out of gas)
+    uint8_t has_pair;     // 1 if exactly one δ and one γ survived
+    uint16_t factor_a;    // Surviving δ position + 1 (0 without a pair)
+    uint16_t factor_b;    // Surviving γ position + 1 (0 without a pair)
+} ic_outcome_t;
+
+/**
+ * File header, followed by `count` outcomes for indices 0..count-1
+ */
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t max_nodes;
+    uint32_t gas_limit;
+    uint64_t count;
+} ic_table_header_t;
+
+/**
+ * A read-only, memory-mapped outcome table
+ */
+typedef struct {
+    const ic_table_header_t *header;
+    const ic_outcome_t *outcomes;
+    size_t count;
+    void *map;           // Base of the mapping
+    size_t map_size;
+} ic_table_t;
+
+/**
+ * Build and reduce the net for one index and record its outcome
+ * @return 0 on success, -1 if the net could not be built
+ */
+int ic_table_outcome(ic_net_t *net, size_t index, ic_outcome_t *out);
+
+/**
+ * Reduce indices 0..count-1 and write their outcomes to a table file
+ * Indices with the same ic_enum_layout_id reuse their outcome.
+ * @return 0 on success, -1 on error
+ */
+int ic_table_precompute(const char *path, size_t count, size_t max_nodes, size_t gas_limit);
+
+/**
+ * Map a table file read-only and validate its header
+ * @return 0 on success, -1 on error
+ */
+int ic_table_open(ic_table_t *table, const char *path);
+
+/**
+ * Unmap a table opened with ic_table_open
+ */
+void ic_table_close(ic_table_t *table);
+
+/**
+ * Find the smallest index whose net factors N, without reducing anything
+ * @return The index of the solution, or -1 if none in the table
+ */
+int64_t ic_table_find_factor(const ic_table_t *table, int N, int *factor_a, int *factor_b);
+
+#endif // IC_TABLE_H
@@ -0,0 +1,240 @@
+#if defined(__linux__)
+#define _GNU_SOURCE
+#else
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include "ic_topology.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#if defined(__linux__)
+#include <sched.h>
+#include <sys/mman.h>
+#endif
+
+// Highest NUMA node id probed in sysfs
+#define IC_TOPOLOGY_MAX_NODES 64
+
+#if defined(__linux__)
+/**
+ * Mark the CPUs of a sysfs list such as "0-3,8-11" as belonging to `node`
+ */
+static void ic_topology_read_cpulist(const char *list, int node, int *node_of_cpu) {
+    const char *p = list;
+    while (*p) {
+        char *end;
+        long first = strtol(p, &end, 10);
+        if (end == p) break;
+        long last = first;
+        p = end;
+        if (*p == '-') {
+            last = strtol(p + 1, &end, 10);
+            p = end;
+        }
+        for (long cpu = first; cpu <= last && cpu < IC_TOPOLOGY_MAX_CPUS; cpu++) {
+            if (cpu >= 0) node_of_cpu[cpu] = node;
+        }
+        if (*p == ',') p++;
+        else if (*p != '\0') break;
+    }
+}
+#endif
+
+void ic_topology_detect(ic_topology_t *topo) {
+    if (!topo) return;
+    topo->num_cpus = 0;
+    topo->num_nodes = 0;
+
+    int node_of_cpu[IC_TOPOLOGY_MAX_CPUS];
+    bool allowed[IC_TOPOLOGY_MAX_CPUS];
+    for (int c = 0; c < IC_TOPOLOGY_MAX_CPUS; c++) {
+        node_of_cpu[c] = 0;
+        allowed[c] = false;
+    }
+
+#if defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    bool have_mask = sched_getaffinity(0, sizeof(set), &set) == 0;
+    for (int c = 0; c < IC_TOPOLOGY_MAX_CPUS && c < CPU_SETSIZE; c++) {
+        allowed[c] = have_mask ? CPU_ISSET(c, &set) != 0 : false;
+    }
+    if (!have_mask) {
+        long online = sysconf(_SC_NPROCESSORS_ONLN);
+        for (long c = 0; c < online && c < IC_TOPOLOGY_MAX_CPUS; c++) allowed[c] = true;
+    }
+
+    for (int node = 0; node < IC_TOPOLOGY_MAX_NODES; node++) {
+        char path[64];
+        snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", node);
+        FILE *in = fopen(path, "r");
+        if (!in) continue;
+        char list[4096];
+        if (fgets(list, sizeof(list), in)) {
+            list[strcspn(list, "\n")] = '\0';
+            ic_topology_read_cpulist(list, node, node_of_cpu);
+        }
+        fclose(in);
+    }
+#else
+    long online = sysconf(_SC_NPROCESSORS_ONLN);
+    if (online < 1) online = 1;
+    for (long c = 0; c < online && c < IC_TOPOLOGY_MAX_CPUS; c++) allowed[c] = true;
+#endif
+
+    // Group the CPUs by node so compact placement fills one node at a time
+    for (int node = 0; node < IC_TOPOLOGY_MAX_NODES; node++) {
+        int before = topo->num_cpus;
+        for (int c = 0; c < IC_TOPOLOGY_MAX_CPUS; c++) {
+            if (!allowed[c] || node_of_cpu[c] != node) continue;
+            topo->cpus[topo->num_cpus] = c;
+            topo->nodes[topo->num_cpus] = node;
+            topo->num_cpus++;
+        }
+        if (topo->num_cpus > before) topo->num_nodes++;
+    }
+
+    // An empty mask still leaves the current CPU to run on
+    if (topo->num_cpus == 0) {
+        topo->cpus[0] = 0;
+        topo->nodes[0] = 0;
+        topo->num_cpus = 1;
+        topo->num_nodes = 1;
+    }
+}
+
+int ic_topology_slot_for_thread(const ic_topology_t *topo, ic_pin_mode_t mode, int thread) {
+    if (!topo || topo->num_cpus == 0 || thread < 0 || mode == IC_PIN_NONE) return -1;
+    if (mode == IC_PIN_COMPACT || topo->num_nodes <= 1) {
+        return thread % topo->num_cpus;
+    }
+
+    // Scatter: thread t goes to the (t / nodes)-th CPU of node group t % nodes
+    int group = thread % topo->num_nodes;
+    int rank = thread / topo->num_nodes;
+    int start = 0, seen = 0;
+    while (start < topo->num_cpus) {
+        int count = 1;
+        while (start + count < topo->num_cpus &&
+               topo->nodes[start + count] == topo->nodes[start]) {
+            count++;
+        }
+        if (seen == group) return start + rank % count;
+        seen++;
+        start += count;
+    }
+    return thread % topo->num_cpus;
+}
+
+int ic_topology_pin_self(int cpu, ic_cpu_mask_t *previous) {
+    if (previous) previous->saved = false;
+#if defined(__linux__)
+    if (cpu < 0 || cpu >= CPU_SETSIZE) return -1;
+    cpu_set_t set;
+    if (previous && sched_getaffinity(0, sizeof(set), &set) == 0) {
+        memset(previous->bits, 0, sizeof(previous->bits));
+        for (int c = 0; c < IC_TOPOLOGY_MAX_CPUS && c < CPU_SETSIZE; c++) {
+            if (CPU_ISSET(c, &set)) previous->bits[c / 8] |= (unsigned char)(1u << (c % 8));
+        }
+        previous->saved = true;
+    }
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return (sched_setaffinity(0, sizeof(set), &set) == 0) ? 0 : -1;
+#else
+    (void)cpu;
+    return -1;
+#endif
+}
+
+void ic_topology_unpin_self(const ic_cpu_mask_t *previous) {
+    if (!previous || !previous->saved) return;
+#if defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int c = 0; c < IC_TOPOLOGY_MAX_CPUS && c < CPU_SETSIZE; c++) {
+        if (previous->bits[c / 8] & (1u << (c % 8))) CPU_SET(c, &set);
+    }
+    sched_setaffinity(0, sizeof(set), &set);
+#endif
+}
+
+void ic_topology_place(void *memory, size_t bytes, bool huge_pages) {
+    if (!memory || bytes == 0) return;
+    long page = sysconf(_SC_PAGESIZE);
+    if (page <= 0) page = 4096;
+
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+    if (huge_pages && bytes >= IC_TOPOLOGY_HUGE_BYTES) {
+        // madvise wants whole pages; hint the aligned interior
+        uintptr_t first = ((uintptr_t)memory + page - 1) & ~(uintptr_t)(page - 1);
+        uintptr_t last = ((uintptr_t)memory + bytes) & ~(uintptr_t)(page - 1);
+        if (last > first) madvise((void*)first, last - first, MADV_HUGEPAGE);
+    }
+#else
+    (void)huge_pages;
+#endif
+
+    // Rewrite one byte per page with its own value; the write faults it in
+    volatile unsigned char *bytes_of = (volatile unsigned char*)memory;
+    for (size_t offset = 0; offset < bytes; offset += (size_t)page) {
+        bytes_of[offset] = bytes_of[offset];
+    }
+    bytes_of[bytes - 1] = bytes_of[bytes - 1];
+}
+
+int ic_pin_mode_parse(const char *name, ic_pin_mode_t *mode) {
+    if (!name || !mode) return -1;
+    if (strcmp(name, "compact") == 0) {
+        *mode = IC_PIN_COMPACT;
+    } else if (strcmp(name, "scatter") == 0) {
+        *mode = IC_PIN_SCATTER;
+    } else {
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * Print the CPU ids of topo->cpus[start..end) as ranges, e.g. "0-3,8"
+ */
+static void ic_topology_print_cpus(const ic_topology_t *topo, int start, int end, FILE *out) {
+    for (int i = start; i < end; i++) {
+        int run = i;
+        while (run + 1 < end && topo->cpus[run + 1] == topo->cpus[run] + 1) run++;
+        fprintf(out, "%s%d", (i == start) ? "" : ",", topo->cpus[i]);
+        if (run > i) fprintf(out, "-%d", topo->cpus[run]);
+        i = run;
+    }
+}
+
+void ic_topology_print(const ic_topology_t *topo, ic_pin_mode_t mode, int threads,
+                       bool numa_local, FILE *out) {
+    if (!topo || !out) return;
+
+    fprintf(out, "Topology: %d NUMA node%s, %d CPU%s (", topo->num_nodes,
+            topo->num_nodes == 1 ? "" : "s", topo->num_cpus, topo->num_cpus == 1 ? "" : "s");
+    for (int start = 0; start < topo->num_cpus;) {
+        int end = start;
+        while (end < topo->num_cpus && topo->nodes[end] == topo->nodes[start]) end++;
+        fprintf(out, "%snode %d: ", (start == 0) ? "" : "; ", topo->nodes[start]);
+        ic_topology_print_cpus(topo, start, end, out);
+        start = end;
+    }
+
+    static const char *mode_names[] = { "unpinned", "compact pinning", "scatter pinning" };
+    fprintf(out, "); %d thread%s, %s%s\n", threads, threads == 1 ? "" : "s", mode_names[mode],
+            numa_local ? ", NUMA-local nets" : "");
+
+    if (mode == IC_PIN_NONE) return;
+    fprintf(out, "Thread placement:");
+    int shown = (threads < 16) ? threads : 16;
+    for (int t = 0; t < shown; t++) {
+        int slot = ic_topology_slot_for_thread(topo, mode, t);
+        fprintf(out, " %d->cpu%d", t, topo->cpus[slot]);
+    }
+    fprintf(out, "%s\n", (threads > shown) ? " ..." : "");
+}
@@ -0,0 +1,86 @@
+#ifndef IC_TOPOLOGY_H
+#define IC_TOPOLOGY_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+
+// Most CPUs a topology records
+#define IC_TOPOLOGY_MAX_CPUS 1024
+
+// Net storage from this size up is hinted for transparent huge pages
+#define IC_TOPOLOGY_HUGE_BYTES (2u << 20)
+
+/**
+ * Where search threads are pinned
+ */
+typedef enum {
+    IC_PIN_NONE,     // Leave placement to the OS (default)
+    IC_PIN_COMPACT,  // Thread t on the t-th CPU: fill one NUMA node first
+    IC_PIN_SCATTER   // Round-robin over NUMA nodes, then over their CPUs
+} ic_pin_mode_t;
+
+/**
+ * CPUs this process may run on, grouped by NUMA node
+ */
+typedef struct {
+    int num_cpus;
+    int num_nodes;                       // Nodes with at least one of the CPUs
+    int cpus[IC_TOPOLOGY_MAX_CPUS];      // CPU ids, by node, ascending within a node
+    int nodes[IC_TOPOLOGY_MAX_CPUS];     // NUMA node of cpus[i]
+} ic_topology_t;
+
+/**
+ * Read the CPUs of the process's affinity mask and their NUMA nodes from
+ * /sys/devices/system/node; elsewhere, one node with every online CPU
+ */
+void ic_topology_detect(ic_topology_t *topo);
+
+/**
+ * Index into topo->cpus for search thread `thread` under `mode`
+ * @return The index, or -1 for IC_PIN_NONE
+ */
+int ic_topology_slot_for_thread(const ic_topology_t *topo, ic_pin_mode_t mode, int thread);
+
+/**
+ * CPUs a thread was allowed to run on before it was pinned
+ */
+typedef struct {
+    unsigned char bits[IC_TOPOLOGY_MAX_CPUS / 8];
+    bool saved;
+} ic_cpu_mask_t;
+
+/**
+ * Pin the calling thread to one CPU, saving its previous mask in
+ * `previous` (may be NULL); OpenMP keeps its threads between parallel
+ * regions, so a search restores the mask when it ends
+ * @return 0 on success, -1 if the OS refused or cannot pin threads
+ */
+int ic_topology_pin_self(int cpu, ic_cpu_mask_t *previous);
+
+/**
+ * Give the calling thread back the mask ic_topology_pin_self saved
+ */
+void ic_topology_unpin_self(const ic_cpu_mask_t *previous);
+
+/**
+ * Fault in every page of freshly allocated memory from the calling thread,
+ * so that first touch places it on that thread's NUMA node; with
+ * huge_pages, ranges of IC_TOPOLOGY_HUGE_BYTES or more are first hinted
+ * for transparent huge pages. Contents are left unchanged.
+ */
+void ic_topology_place(void *memory, size_t bytes, bool huge_pages);
+
+/**
+ * Parse "compact" or "scatter"
+ * @return 0 on success, -1 for anything else
+ */
+int ic_pin_mode_parse(const char *name, ic_pin_mode_t *mode);
+
+/**
+ * Print the topology and how `threads` search threads will be placed
+ */
+void ic_topology_print(const ic_topology_t *topo, ic_pin_mode_t mode, int threads,
+                       bool numa_local, FILE *out);
+
+#endif // IC_TOPOLOGY_H
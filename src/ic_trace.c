@@ -0,0 +1,330 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "ic_trace.h"
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Pause of an idle flusher before it looks at the rings again
+#define IC_TRACE_FLUSH_IDLE_NS 1000000L
+
+// Events the converter reads at a time
+#define IC_TRACE_EXPORT_BATCH 4096
+
+_Static_assert(sizeof(ic_trace_event_t) == 24, "ic_trace_event_t must stay 24 bytes on disk");
+_Static_assert(sizeof(ic_trace_header_t) == 16, "ic_trace_header_t must stay 16 bytes on disk");
+_Static_assert((IC_TRACE_RING_EVENTS & (IC_TRACE_RING_EVENTS - 1)) == 0,
+               "IC_TRACE_RING_EVENTS must be a power of two");
+
+_Thread_local unsigned ic_trace_local_session = 0;
+_Thread_local ic_trace_ring_t *ic_trace_local_ring = NULL;
+_Atomic unsigned ic_trace_session = 0;
+
+/**
+ * The running trace; only one exists at a time
+ */
+static struct {
+    FILE *out;
+    pthread_t flusher;
+    pthread_mutex_t lock;      // Guards adding to `rings`
+    ic_trace_ring_t *rings;
+    uint16_t threads;          // Rings handed out so far
+    _Atomic bool done;         // Set once the flusher should finish
+    uint64_t start_ns;         // Monotonic clock at ic_trace_start
+    uint64_t written;          // Events in the file, only touched by the flusher
+    bool failed;               // A write failed; later events are discarded
+    unsigned last_session;     // Session number of the latest trace
+} ic_trace = { .lock = PTHREAD_MUTEX_INITIALIZER };
+
+static uint64_t ic_trace_now(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec;
+}
+
+/**
+ * Write out everything a ring holds
+ * @return true if anything was written
+ */
+static bool ic_trace_drain(ic_trace_ring_t *ring) {
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    size_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+    if (tail == head) return false;
+
+    // At most two contiguous runs: up to the end of the buffer, then from its start
+    while (tail != head) {
+        size_t at = tail & (IC_TRACE_RING_EVENTS - 1);
+        size_t run = head - tail;
+        if (run > IC_TRACE_RING_EVENTS - at) run = IC_TRACE_RING_EVENTS - at;
+        if (!ic_trace.failed) {
+            if (fwrite(&ring->events[at], sizeof(ic_trace_event_t), run, ic_trace.out) == run) {
+                ic_trace.written += run;
+            } else {
+                ic_trace.failed = true;
+            }
+        }
+        tail += run;
+    }
+
+    // Hand the slots back to the ring's thread
+    atomic_store_explicit(&ring->tail, tail, memory_order_release);
+    return true;
+}
+
+/**
+ * Drain every registered ring once
+ * @return true if anything was written
+ */
+static bool ic_trace_drain_all(void) {
+    pthread_mutex_lock(&ic_trace.lock);
+    ic_trace_ring_t *rings = ic_trace.rings;
+    pthread_mutex_unlock(&ic_trace.lock);
+
+    // Rings are only ever pushed in front, so this list stays valid
+    bool moved = false;
+    for (ic_trace_ring_t *ring = rings; ring; ring = ring->next) {
+        moved = ic_trace_drain(ring) || moved;
+    }
+    return moved;
+}
+
+static void *ic_trace_flusher_main(void *arg) {
+    (void)arg;
+    for (;;) {
+        // Read before draining, so events recorded before the stop are written
+        bool finishing = atomic_load_explicit(&ic_trace.done, memory_order_acquire);
+        bool moved = ic_trace_drain_all();
+        if (finishing) break;
+        if (!moved) {
+            struct timespec pause = { 0, IC_TRACE_FLUSH_IDLE_NS };
+            nanosleep(&pause, NULL);
+        }
+    }
+    return NULL;
+}
+
+int ic_trace_start(const char *path) {
+#ifndef IC_TRACE
+    // Without the hooks no thread would ever record an event
+    return -1;
+#endif
+    if (!path || atomic_load(&ic_trace_session) != 0) return -1;
+
+    FILE *out = fopen(path, "wb");
+    if (!out) return -1;
+
+    ic_trace_header_t header = {
+        .magic = IC_TRACE_MAGIC,
+        .version = IC_TRACE_VERSION,
+        .event_bytes = sizeof(ic_trace_event_t),
+        .ring_events = IC_TRACE_RING_EVENTS,
+    };
+    if (fwrite(&header, sizeof(header), 1, out) != 1) {
+        fclose(out);
+        return -1;
+    }
+
+    ic_trace.out = out;
+    ic_trace.rings = NULL;
+    ic_trace.threads = 0;
+    ic_trace.written = 0;
+    ic_trace.failed = false;
+    ic_trace.start_ns = ic_trace_now();
+    atomic_store(&ic_trace.done, false);
+    if (pthread_create(&ic_trace.flusher, NULL, ic_trace_flusher_main, NULL) != 0) {
+        fclose(out);
+        return -1;
+    }
+
+    // Session 0 means "none", so numbers skip it when they wrap
+    if (++ic_trace.last_session == 0) ic_trace.last_session = 1;
+    atomic_store(&ic_trace_session, ic_trace.last_session);
+    return 0;
+}
+
+void ic_trace_attach(void) {
+    unsigned session = atomic_load_explicit(&ic_trace_session, memory_order_acquire);
+    if (session == 0 || ic_trace_local_session == session) return;
+
+    ic_trace_ring_t *ring = (ic_trace_ring_t*)calloc(1, sizeof(ic_trace_ring_t));
+    if (ring) ring->events = (ic_trace_event_t*)malloc(IC_TRACE_RING_EVENTS * sizeof(ic_trace_event_t));
+    if (!ring || !ring->events) {
+        // The thread simply goes untraced
+        free(ring);
+        return;
+    }
+    atomic_init(&ring->head, 0);
+    atomic_init(&ring->tail, 0);
+    atomic_init(&ring->dropped, 0);
+
+    pthread_mutex_lock(&ic_trace.lock);
+    ring->thread = ic_trace.threads++;
+    ring->next = ic_trace.rings;
+    ic_trace.rings = ring;
+    pthread_mutex_unlock(&ic_trace.lock);
+
+    ic_trace_local_ring = ring;
+    ic_trace_local_session = session;
+}
+
+void ic_trace_record(ic_trace_kind_t kind, unsigned detail, uint64_t value, uint32_t extra) {
+    ic_trace_ring_t *ring = ic_trace_local_ring;
+    size_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    if (head - tail >= IC_TRACE_RING_EVENTS) {
+        atomic_fetch_add_explicit(&ring->dropped, 1, memory_order_relaxed);
+        return;
+    }
+
+    ic_trace_event_t *event = &ring->events[head & (IC_TRACE_RING_EVENTS - 1)];
+    event->time_ns = ic_trace_now() - ic_trace.start_ns;
+    event->value = value;
+    event->extra = extra;
+    event->thread = ring->thread;
+    event->kind = (uint8_t)kind;
+    event->detail = (uint8_t)detail;
+
+    // Publish the event to the flusher
+    atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+}
+
+int64_t ic_trace_stop(void) {
+    if (atomic_load(&ic_trace_session) == 0) return -1;
+
+    // No thread records from here on; the flusher drains what is left
+    atomic_store(&ic_trace_session, 0);
+    atomic_store_explicit(&ic_trace.done, true, memory_order_release);
+    pthread_join(ic_trace.flusher, NULL);
+
+    // Each thread that lost events says how many, at the end of its timeline
+    uint64_t end = ic_trace_now() - ic_trace.start_ns;
+    ic_trace_ring_t *ring = ic_trace.rings;
+    while (ring) {
+        uint64_t dropped = atomic_load(&ring->dropped);
+        if (dropped > 0 && !ic_trace.failed) {
+            ic_trace_event_t event = {
+                .time_ns = end, .value = dropped, .thread = ring->thread, .kind = IC_TRACE_DROPPED,
+            };
+            if (fwrite(&event, sizeof(event), 1, ic_trace.out) == 1) {
+                ic_trace.written++;
+            } else {
+                ic_trace.failed = true;
+            }
+        }
+
+        ic_trace_ring_t *next = ring->next;
+        free(ring->events);
+        free(ring);
+        ring = next;
+    }
+    ic_trace.rings = NULL;
+
+    bool ok = !ic_trace.failed;
+    ok = (fclose(ic_trace.out) == 0) && ok;
+    ic_trace.out = NULL;
+    return ok ? (int64_t)ic_trace.written : -1;
+}
+
+/**
+ * Name of an instant event
+ */
+static const char *ic_trace_instant_name(const ic_trace_event_t *event) {
+    static const char *const rules[] = { "δδ", "γγ", "δγ", "ε" };
+    static const char *const queue[] = { "queue grown", "redex dropped", "fixed net overflowed" };
+
+    switch (event->kind) {
+        case IC_TRACE_REWRITE:
+            return (event->detail < 4) ? rules[event->detail] : "rewrite";
+        case IC_TRACE_RESCAN:
+            return "rescan";
+        case IC_TRACE_QUEUE_FULL:
+            return (event->detail < 3) ? queue[event->detail] : "queue full";
+        case IC_TRACE_DROPPED:
+            return "events dropped";
+        default:
+            return "unknown";
+    }
+}
+
+int64_t ic_trace_export_chrome(FILE *in, FILE *out) {
+    if (!in || !out) return -1;
+
+    ic_trace_header_t header;
+    if (fread(&header, sizeof(header), 1, in) != 1 || header.magic != IC_TRACE_MAGIC ||
+        header.version != IC_TRACE_VERSION || header.event_bytes != sizeof(ic_trace_event_t)) {
+        return -1;
+    }
+
+    // Threads already given a name, one bit each
+    uint8_t *named = (uint8_t*)calloc((UINT16_MAX + 1) / 8, 1);
+    ic_trace_event_t *batch = (ic_trace_event_t*)malloc(IC_TRACE_EXPORT_BATCH * sizeof(ic_trace_event_t));
+    if (!named || !batch) {
+        free(named);
+        free(batch);
+        return -1;
+    }
+
+    fprintf(out, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[");
+    const char *separator = "\n";
+    int64_t converted = 0;
+    size_t read;
+    while ((read = fread(batch, sizeof(ic_trace_event_t), IC_TRACE_EXPORT_BATCH, in)) > 0) {
+        for (size_t i = 0; i < read; i++) {
+            const ic_trace_event_t *event = &batch[i];
+            unsigned tid = event->thread;
+            if (!(named[tid / 8] & (1u << (tid % 8)))) {
+                named[tid / 8] |= (uint8_t)(1u << (tid % 8));
+                fprintf(out, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,"
+                        "\"args\":{\"name\":\"search thread %u\"}}", separator, tid, tid);
+                separator = ",\n";
+            }
+
+            // Microseconds with nanosecond digits
+            fprintf(out, "%s{\"pid\":1,\"tid\":%u,\"ts\":%" PRIu64 ".%03u,", separator, tid,
+                    event->time_ns / 1000, (unsigned)(event->time_ns % 1000));
+            switch (event->kind) {
+                case IC_TRACE_CHUNK_BEGIN:
+                    fprintf(out, "\"ph\":\"B\",\"name\":\"chunk\",\"args\":{\"start\":%" PRIu64
+                            ",\"indices\":%" PRIu32 "}}", event->value, event->extra);
+                    break;
+                case IC_TRACE_CHUNK_END:
+                    fprintf(out, "\"ph\":\"E\"}");
+                    break;
+                case IC_TRACE_INDEX_BEGIN:
+                    fprintf(out, "\"ph\":\"B\",\"name\":\"index\",\"args\":{\"index\":%" PRIu64 "}}",
+                            event->value);
+                    break;
+                case IC_TRACE_INDEX_END:
+                    fprintf(out, "\"ph\":\"E\",\"args\":{\"status\":%u,\"gas\":%" PRIu32 "}}",
+                            event->detail, event->extra);
+                    break;
+                case IC_TRACE_REWRITE:
+                    fprintf(out, "\"ph\":\"i\",\"s\":\"t\",\"name\":\"%s\",\"args\":{\"a\":%" PRIu64
+                            ",\"b\":%" PRIu32 "}}", ic_trace_instant_name(event), event->value,
+                            event->extra);
+                    break;
+                case IC_TRACE_QUEUE_FULL:
+                    fprintf(out, "\"ph\":\"i\",\"s\":\"t\",\"name\":\"%s\",\"args\":{\"capacity\":%"
+                            PRIu32 "}}", ic_trace_instant_name(event), event->extra);
+                    break;
+                case IC_TRACE_DROPPED:
+                    fprintf(out, "\"ph\":\"i\",\"s\":\"t\",\"name\":\"%s\",\"args\":{\"count\":%"
+                            PRIu64 "}}", ic_trace_instant_name(event), event->value);
+                    break;
+                default:
+                    fprintf(out, "\"ph\":\"i\",\"s\":\"t\",\"name\":\"%s\"}", ic_trace_instant_name(event));
+                    break;
+            }
+            separator = ",\n";
+            converted++;
+        }
+    }
+    fprintf(out, "\n]}\n");
+
+    bool ok = !ferror(in);
+    free(named);
+    free(batch);
+    return ok ? converted : -1;
+}
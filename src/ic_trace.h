@@ -0,0 +1,148 @@
+#ifndef IC_TRACE_H
+#define IC_TRACE_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#define IC_TRACE_MAGIC   0x52544349u  // "ICTR" little-endian
+#define IC_TRACE_VERSION 1u
+
+// Events each thread's ring holds before its oldest unflushed ones are
+// dropped (power of two)
+#define IC_TRACE_RING_EVENTS (1u << 16)
+
+/**
+ * What a trace event records
+ */
+typedef enum {
+    IC_TRACE_CHUNK_BEGIN = 1,  // value: first index of a claimed chunk, extra: its length
+    IC_TRACE_CHUNK_END,
+    IC_TRACE_INDEX_BEGIN,      // value: index whose reduction starts
+    IC_TRACE_INDEX_END,        // value: index, extra: gas used, detail: ic_net_reduce result
+    IC_TRACE_REWRITE,          // value: node_a, extra: node_b, detail: ic_trace_rule_t
+    IC_TRACE_RESCAN,           // A full scan for redexes after the first one
+    IC_TRACE_QUEUE_FULL,       // extra: queue capacity, detail: ic_trace_queue_t
+    IC_TRACE_DROPPED           // value: events this thread's full ring had to drop
+} ic_trace_kind_t;
+
+/**
+ * Rewrite rules, as IC_TRACE_REWRITE details
+ */
+typedef enum {
+    IC_TRACE_DELTA_DELTA,
+    IC_TRACE_GAMMA_GAMMA,
+    IC_TRACE_DELTA_GAMMA,
+    IC_TRACE_EPSILON
+} ic_trace_rule_t;
+
+/**
+ * What a full redex queue did, as IC_TRACE_QUEUE_FULL details
+ */
+typedef enum {
+    IC_TRACE_QUEUE_GROWN,    // The queue doubled
+    IC_TRACE_QUEUE_DROPPED,  // The redex was dropped and will be found by a rescan
+    IC_TRACE_QUEUE_FALLBACK  // A fixed net overflowed and is reduced again on the heap
+} ic_trace_queue_t;
+
+/**
+ * One event as stored in a trace file (24 bytes)
+ */
+typedef struct {
+    uint64_t time_ns;  // Since ic_trace_start
+    uint64_t value;
+    uint32_t extra;
+    uint16_t thread;   // Order in which the thread joined the trace
+    uint8_t kind;      // ic_trace_kind_t
+    uint8_t detail;
+} ic_trace_event_t;
+
+/**
+ * Trace file header, followed by events; each thread's events are in time
+ * order, but threads are interleaved in the order their rings were flushed
+ */
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t event_bytes;  // sizeof(ic_trace_event_t)
+    uint32_t ring_events;  // IC_TRACE_RING_EVENTS of the writer
+} ic_trace_header_t;
+
+/**
+ * Per-thread ring of events not yet written to the trace file
+ * Only its thread appends (advancing `head`) and only the flusher thread
+ * removes (advancing `tail`), so neither ever takes a lock. An event that
+ * finds the ring full is counted in `dropped` instead of waiting.
+ */
+typedef struct ic_trace_ring {
+    ic_trace_event_t *events;
+    _Atomic size_t head;
+    _Atomic size_t tail;
+    _Atomic uint64_t dropped;
+    uint16_t thread;
+    struct ic_trace_ring *next;  // Registered rings, newest first
+} ic_trace_ring_t;
+
+// Session the calling thread's ring belongs to, 0 if it has none
+extern _Thread_local unsigned ic_trace_local_session;
+extern _Thread_local ic_trace_ring_t *ic_trace_local_ring;
+
+// Session being traced, 0 while no trace runs
+extern _Atomic unsigned ic_trace_session;
+
+/**
+ * Start tracing into a new binary file; needs a build with -DIC_TRACE
+ * (make TRACE=1)
+ * A flusher thread writes the threads' rings to the file in the
+ * background, so traced threads never touch the stream. Only one trace
+ * runs at a time, and only threads that called ic_trace_attach since it
+ * started record events.
+ * @return 0 on success, -1 without IC_TRACE, if a trace already runs or
+ *         if the file or thread could not be created
+ */
+int ic_trace_start(const char *path);
+
+/**
+ * Give the calling thread a ring in the running trace, if it has none yet
+ * Does nothing when no trace runs. Call it where a thread starts traced
+ * work; with the hooks compiled out, use IC_TRACE_ATTACH().
+ */
+void ic_trace_attach(void);
+
+/**
+ * Flush every ring, record what each dropped, close the file and free the
+ * rings; call it once no traced work is running
+ * @return Events written, or -1 if no trace ran or a write failed
+ */
+int64_t ic_trace_stop(void);
+
+/**
+ * Append an event to the calling thread's ring (use IC_TRACE_EVENT)
+ */
+void ic_trace_record(ic_trace_kind_t kind, unsigned detail, uint64_t value, uint32_t extra);
+
+/**
+ * Convert a trace file to the Chrome trace event format (JSON), which
+ * chrome://tracing and Perfetto show as one timeline per thread: chunks
+ * and index reductions as nested slices, rewrites, rescans and full
+ * queues as instant events
+ * @return Events converted, or -1 if the file is not a trace or cannot be read
+ */
+int64_t ic_trace_export_chrome(FILE *in, FILE *out);
+
+#ifdef IC_TRACE
+#define IC_TRACE_ATTACH() ic_trace_attach()
+#define IC_TRACE_EVENT(kind, detail, value, extra) do { \
+        if (ic_trace_local_session != 0 && \
+            ic_trace_local_session == atomic_load_explicit(&ic_trace_session, memory_order_relaxed)) { \
+            ic_trace_record((kind), (detail), (value), (extra)); \
+        } \
+    } while (0)
+#else
+#define IC_TRACE_ATTACH() ((void)0)
+#define IC_TRACE_EVENT(kind, detail, value, extra) ((void)0)
+#endif
+
+#endif // IC_TRACE_H
@@ -1,54 +1,813 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <time.h>
-#include <math.h>
+#include <inttypes.h>
+#include <unistd.h>
 #include "ic_runtime.h"
 #include "ic_search.h"
+#include "ic_table.h"
+#include "ic_result.h"
+#include "ic_topology.h"
+#include "ic_netfile.h"
+#include "ic_levin.h"
+#include "ic_service.h"
+#include "ic_trace.h"
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 // Callback for reporting search progress
-void progress_callback(size_t current_index, bool found_solution) {
-    static size_t last_reported = 0;
-    static struct timespec start_time;
-    static bool timer_initialized = false;
-    
-    // Initialize timer on first call
-    if (!timer_initialized) {
-        clock_gettime(CLOCK_MONOTONIC, &start_time);
-        timer_initialized = true;
-    }
-    
+// The search calls this from one reporter thread at a time with totals
+// over all threads, so no locking or local timing is needed here
+void progress_callback(size_t current_index, bool found_solution,
+                       const ic_search_progress_t *progress) {
     if (found_solution) {
         // Clear the current line and report solution
         printf("\nFound solution at index %zu!\n", current_index);
+        return;
+    }
+    
+    // Clear the line and update progress with machine-wide throughput
+    printf("\rSearched through %" PRIu64 " indices... (%.1f indices/sec, %.1f rewrites/sec, %d threads)",
+           progress->indices, progress->indices_per_sec, progress->rewrites_per_sec,
+           progress->threads);
+    fflush(stdout); // Ensure it displays immediately
+}
+
+/**
+ * Read whitespace-separated numbers to factor from a file ("-" for stdin)
+ * @return Number of values read, or -1 on error; *out must be freed
+ */
+static long read_batch_targets(const char *path, int **out) {
+    FILE *in = (path[0] == '-' && path[1] == '\0') ? stdin : fopen(path, "r");
+    if (!in) {
+        fprintf(stderr, "Cannot open batch file %s\n", path);
+        return -1;
+    }
+    
+    size_t count = 0, capacity = 16;
+    int *values = (int*)malloc(capacity * sizeof(int));
+    int value;
+    while (values && fscanf(in, "%d", &value) == 1) {
+        if (count == capacity) {
+            capacity *= 2;
+            int *grown = (int*)realloc(values, capacity * sizeof(int));
+            if (!grown) {
+                free(values);
+                values = NULL;
+                break;
+            }
+            values = grown;
+        }
+        values[count++] = value;
+    }
+    
+    if (in != stdin) fclose(in);
+    if (!values) return -1;
+    *out = values;
+    return (long)count;
+}
+
+/**
+ * Search options that may appear anywhere on the command line
+ */
+typedef struct {
+    uint64_t limit;          // Indices to search
+    uint64_t range_start;    // Explicit --range, used if has_range
+    uint64_t range_end;
+    bool has_range;
+    uint64_t shard_k;        // --shard k/n, used if shard_n > 0
+    uint64_t shard_n;
+    const char *checkpoint;  // Checkpoint file, or NULL
+    bool resume;             // Continue from the checkpoint file
+    const char *result;      // Result record file, or NULL
+    size_t loop_check;       // Loop detection interval, 0 = off
+    bool reuse;              // Recycle erased node slots in the search nets
+    int threads;             // Search threads, 0 = OpenMP default
+    ic_pin_mode_t pin;       // Where search threads are pinned
+    bool numa;               // NUMA-local nets
+    const char *dump;        // File for the reduced nets the search streams, or NULL
+    bool dump_pairs;         // Dump every net with a factor pair, not just solutions
+    const char *all;         // File for every solving index, or NULL
+    bool levin;              // Levin-style phases instead of one pass at full gas
+    const char *trace;       // Binary trace file of the search, or NULL
+} search_options_t;
+
+/**
+ * Remove the search options from argv into opts
+ * @return 0 on success, -1 if an option is missing or has a bad value
+ */
+static int parse_search_options(int *argc, char **argv, search_options_t *opts) {
+    memset(opts, 0, sizeof(*opts));
+    opts->limit = IC_SEARCH_LIMIT_DEFAULT;
+    opts->loop_check = IC_LOOP_CHECK_INTERVAL_DEFAULT;
+    
+    int kept = 1;
+    for (int i = 1; i < *argc; i++) {
+        bool is_limit = strcmp(argv[i], "--limit") == 0;
+        bool is_checkpoint = strcmp(argv[i], "--checkpoint") == 0;
+        bool is_resume = strcmp(argv[i], "--resume") == 0;
+        bool is_range = strcmp(argv[i], "--range") == 0;
+        bool is_shard = strcmp(argv[i], "--shard") == 0;
+        bool is_result = strcmp(argv[i], "--result") == 0;
+        bool is_loop_check = strcmp(argv[i], "--loop-check") == 0;
+        bool is_threads = strcmp(argv[i], "--threads") == 0;
+        bool is_pin = strcmp(argv[i], "--pin") == 0;
+        bool is_dump = strcmp(argv[i], "--dump") == 0;
+        bool is_all = strcmp(argv[i], "--all") == 0;
+        bool is_trace = strcmp(argv[i], "--trace") == 0;
+        
+        if (strcmp(argv[i], "--numa") == 0) {
+            opts->numa = true;
+            continue;
+        }
+        if (strcmp(argv[i], "--dump-pairs") == 0) {
+            opts->dump_pairs = true;
+            continue;
+        }
+        if (strcmp(argv[i], "--levin") == 0) {
+            opts->levin = true;
+            continue;
+        }
+        if (strcmp(argv[i], "--reuse") == 0) {
+            opts->reuse = true;
+            continue;
+        }
+        if (!is_limit && !is_checkpoint && !is_resume && !is_range && !is_shard && !is_result &&
+            !is_loop_check && !is_threads && !is_pin && !is_dump && !is_all &&
+            !is_trace) {
+            argv[kept++] = argv[i];
+            continue;
+        }
+        if (i + 1 >= *argc) {
+            fprintf(stderr, "%s needs a value\n", argv[i]);
+            return -1;
+        }
+        
+        const char *value = argv[++i];
+        if (is_limit) {
+            opts->limit = strtoull(value, NULL, 10);
+        } else if (is_range) {
+            if (sscanf(value, "%" SCNu64 ":%" SCNu64, &opts->range_start, &opts->range_end) != 2 ||
+                opts->range_start > opts->range_end) {
+                fprintf(stderr, "--range expects start:end, got %s\n", value);
+                return -1;
+            }
+            opts->has_range = true;
+        } else if (is_shard) {
+            if (sscanf(value, "%" SCNu64 "/%" SCNu64, &opts->shard_k, &opts->shard_n) != 2 ||
+                opts->shard_k >= opts->shard_n) {
+                fprintf(stderr, "--shard expects k/n with k < n, got %s\n", value);
+                return -1;
+            }
+        } else if (is_result) {
+            opts->result = value;
+        } else if (is_dump) {
+            opts->dump = value;
+        } else if (is_all) {
+            opts->all = value;
+        } else if (is_trace) {
+            opts->trace = value;
+        } else if (is_loop_check) {
+            opts->loop_check = strtoull(value, NULL, 10);
+        } else if (is_threads) {
+            opts->threads = atoi(value);
+            if (opts->threads < 1) {
+                fprintf(stderr, "--threads expects a positive count, got %s\n", value);
+                return -1;
+            }
+        } else if (is_pin) {
+            if (ic_pin_mode_parse(value, &opts->pin) != 0) {
+                fprintf(stderr, "--pin expects compact or scatter, got %s\n", value);
+                return -1;
+            }
+        } else {
+            opts->checkpoint = value;
+            opts->resume = is_resume;
+        }
+    }
+    
+    *argc = kept;
+    return 0;
+}
+
+static void apply_search_options(ic_enum_state_t *state, const search_options_t *opts) {
+    ic_enum_set_search_limit(state, opts->limit);
+    ic_enum_set_loop_check(state, opts->loop_check);
+    ic_enum_set_slot_reuse(state, opts->reuse);
+    ic_enum_set_threads(state, opts->threads);
+    ic_enum_set_placement(state, opts->pin, opts->numa);
+    if (opts->has_range) {
+        ic_enum_set_range(state, opts->range_start, opts->range_end);
+    }
+    if (opts->shard_n > 0) {
+        ic_enum_set_shard(state, opts->shard_k, opts->shard_n);
+    }
+    if (opts->checkpoint) {
+        ic_enum_set_checkpoint(state, opts->checkpoint, IC_CHECKPOINT_INTERVAL_DEFAULT, opts->resume);
+    }
+}
+
+/**
+ * Open the stream the search dumps reduced nets to: the --dump file if
+ * given, otherwise, when the caller wants the solving net back, an
+ * anonymous temporary file
+ * @return The stream, or NULL if there is none; *failed is set if the
+ *         --dump file could not be created
+ */
+static FILE *open_dump(const search_options_t *opts, bool read_back, bool *failed) {
+    *failed = false;
+    if (!opts->dump) return read_back ? tmpfile() : NULL;
+    
+    FILE *dump = fopen(opts->dump, read_back ? "w+b" : "wb");
+    if (!dump) {
+        fprintf(stderr, "Cannot create net dump %s\n", opts->dump);
+        *failed = true;
+    }
+    return dump;
+}
+
+/**
+ * Read the dumped net of one index back from the start of the dump
+ * @return true if `net` now holds it
+ */
+static bool read_dumped_net(FILE *dump, uint64_t index, ic_net_t *net) {
+    if (!dump || fflush(dump) != 0 || fseek(dump, 0, SEEK_SET) != 0) return false;
+    
+    ic_netfile_header_t header;
+    int read;
+    while ((read = ic_net_read(dump, net, &header)) != 0) {
+        if (read == 1 && header.index == index) return true;
+    }
+    return false;
+}
+
+/**
+ * Close the --dump file, if any, and say what went into it
+ */
+static void close_dump(FILE *dump, const ic_enum_state_t *state, const search_options_t *opts) {
+    if (!dump) return;
+    bool ok = fclose(dump) == 0;
+    if (!opts->dump) return;
+    if (ok) {
+        printf("%" PRIu64 " reduced nets saved to %s\n", state->nets_dumped, opts->dump);
     } else {
-        // Only report if significant progress was made (avoid console spam)
-        if (current_index - last_reported > 1000 || current_index == 0) {
-            struct timespec current_time;
-            clock_gettime(CLOCK_MONOTONIC, &current_time);
-            
-            // Calculate elapsed time in seconds with nanosecond precision
-            double elapsed = (current_time.tv_sec - start_time.tv_sec) + 
-                            (current_time.tv_nsec - start_time.tv_nsec) / 1000000000.0;
-            
-            // Ensure we don't divide by zero and have a meaningful rate
-            double rate = (elapsed > 0.001) ? current_index / elapsed : current_index * 1000.0;
-            
-            // Clear the line and update progress with rate information
-            printf("\rSearched through %zu indices... (%.1f indices/sec)", 
-                   current_index, rate);
-            fflush(stdout); // Ensure it displays immediately
-            
-            last_reported = current_index;
+        fprintf(stderr, "Failed to write net dump %s\n", opts->dump);
+    }
+}
+
+/**
+ * Open the --all file and hand it to the search; a resumed search appends
+ * to it, so indices past the last checkpoint may be listed twice
+ * @return The stream (NULL without --all); *failed is set if it could not
+ *         be opened
+ */
+static FILE *open_all_solutions(ic_enum_state_t *state, const search_options_t *opts,
+                                bool *failed) {
+    *failed = false;
+    if (!opts->all) return NULL;
+    
+    FILE *out = fopen(opts->all, opts->resume ? "a" : "w");
+    if (!out) {
+        fprintf(stderr, "Cannot create solution file %s\n", opts->all);
+        *failed = true;
+        return NULL;
+    }
+    ic_enum_set_all_solutions(state, out);
+    return out;
+}
+
+/**
+ * Close the --all file and say how many solutions went into it
+ */
+static void close_all_solutions(FILE *out, const ic_enum_state_t *state,
+                                const search_options_t *opts) {
+    if (!out) return;
+    if (fclose(out) == 0 && state->solutions_written > 0) {
+        printf("%" PRIu64 " solving indices written to %s\n", state->solutions_written, opts->all);
+    } else if (state->solutions_written == 0) {
+        printf("No solving indices in the range; %s is empty\n", opts->all);
+    } else {
+        fprintf(stderr, "Failed to write solution file %s\n", opts->all);
+    }
+}
+
+/**
+ * Start tracing into the --trace file, if any
+ * @return false if a trace was asked for but cannot be written
+ */
+static bool start_trace(const search_options_t *opts) {
+    if (!opts->trace) return true;
+    if (ic_trace_start(opts->trace) != 0) {
+        fprintf(stderr, "Cannot create trace %s\n", opts->trace);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Finish the --trace file and say how much went into it
+ */
+static void stop_trace(const search_options_t *opts) {
+    if (!opts->trace) return;
+    int64_t events = ic_trace_stop();
+    if (events >= 0) {
+        printf("\n%" PRId64 " trace events written to %s\n", events, opts->trace);
+    } else {
+        fprintf(stderr, "Failed to write trace %s\n", opts->trace);
+    }
+}
+
+/**
+ * Write the search's result record if --result was given
+ */
+static void write_result(const ic_enum_state_t *state, const search_options_t *opts,
+                         size_t max_nodes, size_t gas_limit,
+                         int *Ns, ic_batch_result_t *results, size_t count) {
+    if (!opts->result) return;
+    
+    ic_result_record_t record = {
+        .max_nodes = max_nodes,
+        .gas_limit = gas_limit,
+        .range_start = state->search_start,
+        .range_end = state->search_limit,
+        .count = count,
+        .Ns = Ns,
+        .results = results,
+    };
+    
+    if (ic_result_write(opts->result, &record) == 0) {
+        printf("Result record for indices %" PRIu64 "..%" PRIu64 " saved to %s\n",
+               record.range_start, record.range_end, opts->result);
+    } else {
+        fprintf(stderr, "Failed to write result record %s\n", opts->result);
+    }
+}
+
+/**
+ * Print the machine's topology and where the search threads will run
+ */
+static void report_topology(const search_options_t *opts) {
+#ifdef _OPENMP
+    int threads = (opts->threads > 0) ? opts->threads : omp_get_max_threads();
+#else
+    int threads = 1;
+#endif
+    // --numa alone scatters the threads, as the search does
+    ic_pin_mode_t pin = (opts->numa && opts->pin == IC_PIN_NONE) ? IC_PIN_SCATTER : opts->pin;
+    ic_topology_t topology;
+    ic_topology_detect(&topology);
+    ic_topology_print(&topology, pin, threads, opts->numa, stdout);
+}
+
+/**
+ * Warn when threads asked to be pinned could not be
+ */
+static void report_pinning(const ic_enum_state_t *state, const search_options_t *opts) {
+    if (opts->pin == IC_PIN_NONE && !opts->numa) return;
+    if (state->threads_pinned < state->threads_used) {
+        printf("\nWarning: pinned only %d of %d search threads\n",
+               state->threads_pinned, state->threads_used);
+    }
+}
+
+/**
+ * Say how a Levin search shared out its rewrites
+ */
+static void report_levin(const ic_levin_result_t *levin) {
+    printf("Levin search: %u phases, %" PRIu64 " rewrites over %" PRIu64 " candidates, "
+           "%" PRIu64 " suspended reductions resumed, at most %zu suspended at once\n",
+           levin->phases, levin->rewrites, levin->candidates, levin->resumptions,
+           levin->peak_suspended);
+    if (levin->solution_index >= 0) {
+        printf("Solution found in phase %u; its net stopped after %" PRIu64 " rewrites\n",
+               levin->phase, levin->solution_gas);
+    }
+}
+
+/**
+ * Tell the user where a resumed search started
+ */
+static void report_resume(const ic_enum_state_t *state, const search_options_t *opts) {
+    if (!opts->resume) return;
+    if (state->resumed_from > 0) {
+        printf("\nResumed from index %" PRIu64 " in %s\n", state->resumed_from, opts->checkpoint);
+    } else {
+        printf("\nNo usable checkpoint in %s, searched from index 0\n", opts->checkpoint);
+    }
+}
+
+/**
+ * Factor every number listed in a file with a single search pass
+ */
+static int run_batch(const char *path, size_t max_nodes, size_t gas_limit,
+                     const search_options_t *opts) {
+    int *Ns = NULL;
+    long count = read_batch_targets(path, &Ns);
+    if (count <= 0) {
+        if (count == 0) fprintf(stderr, "No numbers to factor in %s\n", path);
+        free(Ns);
+        return 1;
+    }
+    
+    ic_batch_result_t *results = (ic_batch_result_t*)malloc(count * sizeof(ic_batch_result_t));
+    if (!results) {
+        free(Ns);
+        return 1;
+    }
+    
+    printf("Searching for factorizations of %ld numbers with max_nodes=%zu and gas_limit=%zu\n",
+           count, max_nodes, gas_limit);
+    report_topology(opts);
+    
+    ic_enum_state_t state;
+    ic_enum_init(&state, max_nodes);
+    ic_enum_set_progress_callback(&state, progress_callback);
+    apply_search_options(&state, opts);
+    
+    bool dump_failed;
+    FILE *dump = open_dump(opts, false, &dump_failed);
+    if (dump_failed) {
+        free(results);
+        free(Ns);
+        return 1;
+    }
+    ic_enum_set_dump(&state, dump, opts->dump_pairs);
+    FILE *all = open_all_solutions(&state, opts, &dump_failed);
+    if (dump_failed || !start_trace(opts)) {
+        if (all) fclose(all);
+        if (dump) fclose(dump);
+        free(results);
+        free(Ns);
+        return 1;
+    }
+    
+    struct timespec start_time, end_time;
+    clock_gettime(CLOCK_MONOTONIC, &start_time);
+    
+    int64_t solved = ic_search_factor_batch(&state, Ns, count, max_nodes, gas_limit, results);
+    
+    clock_gettime(CLOCK_MONOTONIC, &end_time);
+    double elapsed = (end_time.tv_sec - start_time.tv_sec) + 
+                    (end_time.tv_nsec - start_time.tv_nsec) / 1000000000.0;
+    stop_trace(opts);
+    
+    if (solved < 0) {
+        fprintf(stderr, "\nSearch failed: out of memory (max_nodes=%zu may be too large)\n", max_nodes);
+        if (all) fclose(all);
+        if (dump) fclose(dump);
+        free(results);
+        free(Ns);
+        return 1;
+    }
+    
+    report_resume(&state, opts);
+    report_pinning(&state, opts);
+    printf("\n");
+    for (long i = 0; i < count; i++) {
+        if (results[i].solution_index >= 0) {
+            printf("%d: index %" PRId64 " (%d * %d)\n", Ns[i], results[i].solution_index,
+                   results[i].factor_a, results[i].factor_b);
+        } else {
+            printf("%d: not found\n", Ns[i]);
         }
     }
+    
+    printf("\nFactored %" PRId64 " of %ld numbers in %.2f seconds (examined %zu indices)\n",
+           solved, count, elapsed, state.indices_searched);
+    write_result(&state, opts, max_nodes, gas_limit, Ns, results, (size_t)count);
+    close_dump(dump, &state, opts);
+    close_all_solutions(all, &state, opts);
+    
+#ifdef IC_STATS
+    printf("\n");
+    ic_stats_print(&state.stats, stdout);
+#endif
+    
+    free(results);
+    free(Ns);
+    return (solved == count) ? 0 : 1;
+}
+
+/**
+ * Reduce a range of indices once and store their outcomes in a table file
+ */
+static int run_precompute(const char *path, size_t count, size_t max_nodes, size_t gas_limit) {
+    printf("Precomputing outcomes of %zu indices with max_nodes=%zu and gas_limit=%zu\n",
+           count, max_nodes, gas_limit);
+    
+    struct timespec start_time, end_time;
+    clock_gettime(CLOCK_MONOTONIC, &start_time);
+    
+    if (ic_table_precompute(path, count, max_nodes, gas_limit) != 0) {
+        fprintf(stderr, "Failed to write outcome table %s\n", path);
+        return 1;
+    }
+    
+    clock_gettime(CLOCK_MONOTONIC, &end_time);
+    double elapsed = (end_time.tv_sec - start_time.tv_sec) + 
+                    (end_time.tv_nsec - start_time.tv_nsec) / 1000000000.0;
+    
+    printf("Wrote %s in %.2f seconds\n", path, elapsed);
+    return 0;
+}
+
+/**
+ * Answer factor queries from a precomputed table without reducing any net
+ */
+static int run_table(const char *path, int count, char **numbers) {
+    ic_table_t table;
+    if (ic_table_open(&table, path) != 0) {
+        fprintf(stderr, "Cannot open outcome table %s\n", path);
+        return 1;
+    }
+    
+    printf("Table %s: %zu indices, max_nodes=%u, gas_limit=%u\n", path, table.count,
+           (unsigned)table.header->max_nodes, (unsigned)table.header->gas_limit);
+    
+    int solved = 0;
+    for (int i = 0; i < count; i++) {
+        int N = atoi(numbers[i]);
+        int factor_a = 0, factor_b = 0;
+        int64_t index = ic_table_find_factor(&table, N, &factor_a, &factor_b);
+        
+        if (index >= 0) {
+            printf("%d: index %" PRId64 " (%d * %d)\n", N, index, factor_a, factor_b);
+            solved++;
+        } else {
+            printf("%d: not found\n", N);
+        }
+    }
+    
+    ic_table_close(&table);
+    return (solved == count) ? 0 : 1;
+}
+
+/**
+ * List the nets of a dump without copying them out of the file
+ */
+static int run_inspect(const char *path) {
+    ic_netfile_t file;
+    if (ic_netfile_open(&file, path) != 0) {
+        fprintf(stderr, "Cannot open net file %s\n", path);
+        return 1;
+    }
+    
+    printf("Net file %s: %zu nets\n", path, file.count);
+    
+    size_t offset = 0;
+    ic_net_t view;
+    const ic_netfile_header_t *header;
+    while (ic_netfile_next(&file, &offset, &view, &header)) {
+        size_t live = 0;
+        for (size_t i = 0; i < view.used_nodes; i++) {
+            live += view.active[i];
+        }
+        
+        if (header->index == IC_NETFILE_NO_INDEX) {
+            printf("-: ");
+        } else {
+            printf("%" PRIu64 ": ", header->index);
+        }
+        printf("%zu live of %zu slots, gas %zu, status %d", live, view.used_nodes,
+               view.gas_used, (int)header->status);
+        if (view.factor_found) {
+            printf(", factors %d * %d = %d", view.factor_a, view.factor_b,
+                   view.factor_a * view.factor_b);
+        }
+        printf("\n");
+    }
+    
+    ic_netfile_close(&file);
+    return 0;
+}
+
+/**
+ * Convert a binary trace to a Chrome trace JSON file ("-" or none for stdout)
+ */
+static int run_trace_export(const char *path, const char *json_path) {
+    FILE *in = fopen(path, "rb");
+    if (!in) {
+        fprintf(stderr, "Cannot open trace %s\n", path);
+        return 1;
+    }
+    bool to_stdout = !json_path || strcmp(json_path, "-") == 0;
+    FILE *out = to_stdout ? stdout : fopen(json_path, "w");
+    if (!out) {
+        fprintf(stderr, "Cannot create %s\n", json_path);
+        fclose(in);
+        return 1;
+    }
+    
+    int64_t events = ic_trace_export_chrome(in, out);
+    fclose(in);
+    bool ok = (to_stdout ? fflush(out) : fclose(out)) == 0 && events >= 0;
+    if (!ok) {
+        fprintf(stderr, "Failed to convert trace %s\n", path);
+        return 1;
+    }
+    if (!to_stdout) {
+        printf("Converted %" PRId64 " events to %s\n", events, json_path);
+    }
+    return 0;
+}
+
+/**
+ * Serve factor requests on a socket until a client asks for shutdown
+ */
+static int run_serve(const char *address, size_t cache_entries, const search_options_t *opts) {
+    if (opts->checkpoint || opts->dump || opts->all || opts->result || opts->levin ||
+        opts->trace) {
+        fprintf(stderr, "--serve cannot be combined with --checkpoint, --resume, --dump, --all, "
+                "--result, --levin or --trace\n");
+        return 1;
+    }
+    
+    ic_enum_state_t base;
+    ic_enum_init(&base, IC_SERVICE_MAX_NODES_DEFAULT);
+    apply_search_options(&base, opts);
+    ic_service_t service;
+    if (ic_service_init(&service, &base, cache_entries) != 0) {
+        fprintf(stderr, "Cannot create a result cache of %zu entries\n", cache_entries);
+        return 1;
+    }
+    int fd = ic_service_listen(address);
+    if (fd < 0) {
+        fprintf(stderr, "Cannot listen on %s (use unix:<path>, tcp:<port> or tcp:<host>:<port>)\n",
+                address);
+        ic_service_destroy(&service);
+        return 1;
+    }
+    
+    report_topology(opts);
+    printf("Serving on %s, caching up to %zu results\n", address, cache_entries);
+    fflush(stdout);
+    int status = ic_service_run(&service, fd);
+    close(fd);
+    if (strncmp(address, "unix:", 5) == 0) unlink(address + 5);
+    
+    printf("Served %" PRIu64 " requests with %" PRIu64 " searches (%.2f s); "
+           "%" PRIu64 " cache hits, %" PRIu64 " evictions\n",
+           service.requests, service.searches, service.search_seconds,
+           service.cache.hits, service.cache.evictions);
+    ic_service_destroy(&service);
+    return (status == 0) ? 0 : 1;
+}
+
+/**
+ * Combine shard result records into the answer of a single-node search
+ */
+static int run_merge(int count, char **paths) {
+    ic_result_record_t *records = (ic_result_record_t*)calloc(count, sizeof(ic_result_record_t));
+    if (!records) return 1;
+    
+    int loaded = 0;
+    for (; loaded < count; loaded++) {
+        if (ic_result_read(paths[loaded], &records[loaded]) != 0) {
+            fprintf(stderr, "Cannot read result record %s\n", paths[loaded]);
+            break;
+        }
+    }
+    
+    ic_result_record_t merged;
+    int status = 1;
+    if (loaded == count && ic_result_merge(records, count, &merged) == 0) {
+        printf("Merged %d records: indices 0..%" PRIu64 " covered without gaps\n",
+               count, merged.range_end);
+        
+        size_t definite = 0;
+        for (size_t i = 0; i < merged.count; i++) {
+            const ic_batch_result_t *r = &merged.results[i];
+            if (r->solution_index < 0) {
+                printf("%d: not found\n", merged.Ns[i]);
+            } else if ((uint64_t)r->solution_index < merged.range_end) {
+                printf("%d: index %" PRId64 " (%d * %d)\n", merged.Ns[i], r->solution_index,
+                       r->factor_a, r->factor_b);
+                definite++;
+            } else {
+                printf("%d: index %" PRId64 " (%d * %d), past a gap in the shards, may not be smallest\n",
+                       merged.Ns[i], r->solution_index, r->factor_a, r->factor_b);
+            }
+        }
+        
+        status = (definite == merged.count) ? 0 : 1;
+        ic_result_free(&merged);
+    } else if (loaded == count) {
+        fprintf(stderr, "Result records come from different searches\n");
+    }
+    
+    for (int i = 0; i < loaded; i++) {
+        ic_result_free(&records[i]);
+    }
+    free(records);
+    return status;
 }
 
 int main(int argc, char **argv) {
+    search_options_t opts;
+    if (parse_search_options(&argc, argv, &opts) != 0) {
+        return 1;
+    }
+#ifndef IC_TRACE
+    if (opts.trace) {
+        fprintf(stderr, "--trace needs a build with tracing (make TRACE=1)\n");
+        return 1;
+    }
+#endif
+    
     if (argc < 2) {
         fprintf(stderr, "Usage: %s <number_to_factor> [max_nodes] [gas_limit]\n", argv[0]);
+        fprintf(stderr, "       %s --batch <file|-> [max_nodes] [gas_limit]\n", argv[0]);
+        fprintf(stderr, "       %s --precompute <file> [count] [max_nodes] [gas_limit]\n", argv[0]);
+        fprintf(stderr, "       %s --table <file> <number_to_factor>...\n", argv[0]);
+        fprintf(stderr, "       %s --merge <result_file>...\n", argv[0]);
+        fprintf(stderr, "       %s --inspect <net_file>\n", argv[0]);
+        fprintf(stderr, "       %s --trace-json <trace_file> [json_file]\n", argv[0]);
+        fprintf(stderr, "       %s --serve <unix:path|tcp:[host:]port> [cache_entries]\n", argv[0]);
+        fprintf(stderr, "Search options: --limit <indices> --range <start:end> --shard <k/n>\n");
+        fprintf(stderr, "                --checkpoint <file> --resume <file> --result <file>\n");
+        fprintf(stderr, "                --loop-check <interval> --reuse\n");
+        fprintf(stderr, "                --threads <count> --pin <compact|scatter> --numa\n");
+        fprintf(stderr, "                --dump <file> --dump-pairs --all <file> --levin\n");
+        fprintf(stderr, "                --trace <file>\n");
         return 1;
     }
     
+    // Batch mode: many numbers, one enumeration pass
+    if (strcmp(argv[1], "--batch") == 0) {
+        if (opts.levin) {
+            fprintf(stderr, "--levin factors a single number\n");
+            return 1;
+        }
+        if (argc < 3) {
+            fprintf(stderr, "--batch needs a file of numbers (or - for stdin)\n");
+            return 1;
+        }
+        size_t max_nodes = (argc > 3) ? atoi(argv[3]) : 100;
+        size_t gas_limit = (argc > 4) ? atoi(argv[4]) : 100000;
+        return run_batch(argv[2], max_nodes, gas_limit, &opts);
+    }
+    
+    // Precompute mode: store every index's outcome for later lookups
+    if (strcmp(argv[1], "--precompute") == 0) {
+        if (argc < 3) {
+            fprintf(stderr, "--precompute needs an output file\n");
+            return 1;
+        }
+        size_t count = (argc > 3) ? strtoull(argv[3], NULL, 10) : 1000000;
+        size_t max_nodes = (argc > 4) ? atoi(argv[4]) : 100;
+        size_t gas_limit = (argc > 5) ? atoi(argv[5]) : 100000;
+        return run_precompute(argv[2], count, max_nodes, gas_limit);
+    }
+    
+    // Table mode: answer queries from a precomputed file
+    if (strcmp(argv[1], "--table") == 0) {
+        if (argc < 4) {
+            fprintf(stderr, "--table needs a table file and at least one number\n");
+            return 1;
+        }
+        return run_table(argv[2], argc - 3, argv + 3);
+    }
+    
+    // Merge mode: combine the result records of sharded runs
+    if (strcmp(argv[1], "--merge") == 0) {
+        if (argc < 3) {
+            fprintf(stderr, "--merge needs at least one result record\n");
+            return 1;
+        }
+        return run_merge(argc - 2, argv + 2);
+    }
+    
+    // Inspect mode: list the nets of a dump
+    if (strcmp(argv[1], "--inspect") == 0) {
+        if (argc < 3) {
+            fprintf(stderr, "--inspect needs a net file\n");
+            return 1;
+        }
+        return run_inspect(argv[2]);
+    }
+    
+    // Trace mode: convert a binary trace for chrome://tracing or Perfetto
+    if (strcmp(argv[1], "--trace-json") == 0) {
+        if (argc < 3) {
+            fprintf(stderr, "--trace-json needs a trace file\n");
+            return 1;
+        }
+        return run_trace_export(argv[2], (argc > 3) ? argv[3] : NULL);
+    }
+    
+    // Service mode: answer factor requests on a socket from warm nets
+    if (strcmp(argv[1], "--serve") == 0) {
+        if (argc < 3) {
+            fprintf(stderr, "--serve needs an address (unix:<path> or tcp:[host:]<port>)\n");
+            return 1;
+        }
+        size_t cache_entries = (argc > 3) ? strtoull(argv[3], NULL, 10) : IC_SERVICE_CACHE_DEFAULT;
+        return run_serve(argv[2], cache_entries, &opts);
+    }
+    
     // Parse arguments
     int N = atoi(argv[1]);
     size_t max_nodes = (argc > 2) ? atoi(argv[2]) : 100;
@@ -58,38 +817,96 @@ int main(int argc, char **argv) {
         fprintf(stderr, "The number to factor must be greater than 1\n");
         return 1;
     }
+    if (opts.levin && (opts.all || opts.checkpoint || opts.dump)) {
+        fprintf(stderr, "--levin cannot be combined with --all, --checkpoint, --resume or --dump\n");
+        return 1;
+    }
     
     printf("Searching for a factorization of %d with max_nodes=%zu and gas_limit=%zu\n",
            N, max_nodes, gas_limit);
     
+    // Factors are slot positions + 1, so they are bounded by the net size
+    if (ic_search_min_net_size(N, max_nodes, opts.reuse) == 0) {
+        size_t largest = (opts.reuse && max_nodes > IC_ENUM_MAX_SLOTS) ? IC_ENUM_MAX_SLOTS : max_nodes;
+        printf("\nNo enumerated net can factor %d: it has no divisor pair a * b with a != b "
+               "and both at most %zu\n", N, largest);
+        return 1;
+    }
+    
+    report_topology(&opts);
+    
     // Initialize the enumeration state
     ic_enum_state_t state;
     ic_enum_init(&state, max_nodes);
     ic_enum_set_progress_callback(&state, progress_callback);
+    apply_search_options(&state, &opts);
+    
+    // The search streams the solving net out, so it is not reduced again
+    bool dump_failed;
+    FILE *dump = open_dump(&opts, true, &dump_failed);
+    if (dump_failed) return 1;
+    ic_enum_set_dump(&state, dump, opts.dump_pairs);
+    FILE *all = open_all_solutions(&state, &opts, &dump_failed);
+    if (dump_failed || !start_trace(&opts)) {
+        if (all) fclose(all);
+        if (dump) fclose(dump);
+        return 1;
+    }
     
     // Start timing using monotonic clock for wall-clock time
     struct timespec start_time, end_time;
     clock_gettime(CLOCK_MONOTONIC, &start_time);
     
     // Run the search
-    int solution_index = ic_search_factor(&state, N, max_nodes, gas_limit);
+    ic_batch_result_t result;
+    ic_levin_result_t levin;
+    if (opts.levin) {
+        result.solution_index = ic_search_levin(&state, N, max_nodes, gas_limit, &levin);
+        result.factor_a = levin.factor_a;
+        result.factor_b = levin.factor_b;
+    } else if (ic_search_factor_batch(&state, &N, 1, max_nodes, gas_limit, &result) < 0) {
+        result.solution_index = IC_SEARCH_ERROR;
+    }
+    int64_t solution_index = result.solution_index;
     
     // End timing
     clock_gettime(CLOCK_MONOTONIC, &end_time);
     double elapsed = (end_time.tv_sec - start_time.tv_sec) + 
                     (end_time.tv_nsec - start_time.tv_nsec) / 1000000000.0;
+    stop_trace(&opts);
+    
+    if (solution_index == IC_SEARCH_ERROR) {
+        fprintf(stderr, "\nSearch failed: out of memory (max_nodes=%zu may be too large)\n", max_nodes);
+        if (all) fclose(all);
+        if (dump) fclose(dump);
+        return 1;
+    }
+    
+    report_resume(&state, &opts);
+    report_pinning(&state, &opts);
+    write_result(&state, &opts, max_nodes, gas_limit, &N, &result, 1);
     
     if (solution_index >= 0) {
-        printf("\nSuccess! Found a factorization for %d at index %d\n", N, solution_index);
+        printf("\nSuccess! Found a factorization for %d at index %" PRId64 "\n", N, solution_index);
         
-        // Reconstruct the solution net for demonstration
+        // Load the solving net the search dumped; rebuild and reduce it
+        // only if there was no stream to dump it to
         ic_net_t *solution_net = ic_net_create(max_nodes, gas_limit);
+        if (!solution_net) {
+            fprintf(stderr, "\nSearch failed: out of memory (max_nodes=%zu may be too large)\n", max_nodes);
+            if (all) fclose(all);
+            if (dump) fclose(dump);
+            return 1;
+        }
+        ic_net_set_slot_reuse(solution_net, opts.reuse);
+        bool loaded = read_dumped_net(dump, (uint64_t)solution_index, solution_net);
         solution_net->input_number = N;
-        
-        if (ic_enum_build_net(&state, solution_index, solution_net) == 0) {
-            // Reduce it again to find the factors
+        if (!loaded && ic_enum_build_net(&state, solution_index, solution_net) == 0) {
             ic_net_reduce(solution_net);
-            
+            loaded = true;
+        }
+        
+        if (loaded) {
             // Print the factors
             if (ic_net_has_valid_factor(solution_net, N)) {
                 printf("Factors: %d * %d = %d\n", 
@@ -111,31 +928,44 @@ int main(int argc, char **argv) {
         
         ic_net_free(solution_net);
     } else {
-        // More informative message about why factorization failed
+        // Numbers no net can factor were turned away before the search, so
+        // an unsolved search always ran to the end of its range
         printf("\nFailed to find a factorization for %d\n", N);
-        
-        if (state.current_index >= 1000000) {
-            printf("Reached search limit (examined %zu indices)\n", state.current_index);
-            printf("Consider increasing the search space or using a larger max_nodes value\n");
-        } else {
-            printf("Exhausted search space after examining %zu indices\n", state.current_index);
-            
-            // If the number is prime, mention that
-            bool is_probably_prime = true;
-            for (int i = 2; i <= sqrt(N); i++) {
-                if (N % i == 0) {
-                    is_probably_prime = false;
-                    break;
-                }
-            }
-            
-            if (is_probably_prime && N > 3) {
-                printf("Note: %d appears to be prime, so it cannot be factored into integers > 1\n", N);
-            }
-        }
+        printf("Reached search limit (examined %" PRIu64 " indices)\n",
+               (uint64_t)(state.current_index - state.search_start));
+        printf("Consider increasing the search space or using a larger max_nodes value\n");
     }
     
     printf("\nSearch completed in %.2f seconds\n", elapsed);
+    if (opts.levin) {
+        report_levin(&levin);
+    }
+    close_dump(dump, &state, &opts);
+    close_all_solutions(all, &state, &opts);
+    
+    // Report how much of the index space was actually distinct
+    if (state.dedup && state.distinct_nets > 0 && state.indices_searched > 0) {
+        printf("Distinct nets: %zu, %zu of %zu indices skipped as duplicates (%.1f%%)\n",
+               state.distinct_nets, state.indices_deduplicated, state.indices_searched,
+               100.0 * state.indices_deduplicated / state.indices_searched);
+    }
+    if (state.loops_detected > 0) {
+        printf("Looping nets: %" PRIu64 " skipped to the gas limit after their loop repeated\n",
+               state.loops_detected);
+    }
+    if (state.indices_pruned > 0) {
+        printf("Small nets: %" PRIu64 " indices not built, too small to hold a factor pair of %d\n",
+               state.indices_pruned, N);
+    }
+    if (state.nets_abandoned > 0) {
+        printf("Hopeless nets: %" PRIu64 " abandoned, no factor pair could survive their reduction\n",
+               state.nets_abandoned);
+    }
+    
+#ifdef IC_STATS
+    printf("\n");
+    ic_stats_print(&state.stats, stdout);
+#endif
     
     return (solution_index >= 0) ? 0 : 1;
 }
\ No newline at end of file
@@ -1,9 +1,29 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdbool.h>
+#include <inttypes.h>
 #include <string.h>
+#include <sched.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
 #include "ic_runtime.h"
 #include "ic_search.h"
+#include "ic_table.h"
+#include "ic_result.h"
+#include "ic_fixed.h"
+#include "ic_parallel.h"
+#include "ic_topology.h"
+#include "ic_netfile.h"
+#include "ic_solutions.h"
+#include "ic_levin.h"
+#include "ic_service.h"
+#include "ic_trace.h"
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 #define TEST_FAIL(msg) { printf("FAIL: %s (line %d)\n", msg, __LINE__); return false; }
 #define TEST_PASS() { printf("PASS\n"); return true; }
@@ -40,6 +60,13 @@ bool test_node_allocation() {
     }
     
     ic_net_free(net);
+    
+    // Sizes whose storage could not be addressed or would overflow
+    if (ic_net_create((size_t)1 << 63, 10) || ic_net_create(IC_NET_MAX_NODES + 1, 10) ||
+        ic_net_create(SIZE_MAX, 10)) {
+        TEST_FAIL("Created a net too large to address");
+    }
+    
     TEST_PASS();
 }
 
@@ -63,10 +90,10 @@ bool test_connections() {
     ic_net_connect(net, node1, 0, node2, 0);
     
     // Verify connection
-    if (net->nodes[node1].ports[0].connected_node != node2 ||
-        net->nodes[node1].ports[0].connected_port != 0 ||
-        net->nodes[node2].ports[0].connected_node != node1 ||
-        net->nodes[node2].ports[0].connected_port != 0) {
+    if (ic_net_port_node(net, node1, 0) != node2 ||
+        ic_net_port_port(net, node1, 0) != 0 ||
+        ic_net_port_node(net, node2, 0) != node1 ||
+        ic_net_port_port(net, node2, 0) != 0) {
         ic_net_free(net);
         TEST_FAIL("Connection failed");
     }
@@ -81,17 +108,17 @@ bool test_connections() {
     ic_net_connect(net, node1, 0, node3, 1);
     
     // Verify new connection
-    if (net->nodes[node1].ports[0].connected_node != node3 ||
-        net->nodes[node1].ports[0].connected_port != 1 ||
-        net->nodes[node3].ports[1].connected_node != node1 ||
-        net->nodes[node3].ports[1].connected_port != 0) {
+    if (ic_net_port_node(net, node1, 0) != node3 ||
+        ic_net_port_port(net, node1, 0) != 1 ||
+        ic_net_port_node(net, node3, 1) != node1 ||
+        ic_net_port_port(net, node3, 1) != 0) {
         ic_net_free(net);
         TEST_FAIL("Reconnection failed");
     }
     
     // Verify old connection was broken
-    if (net->nodes[node2].ports[0].connected_node != -1 ||
-        net->nodes[node2].ports[0].connected_port != -1) {
+    if (ic_net_port_node(net, node2, 0) != -1 ||
+        ic_net_port_port(net, node2, 0) != -1) {
         ic_net_free(net);
         TEST_FAIL("Old connection not broken");
     }
@@ -136,7 +163,7 @@ bool test_delta_delta_reduction() {
     }
     
     // Check that delta nodes are inactive
-    if (net->nodes[delta1].is_active || net->nodes[delta2].is_active) {
+    if (ic_net_node_active(net, delta1) || ic_net_node_active(net, delta2)) {
         ic_net_free(net);
         TEST_FAIL("Delta nodes should be inactive after reduction");
     }
@@ -184,7 +211,7 @@ bool test_gamma_gamma_reduction() {
     }
     
     // Check that gamma nodes are inactive
-    if (net->nodes[gamma1].is_active || net->nodes[gamma2].is_active) {
+    if (ic_net_node_active(net, gamma1) || ic_net_node_active(net, gamma2)) {
         ic_net_free(net);
         TEST_FAIL("Gamma nodes should be inactive after reduction");
     }
@@ -200,8 +227,8 @@ bool test_gamma_gamma_reduction() {
     for (int p1 = 0; p1 < 3; p1++) {
         for (int p2 = 0; p2 < 3; p2++) {
             if (p1 != p2 && // Not the same port
-                net->nodes[aux1].ports[p1].connected_node == (int)aux1 &&
-                net->nodes[aux1].ports[p1].connected_port == p2) {
+                ic_net_port_node(net, aux1, p1) == (int)aux1 &&
+                ic_net_port_port(net, aux1, p1) == p2) {
                 conn1_found = true;
                 break;
             }
@@ -213,8 +240,8 @@ bool test_gamma_gamma_reduction() {
     for (int p1 = 0; p1 < 3; p1++) {
         for (int p2 = 0; p2 < 3; p2++) {
             if (p1 != p2 && // Not the same port
-                net->nodes[aux2].ports[p1].connected_node == (int)aux2 &&
-                net->nodes[aux2].ports[p1].connected_port == p2) {
+                ic_net_port_node(net, aux2, p1) == (int)aux2 &&
+                ic_net_port_port(net, aux2, p1) == p2) {
                 conn2_found = true;
                 break;
             }
@@ -226,11 +253,11 @@ bool test_gamma_gamma_reduction() {
         // Debug output of all connections
         for (int p = 0; p < 3; p++) {
             printf("Aux1 port %d -> node %d port %d\n", 
-                  p, net->nodes[aux1].ports[p].connected_node,
-                  net->nodes[aux1].ports[p].connected_port);
+                  p, ic_net_port_node(net, aux1, p),
+                  ic_net_port_port(net, aux1, p));
             printf("Aux2 port %d -> node %d port %d\n", 
-                  p, net->nodes[aux2].ports[p].connected_node,
-                  net->nodes[aux2].ports[p].connected_port);
+                  p, ic_net_port_node(net, aux2, p),
+                  ic_net_port_port(net, aux2, p));
         }
         ic_net_free(net);
         TEST_FAIL("Auxiliary ports not connected correctly after reduction");
@@ -264,23 +291,146 @@ bool test_delta_gamma_reduction() {
     // Connect the principal ports to form an active pair
     ic_net_connect(net, delta, 0, gamma, 0);
     
-    // Perform reduction
-    int result = ic_net_reduce(net);
-    
-    // Check result - note that we might hit the gas limit, but the original nodes should still be inactive
+    // Perform a single rewrite step
+    net->gas_limit = 1;
+    ic_net_reduce(net);
     
     // Check that original nodes are inactive
-    if (net->nodes[delta].is_active || net->nodes[gamma].is_active) {
+    if (ic_net_node_active(net, delta) || ic_net_node_active(net, gamma)) {
         ic_net_free(net);
         TEST_FAIL("Original nodes should be inactive after reduction");
     }
     
-    // Simplified test - just check that the reduction ran and the original nodes are inactive
+    // The rule recreates an active pair forever, so the full run hits the gas limit
+    net->gas_limit = 100;
+    int result = ic_net_reduce(net);
+    if (result != 1 || net->gas_used != net->gas_limit) {
+        ic_net_free(net);
+        TEST_FAIL("Every rewrite should have made progress until the gas limit");
+    }
+    
+    // Without slot reuse every rewrite takes fresh slots until none are left
+    if (ic_net_get_used_nodes(net) != 10 || net->free_head != -1) {
+        ic_net_free(net);
+        TEST_FAIL("Erased node slots should not be reused by default");
+    }
+    
+    // With it the net never needs more than two spare slots
+    ic_net_reset(net);
+    ic_net_set_slot_reuse(net, true);
+    delta = ic_net_new_node(net, IC_NODE_DELTA);
+    gamma = ic_net_new_node(net, IC_NODE_GAMMA);
+    ic_net_connect(net, delta, 1, gamma, 1);
+    ic_net_connect(net, delta, 2, gamma, 2);
+    ic_net_connect(net, delta, 0, gamma, 0);
+    result = ic_net_reduce(net);
+    if (result != 1 || net->gas_used != net->gas_limit) {
+        ic_net_free(net);
+        TEST_FAIL("Every rewrite should have made progress until the gas limit");
+    }
+    if (ic_net_get_used_nodes(net) > 4) {
+        printf("Used nodes: %zu\n", ic_net_get_used_nodes(net));
+        ic_net_free(net);
+        TEST_FAIL("Erased node slots should be reused");
+    }
     
     ic_net_free(net);
     TEST_PASS();
 }
 
+// Test that redexes created by a rewrite are picked up without a rescan
+bool test_created_redex_reduction() {
+    printf("Testing redexes created by rewrites...\n");
+    
+    ic_net_t *net = ic_net_create(10, 100);
+    if (!net) TEST_FAIL("Failed to create net");
+    
+    int delta1 = ic_net_new_node(net, IC_NODE_DELTA);
+    int delta2 = ic_net_new_node(net, IC_NODE_DELTA);
+    int gamma1 = ic_net_new_node(net, IC_NODE_GAMMA);
+    int gamma2 = ic_net_new_node(net, IC_NODE_GAMMA);
+    
+    // The delta pair annihilates and its crosswise rewiring joins the
+    // principal ports of the two gammas into a new active pair
+    ic_net_connect(net, delta1, 0, delta2, 0);
+    ic_net_connect(net, delta1, 1, gamma1, 0);
+    ic_net_connect(net, delta2, 2, gamma2, 0);
+    ic_net_connect(net, gamma1, 1, gamma2, 1);
+    ic_net_connect(net, gamma1, 2, gamma2, 2);
+    
+    int result = ic_net_reduce(net);
+    if (result != 0) {
+        ic_net_free(net);
+        TEST_FAIL("Reduction failed");
+    }
+    
+    if (net->gas_used != 2) {
+        printf("Gas used: %zu\n", net->gas_used);
+        ic_net_free(net);
+        TEST_FAIL("Both the original and the created redex should be rewritten");
+    }
+    
+    if (ic_net_node_active(net, gamma1) || ic_net_node_active(net, gamma2)) {
+        ic_net_free(net);
+        TEST_FAIL("Gamma nodes should be inactive after reduction");
+    }
+    
+    ic_net_free(net);
+    TEST_PASS();
+}
+
+// Test that the redex queue grows instead of dropping redexes, in both orders
+bool test_redex_queue_growth() {
+    printf("Testing redex queue growth and order...\n");
+    
+    const int pairs = 300; // Well beyond the initial queue capacity
+    ic_redex_order_t orders[2] = { IC_REDEX_FIFO, IC_REDEX_LIFO };
+    
+    for (int o = 0; o < 2; o++) {
+        ic_net_t *net = ic_net_create(2 * pairs, 1000);
+        if (!net) TEST_FAIL("Failed to create net");
+        ic_net_set_redex_order(net, orders[o]);
+        
+        for (int i = 0; i < pairs; i++) {
+            int delta1 = ic_net_new_node(net, IC_NODE_DELTA);
+            int delta2 = ic_net_new_node(net, IC_NODE_DELTA);
+            ic_net_connect(net, delta1, 0, delta2, 0);
+        }
+        
+        if (ic_net_reduce(net) != 0 || net->gas_used != (size_t)pairs) {
+            printf("Gas used: %zu\n", net->gas_used);
+            ic_net_free(net);
+            TEST_FAIL("Every independent pair should be rewritten exactly once");
+        }
+        
+        if (net->redex_rescan_needed || net->redex_queue_capacity < (size_t)pairs) {
+            ic_net_free(net);
+            TEST_FAIL("Redex queue should have grown to hold every pair");
+        }
+        
+        // With one step of gas, FIFO rewrites the first pair and LIFO the last
+        ic_net_reset(net);
+        for (int i = 0; i < 2; i++) {
+            int delta1 = ic_net_new_node(net, IC_NODE_DELTA);
+            int delta2 = ic_net_new_node(net, IC_NODE_DELTA);
+            ic_net_connect(net, delta1, 0, delta2, 0);
+        }
+        net->gas_limit = 1;
+        ic_net_reduce(net);
+        
+        int erased = (orders[o] == IC_REDEX_FIFO) ? 0 : 2;
+        int kept = (orders[o] == IC_REDEX_FIFO) ? 2 : 0;
+        if (ic_net_node_active(net, erased) || !ic_net_node_active(net, kept)) {
+            ic_net_free(net);
+            TEST_FAIL("Redexes were not rewritten in the requested order");
+        }
+        
+        ic_net_free(net);
+    }
+    
+    TEST_PASS();
+}
+
 // Test epsilon reduction
 bool test_epsilon_reduction() {
     printf("Testing epsilon reduction...\n");
@@ -314,22 +464,22 @@ bool test_epsilon_reduction() {
     }
     
     // Check that epsilon is inactive
-    if (net->nodes[epsilon].is_active) {
+    if (ic_net_node_active(net, epsilon)) {
         ic_net_free(net);
         TEST_FAIL("Epsilon node should be inactive after reduction");
     }
     
     // Delta should still be active, and its aux port should remain connected
-    if (!net->nodes[delta].is_active) {
+    if (!ic_net_node_active(net, delta)) {
         ic_net_free(net);
         TEST_FAIL("Delta node should still be active");
     }
     
-    if (net->nodes[delta].ports[1].connected_node != aux ||
-        net->nodes[delta].ports[1].connected_port != 0) {
+    if (ic_net_port_node(net, delta, 1) != aux ||
+        ic_net_port_port(net, delta, 1) != 0) {
         printf("Delta port 1 -> node %d port %d\n", 
-               net->nodes[delta].ports[1].connected_node,
-               net->nodes[delta].ports[1].connected_port);
+               ic_net_port_node(net, delta, 1),
+               ic_net_port_port(net, delta, 1));
         ic_net_free(net);
         TEST_FAIL("Delta aux port connection changed unexpectedly");
     }
@@ -457,8 +607,8 @@ bool test_enumeration() {
             // Successfully built a net, check that it's valid
             for (size_t n = 0; n < net->used_nodes; n++) {
                 for (int p = 0; p < 3; p++) {
-                    int conn_node = net->nodes[n].ports[p].connected_node;
-                    int conn_port = net->nodes[n].ports[p].connected_port;
+                    int conn_node = ic_net_port_node(net, n, p);
+                    int conn_port = ic_net_port_port(net, n, p);
                     
                     if (conn_node != -1) {
                         if (conn_node < 0 || conn_node >= (int)net->used_nodes ||
@@ -470,13 +620,13 @@ bool test_enumeration() {
                         }
                         
                         // Verify bidirectional connection
-                        if (net->nodes[conn_node].ports[conn_port].connected_node != (int)n ||
-                            net->nodes[conn_node].ports[conn_port].connected_port != p) {
+                        if (ic_net_port_node(net, conn_node, conn_port) != (int)n ||
+                            ic_net_port_port(net, conn_node, conn_port) != p) {
                             printf("Non-bidirectional connection: %zu.%d -> %d.%d but %d.%d -> %d.%d\n",
                                    n, p, conn_node, conn_port,
                                    conn_node, conn_port,
-                                   net->nodes[conn_node].ports[conn_port].connected_node,
-                                   net->nodes[conn_node].ports[conn_port].connected_port);
+                                   ic_net_port_node(net, conn_node, conn_port),
+                                   ic_net_port_port(net, conn_node, conn_port));
                             ic_net_free(net);
                             TEST_FAIL("Non-bidirectional connection in enumerated net");
                         }
@@ -503,6 +653,1948 @@ bool test_enumeration() {
     TEST_PASS();
 }
 
+// Nets with the same slots, wiring, free list and queued redexes
+static bool nets_identical(const ic_net_t *a, const ic_net_t *b) {
+    if (a->used_nodes != b->used_nodes || a->free_head != b->free_head ||
+        a->redex_queue_size != b->redex_queue_size ||
+        a->redex_rescan_needed != b->redex_rescan_needed) {
+        return false;
+    }
+    for (size_t i = 0; i < a->used_nodes; i++) {
+        if (a->types[i] != b->types[i] || a->active[i] != b->active[i]) return false;
+        for (int p = 0; p < 3; p++) {
+            if (a->wires[3 * i + p] != b->wires[3 * i + p]) return false;
+        }
+    }
+    for (size_t i = 0; i < a->redex_queue_size; i++) {
+        const ic_redex_t *ra = &a->redex_queue[(a->redex_queue_start + i) & (a->redex_queue_capacity - 1)];
+        const ic_redex_t *rb = &b->redex_queue[(b->redex_queue_start + i) & (b->redex_queue_capacity - 1)];
+        if (ra->node_a != rb->node_a || ra->node_b != rb->node_b) return false;
+    }
+    return true;
+}
+
+// Test that the streaming enumerator patches exactly the reference nets
+bool test_enum_cursor() {
+    printf("Testing streaming enumerator...\n");
+    
+    ic_net_t *ref = ic_net_create(20, 100);
+    ic_net_t *patched = ic_net_create(20, 100);
+    ic_net_t *small = ic_net_create(6, 100);
+    if (!ref || !patched || !small) TEST_FAIL("Failed to create nets");
+    
+    ic_enum_cursor_t cursor;
+    ic_enum_cursor_init(&cursor);
+    size_t repeats = 0;
+    for (uint64_t index = 0; index < 20000; index++) {
+        ic_enum_build_net_compatible(NULL, index, ref);
+        if (ic_enum_cursor_build(&cursor, index, patched) != 0) TEST_FAIL("Cursor build failed");
+        if (!nets_identical(ref, patched)) {
+            printf("Index %" PRIu64 " differs from the reference build\n", index);
+            TEST_FAIL("Patched net differs");
+        }
+        
+        // A reported repeat is an earlier index with the same layout
+        if (cursor.repeat_of != UINT64_MAX) {
+            repeats++;
+            if (cursor.repeat_of >= index) TEST_FAIL("Repeat is not an earlier index");
+            ic_enum_build_net_compatible(NULL, cursor.repeat_of, ref);
+            if (!nets_identical(ref, patched)) TEST_FAIL("Repeat has a different layout");
+        }
+    }
+    if (repeats == 0) TEST_FAIL("Consecutive patterns should repeat layouts");
+    
+    // Jumping around, and failing exactly where the reference does
+    ic_enum_cursor_init(&cursor);
+    const uint64_t jumps[] = { 977, 3, 123456, 977, 7, 40, 123459, 5 };
+    for (size_t j = 0; j < sizeof(jumps) / sizeof(jumps[0]); j++) {
+        int expected = ic_enum_build_net_compatible(NULL, jumps[j], ref);
+        if (ic_enum_cursor_build(&cursor, jumps[j], patched) != expected) {
+            TEST_FAIL("Cursor and reference disagree on a build");
+        }
+        if (!nets_identical(ref, patched)) TEST_FAIL("Patched net differs after a jump");
+        if (cursor.repeat_of != UINT64_MAX && cursor.repeat_of >= jumps[j]) {
+            TEST_FAIL("Backwards jump reported as a repeat");
+        }
+        
+        expected = ic_enum_build_net_compatible(NULL, jumps[j], small);
+        if (ic_enum_cursor_build(&cursor, jumps[j], small) != expected) {
+            TEST_FAIL("Cursor should fail when the net does not fit");
+        }
+    }
+    
+    // ic_enum_next streams the same nets in index order
+    ic_enum_state_t state;
+    ic_enum_init(&state, 20);
+    for (uint64_t index = 0; index < 500; index++) {
+        if (!ic_enum_next(&state, patched)) TEST_FAIL("ic_enum_next stopped early");
+        ic_enum_build_net(&state, index, ref);
+        if (!nets_identical(ref, patched)) TEST_FAIL("ic_enum_next differs from ic_enum_build_net");
+    }
+    
+    ic_net_free(ref);
+    ic_net_free(patched);
+    ic_net_free(small);
+    TEST_PASS();
+}
+
+// Test that the search loop reuses its nets instead of allocating per index
+bool test_search_net_reuse() {
+    printf("Testing search net reuse...\n");
+    
+    ic_enum_state_t state;
+    ic_enum_init(&state, 20);
+    
+    int64_t solution = ic_search_factor(&state, 6, 20, 1000);
+    if (solution < 0) TEST_FAIL("Search should find a factorization of 6");
+    
+    if (state.indices_searched == 0) TEST_FAIL("No indices were searched");
+    
+    if (state.loop_allocations != 0) {
+        printf("Allocations in loop: %zu over %zu indices\n",
+               state.loop_allocations, state.indices_searched);
+        TEST_FAIL("Search loop should not allocate per index");
+    }
+    
+    TEST_PASS();
+}
+
+static int compare_u64(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t*)a, y = *(const uint64_t*)b;
+    return (x > y) - (x < y);
+}
+
+// Test that deduplication skips repeated nets without changing the answer
+bool test_search_dedup() {
+    printf("Testing search deduplication...\n");
+    
+    ic_enum_state_t plain;
+    ic_enum_init(&plain, 20);
+    ic_enum_set_dedup(&plain, false);
+    int64_t expected = ic_search_factor(&plain, 6, 20, 1000);
+    
+    ic_enum_state_t dedup;
+    ic_enum_init(&dedup, 20);
+    int64_t solution = ic_search_factor(&dedup, 6, 20, 1000);
+    
+    if (solution != expected) {
+        printf("Solution with dedup: %" PRId64 ", without: %" PRId64 "\n", solution, expected);
+        TEST_FAIL("Deduplication changed the search result");
+    }
+    
+    if (plain.indices_deduplicated != 0) TEST_FAIL("Disabled dedup should skip nothing");
+    
+    if (dedup.indices_deduplicated == 0 ||
+        dedup.distinct_nets + dedup.indices_deduplicated > dedup.indices_searched) {
+        printf("Searched %zu, skipped %zu, distinct %zu\n", dedup.indices_searched,
+               dedup.indices_deduplicated, dedup.distinct_nets);
+        TEST_FAIL("Dedup statistics are inconsistent");
+    }
+    
+    // Identical builds hash identically; different indices usually do not
+    ic_net_t *a = ic_net_create(20, 1000);
+    ic_net_t *b = ic_net_create(20, 1000);
+    ic_enum_build_net_compatible(NULL, 5, a);
+    ic_enum_build_net_compatible(NULL, 5, b);
+    bool same = ic_net_hash(a) == ic_net_hash(b);
+    ic_enum_build_net_compatible(NULL, 6, b);
+    bool differs = ic_net_hash(a) != ic_net_hash(b);
+    ic_net_free(a);
+    ic_net_free(b);
+    if (!same || !differs) TEST_FAIL("Net hash does not track the node layout");
+    
+    // Indices share a layout id exactly when they build identical nets
+    const uint64_t indices = 200000;
+    uint64_t *first = (uint64_t*)malloc(IC_ENUM_LAYOUTS * sizeof(uint64_t));
+    uint64_t *hashes = (uint64_t*)malloc(IC_ENUM_LAYOUTS * sizeof(uint64_t));
+    ic_net_t *ref = ic_net_create(20, 1000);
+    ic_net_t *net = ic_net_create(20, 1000);
+    if (!first || !hashes || !ref || !net) TEST_FAIL("Failed to allocate layout check");
+    for (size_t id = 0; id < IC_ENUM_LAYOUTS; id++) first[id] = UINT64_MAX;
+    
+    size_t layouts = 0, searched = 0;
+    size_t min_size = ic_search_min_net_size(11, 20, false);
+    bool exact = true;
+    for (uint64_t index = 0; index < indices && exact; index++) {
+        uint32_t id = ic_enum_layout_id(index);
+        if (id >= IC_ENUM_LAYOUTS) TEST_FAIL("Layout id out of range");
+        ic_enum_build_net_compatible(NULL, index, net);
+        if (first[id] == UINT64_MAX) {
+            first[id] = index;
+            hashes[layouts++] = ic_net_hash(net);
+            if (ic_enum_net_size(index) >= min_size) searched++;
+            continue;
+        }
+        ic_enum_build_net_compatible(NULL, first[id], ref);
+        exact = nets_identical(ref, net);
+    }
+    if (!exact) TEST_FAIL("Indices with one layout id build different nets");
+    
+    qsort(hashes, layouts, sizeof(uint64_t), compare_u64);
+    for (size_t i = 1; i < layouts; i++) {
+        if (hashes[i] == hashes[i - 1]) TEST_FAIL("Different layout ids build the same net");
+    }
+    
+    // The search meets every layout of the size classes it does not prune
+    ic_enum_init(&dedup, 20);
+    ic_enum_set_search_limit(&dedup, indices);
+    ic_search_factor(&dedup, 11, 20, 1000);
+    if (dedup.distinct_nets != searched ||
+        dedup.distinct_nets + dedup.indices_deduplicated != dedup.indices_searched) {
+        printf("Distinct %zu of %zu layouts\n", dedup.distinct_nets, searched);
+        TEST_FAIL("Search dedup misses repeated layouts");
+    }
+    
+    free(first);
+    free(hashes);
+    ic_net_free(ref);
+    ic_net_free(net);
+    TEST_PASS();
+}
+
+bool test_search_batch() {
+    printf("Testing batch search...\n");
+    
+    // Duplicates and invalid targets are allowed in the input
+    const int Ns[] = { 8, 6, 1, 6 };
+    const size_t count = sizeof(Ns) / sizeof(Ns[0]);
+    ic_batch_result_t results[4];
+    
+    ic_enum_state_t batch;
+    ic_enum_init(&batch, 20);
+    int64_t solved = ic_search_factor_batch(&batch, Ns, count, 20, 1000, results);
+    
+    int64_t expected_solved = 0;
+    for (size_t i = 0; i < count; i++) {
+        ic_enum_state_t single;
+        ic_enum_init(&single, 20);
+        int64_t expected = ic_search_factor(&single, Ns[i], 20, 1000);
+        
+        if (results[i].solution_index != expected) {
+            printf("N=%d: batch index %" PRId64 ", single index %" PRId64 "\n", Ns[i],
+                   results[i].solution_index, expected);
+            TEST_FAIL("Batch result differs from a single-target search");
+        }
+        
+        if (expected >= 0) {
+            expected_solved++;
+            if (results[i].factor_a * results[i].factor_b != Ns[i]) {
+                TEST_FAIL("Batch factors do not multiply to the target");
+            }
+        }
+    }
+    
+    if (solved != expected_solved) TEST_FAIL("Wrong number of solved targets");
+    if (results[2].solution_index != -1) TEST_FAIL("Invalid target should not be solved");
+    
+    // A search whose nets cannot be created fails rather than finding nothing
+    ic_enum_init(&batch, IC_NET_MAX_NODES + 1);
+    if (ic_search_factor_batch(&batch, Ns, count, IC_NET_MAX_NODES + 1, 1000, results) != -1) {
+        TEST_FAIL("Batch without nets should fail");
+    }
+    for (size_t i = 0; i < count; i++) {
+        if (results[i].solution_index != -1) TEST_FAIL("Failed batch should leave targets unsolved");
+    }
+    ic_enum_init(&batch, IC_NET_MAX_NODES + 1);
+    if (ic_search_factor(&batch, 6, IC_NET_MAX_NODES + 1, 1000) != IC_SEARCH_ERROR) {
+        TEST_FAIL("Search without nets should report an error");
+    }
+    
+    TEST_PASS();
+}
+
+bool test_solution_indices() {
+    printf("Testing known solution indices...\n");
+    
+    // Factors are slot positions, so these move whenever the reduction
+    // places nodes differently; they are the original reducer's results
+    const int Ns[] = { 2, 3, 4, 5, 6, 7, 8, 9, 10, 11 };
+    const int64_t indices[] = { 80, 202, 403, 884, 322, 3766, 7607, 15288, 30649, -1 };
+    const size_t count = sizeof(Ns) / sizeof(Ns[0]);
+    ic_batch_result_t results[10];
+    
+    ic_enum_state_t state;
+    ic_enum_init(&state, 20);
+    if (ic_search_factor_batch(&state, Ns, count, 20, 1000, results) != 9) {
+        TEST_FAIL("Batch should solve 2 to 10");
+    }
+    for (size_t i = 0; i < count; i++) {
+        if (results[i].solution_index != indices[i]) {
+            printf("N=%d: index %" PRId64 ", expected %" PRId64 "\n", Ns[i],
+                   results[i].solution_index, indices[i]);
+            TEST_FAIL("Solution index changed");
+        }
+    }
+    
+    // Large nets still reach large factors without slot reuse
+    const int large[] = { 9900 };
+    ic_enum_init(&state, 100);
+    if (ic_search_factor_batch(&state, large, 1, 100, 100000, results) != 1 ||
+        results[0].solution_index != 1 || results[0].factor_a * results[0].factor_b != 9900) {
+        TEST_FAIL("9900 should be solved at index 1");
+    }
+    
+    // Slot reuse moves the indices (3 goes from 202 to 1)...
+    ic_enum_init(&state, 20);
+    ic_enum_set_slot_reuse(&state, true);
+    if (ic_search_factor(&state, 3, 20, 1000) != 1) TEST_FAIL("3 should move to index 1 with reuse");
+    
+    // ... and since no reduction then occupies more than IC_ENUM_MAX_SLOTS
+    // slots, factors stop at 14 however large the nets may grow
+    if (ic_search_min_net_size(13 * 14, SIZE_MAX, true) == 0) TEST_FAIL("13 * 14 fits the slots");
+    if (ic_search_min_net_size(14 * 15, SIZE_MAX, true) != 0) TEST_FAIL("14 * 15 needs a slot past the last");
+    ic_enum_init(&state, 100);
+    ic_enum_set_slot_reuse(&state, true);
+    if (ic_search_factor(&state, 9900, 100, 100000) != -1 || state.indices_searched != 0) {
+        TEST_FAIL("9900 should be unsolvable with reuse without searching");
+    }
+    
+    TEST_PASS();
+}
+
+bool test_outcome_table() {
+    printf("Testing precomputed outcome table...\n");
+    
+    const char *path = "test_table.ictb";
+    if (ic_table_precompute(path, 400, 20, 1000) != 0) TEST_FAIL("Failed to precompute table");
+    
+    ic_table_t table;
+    if (ic_table_open(&table, path) != 0) {
+        remove(path);
+        TEST_FAIL("Failed to open table");
+    }
+    
+    bool ok = table.count == 400 && table.header->max_nodes == 20 && table.header->gas_limit == 1000;
+    
+    // Stored outcomes match reducing the index directly
+    ic_net_t *net = ic_net_create(20, 1000);
+    for (size_t i = 0; ok && i < table.count; i += 37) {
+        ic_outcome_t direct;
+        ic_table_outcome(net, i, &direct);
+        ok = memcmp(&direct, &table.outcomes[i], sizeof(direct)) == 0;
+    }
+    ic_net_free(net);
+    
+    // Lookups agree with a live search
+    ic_enum_state_t state;
+    ic_enum_init(&state, 20);
+    int64_t expected = ic_search_factor(&state, 6, 20, 1000);
+    int factor_a = 0, factor_b = 0;
+    int64_t index = ic_table_find_factor(&table, 6, &factor_a, &factor_b);
+    ic_table_close(&table);
+    
+    // A file that is not a table is rejected
+    FILE *bogus = fopen(path, "wb");
+    if (bogus) {
+        fputs("not a table", bogus);
+        fclose(bogus);
+    }
+    bool rejected = ic_table_open(&table, path) != 0;
+    remove(path);
+    
+    if (!ok) TEST_FAIL("Stored outcomes differ from direct reduction");
+    if (index != expected || factor_a * factor_b != 6) {
+        printf("Table index %" PRId64 ", search index %" PRId64 "\n", index, expected);
+        TEST_FAIL("Table lookup differs from search");
+    }
+    if (!rejected) TEST_FAIL("Opened a file that is not a table");
+    
+    TEST_PASS();
+}
+
+bool test_net_serialization() {
+    printf("Testing binary net serialization...\n");
+    
+    // Every sample index, pristine and reduced, as consecutive records
+    const char *path = "test_nets.icnet";
+    FILE *out = fopen(path, "wb");
+    if (!out) TEST_FAIL("Failed to create net file");
+    
+    enum { SAMPLES = 40 };
+    uint64_t hashes[2 * SAMPLES];
+    size_t gas[SAMPLES];
+    ic_net_t *net = ic_net_create(20, 1000);
+    bool written = true;
+    for (size_t k = 0; k < SAMPLES; k++) {
+        ic_enum_build_index(k * 37, net);
+        hashes[2 * k] = ic_net_hash(net);
+        written = written && ic_net_write(out, net, k * 37, -1) == 0;
+        int status = ic_net_reduce(net);
+        hashes[2 * k + 1] = ic_net_hash(net);
+        gas[k] = net->gas_used;
+        written = written && ic_net_write(out, net, k * 37, status) == 0;
+    }
+    written = (fclose(out) == 0) && written;
+    if (!written) TEST_FAIL("Failed to write nets");
+    
+    // Read back, a pristine net reduces exactly like the original
+    FILE *in = fopen(path, "rb");
+    ic_net_t *copy = ic_net_create(20, 1000);
+    ic_netfile_header_t header;
+    bool same = in != NULL;
+    for (size_t k = 0; same && k < SAMPLES; k++) {
+        same = ic_net_read(in, copy, &header) == 1 && header.index == k * 37 &&
+               header.status == -1 && ic_net_hash(copy) == hashes[2 * k];
+        ic_net_reduce(copy);
+        same = same && ic_net_hash(copy) == hashes[2 * k + 1] && copy->gas_used == gas[k];
+        
+        int factor_a, factor_b;
+        bool has_pair = ic_net_factor_pair(copy, &factor_a, &factor_b);
+        same = same && ic_net_read(in, copy, &header) == 1 &&
+               ic_net_hash(copy) == hashes[2 * k + 1] && copy->gas_used == gas[k] &&
+               copy->factor_found == has_pair && (!has_pair || copy->factor_a == factor_a);
+    }
+    bool at_end = same && ic_net_read(in, copy, &header) == 0;
+    if (in) fclose(in);
+    
+    // Mapped views see the same nets without copying them
+    ic_netfile_t file;
+    bool mapped = ic_netfile_open(&file, path) == 0 && file.count == 2 * SAMPLES;
+    size_t offset = 0, views = 0;
+    ic_net_t view;
+    const ic_netfile_header_t *stored;
+    while (mapped && ic_netfile_next(&file, &offset, &view, &stored)) {
+        mapped = ic_net_hash(&view) == hashes[views] && stored->index == (views / 2) * 37 &&
+                 (const unsigned char*)view.wires == (const unsigned char*)(stored + 1);
+        views++;
+    }
+    mapped = mapped && views == 2 * SAMPLES;
+    ic_netfile_close(&file);
+    
+    // Anything else is rejected
+    FILE *bogus = fopen(path, "wb");
+    if (bogus) {
+        fputs("not a net file, but long enough to hold a header or two of one", bogus);
+        fclose(bogus);
+    }
+    bool rejected = ic_netfile_open(&file, path) != 0;
+    bogus = fopen(path, "rb");
+    rejected = rejected && bogus && ic_net_read(bogus, copy, NULL) == -1;
+    if (bogus) fclose(bogus);
+    remove(path);
+    
+    // The search dumps its solving net straight from the thread that
+    // reduced it
+    FILE *dump = tmpfile();
+    ic_enum_state_t state;
+    ic_enum_init(&state, 20);
+    ic_enum_set_dump(&state, dump, false);
+    int64_t solution = ic_search_factor(&state, 8, 20, 1000);
+    
+    ic_enum_build_index((uint64_t)solution, net);
+    ic_net_reduce(net);
+    bool found = false;
+    if (dump) rewind(dump);
+    while (dump && ic_net_read(dump, copy, &header) == 1) {
+        if (header.index != (uint64_t)solution) continue;
+        found = ic_net_hash(copy) == ic_net_hash(net) && copy->factor_found &&
+                copy->factor_a * copy->factor_b == 8;
+    }
+    bool dumped = dump && found && state.nets_dumped > 0 && state.loop_allocations == 0;
+    if (dump) fclose(dump);
+    
+    ic_net_free(copy);
+    ic_net_free(net);
+    
+    if (!same) TEST_FAIL("Net read back differs from the one written");
+    if (!at_end) TEST_FAIL("Reading past the last record did not report the end");
+    if (!mapped) TEST_FAIL("Mapped views differ from the nets written");
+    if (!rejected) TEST_FAIL("Accepted a file that is not a net file");
+    if (!dumped) TEST_FAIL("Search did not dump its solving net");
+    
+    TEST_PASS();
+}
+
+/**
+ * Producer threads of test_all_solutions' writer check, each owning the
+ * indices congruent to its number
+ */
+typedef struct {
+    _Atomic uint64_t working[4];
+    ic_solution_writer_t *writer;
+    uint64_t count;
+    uint64_t window;
+} writer_test_threads_t;
+
+static uint64_t writer_test_frontier(void *context) {
+    writer_test_threads_t *threads = (writer_test_threads_t*)context;
+    uint64_t lowest = UINT64_MAX;
+    for (int t = 0; t < 4; t++) {
+        uint64_t working = atomic_load(&threads->working[t]);
+        if (working < lowest) lowest = working;
+    }
+    return lowest;
+}
+
+typedef struct {
+    writer_test_threads_t *threads;
+    int thread;
+} writer_test_producer_t;
+
+/**
+ * Submit the indices of one producer, never running a window ahead
+ */
+static void *writer_test_produce(void *arg) {
+    writer_test_producer_t *producer = (writer_test_producer_t*)arg;
+    writer_test_threads_t *threads = producer->threads;
+    int t = producer->thread;
+    for (uint64_t index = t; index < threads->count; index += 4) {
+        atomic_store(&threads->working[t], index);
+        while (index - writer_test_frontier(threads) >= threads->window) {
+            sched_yield();
+        }
+        ic_solution_t solution = { .index = index, .N = 1, .factor_a = 1, .factor_b = 1 };
+        ic_solution_writer_submit(threads->writer, &solution);
+    }
+    atomic_store(&threads->working[t], UINT64_MAX);
+    return NULL;
+}
+
+/**
+ * Read "index N factor_a factor_b" lines back from a stream
+ * @return Lines read, or -1 if a line is out of order
+ */
+static long read_solution_lines(FILE *in, uint64_t *indices, int *Ns, long capacity) {
+    rewind(in);
+    long count = 0;
+    uint64_t index;
+    int N, factor_a, factor_b;
+    while (fscanf(in, "%" SCNu64 " %d %d %d", &index, &N, &factor_a, &factor_b) == 4) {
+        if (count > 0 && index <= indices[count - 1]) return -1;
+        if (count < capacity) {
+            indices[count] = index;
+            Ns[count] = N;
+        }
+        count++;
+    }
+    return count;
+}
+
+bool test_all_solutions() {
+    printf("Testing search for every solution...\n");
+    
+    // Expected: every index of the range whose reduced net factors 6 or 8
+    enum { RANGE = 20000, MAX_LINES = 4096 };
+    static uint64_t expected[MAX_LINES], got[MAX_LINES];
+    static int expected_N[MAX_LINES], got_N[MAX_LINES];
+    long expected_count = 0;
+    ic_net_t *net = ic_net_create(20, 1000);
+    for (uint64_t index = 0; index < RANGE; index++) {
+        int factor_a, factor_b;
+        ic_enum_build_index(index, net);
+        ic_net_reduce(net);
+        if (!ic_net_factor_pair(net, &factor_a, &factor_b)) continue;
+        int N = factor_a * factor_b;
+        if ((N == 6 || N == 8) && expected_count < MAX_LINES) {
+            expected[expected_count] = index;
+            expected_N[expected_count++] = N;
+        }
+    }
+    ic_net_free(net);
+    if (expected_count < 10 || expected_count == MAX_LINES) {
+        TEST_FAIL("Test expects a few dozen to a few thousand solutions");
+    }
+    
+    // Every thread count writes exactly those lines, in order
+    const int Ns[] = { 6, 8 };
+    const int runs[] = { 1, 3, 2 };
+    bool same = true, smallest = true;
+    for (size_t r = 0; r < sizeof(runs) / sizeof(runs[0]); r++) {
+        FILE *out = tmpfile();
+        ic_enum_state_t state;
+        ic_enum_init(&state, 20);
+        ic_enum_set_search_limit(&state, RANGE);
+        ic_enum_set_threads(&state, runs[r]);
+        ic_enum_set_all_solutions(&state, out);
+        ic_batch_result_t results[2];
+        ic_search_factor_batch(&state, Ns, 2, 20, 1000, results);
+        
+        long count = out ? read_solution_lines(out, got, got_N, MAX_LINES) : -1;
+        same = same && count == expected_count && state.solutions_written == (uint64_t)count &&
+               memcmp(got, expected, count * sizeof(uint64_t)) == 0 &&
+               memcmp(got_N, expected_N, count * sizeof(int)) == 0;
+        
+        // Targets still report their first solution
+        for (int t = 0; t < 2; t++) {
+            long first = 0;
+            while (first < expected_count && expected_N[first] != Ns[t]) first++;
+            smallest = smallest && results[t].solution_index == (int64_t)expected[first];
+        }
+        if (out) fclose(out);
+    }
+    
+    // The writer reorders out-of-order producers through a tiny queue,
+    // as long as none runs more than a window ahead of the slowest
+    enum { WINDOW = 16, COUNT = 20000 };
+    ic_solution_writer_t writer;
+    writer_test_threads_t threads = { .writer = &writer, .count = COUNT, .window = WINDOW };
+    for (int t = 0; t < 4; t++) atomic_init(&threads.working[t], (uint64_t)t);
+    FILE *out = tmpfile();
+    bool started = out && ic_solution_writer_start(&writer, out, 4, WINDOW + 1,
+                                                   writer_test_frontier, &threads) == 0;
+    if (started) {
+        pthread_t producers[4];
+        writer_test_producer_t args[4];
+        for (int t = 0; t < 4; t++) {
+            args[t] = (writer_test_producer_t){ .threads = &threads, .thread = t };
+            pthread_create(&producers[t], NULL, writer_test_produce, &args[t]);
+        }
+        for (int t = 0; t < 4; t++) pthread_join(producers[t], NULL);
+    }
+    bool ordered = started && ic_solution_writer_finish(&writer) == 0 && writer.written == COUNT;
+    if (ordered) {
+        rewind(out);
+        uint64_t index;
+        int N, factor_a, factor_b;
+        for (uint64_t i = 0; ordered && i < COUNT; i++) {
+            ordered = fscanf(out, "%" SCNu64 " %d %d %d", &index, &N, &factor_a, &factor_b) == 4 &&
+                      index == i;
+        }
+    }
+    if (out) fclose(out);
+    
+    if (!same) TEST_FAIL("Search did not write exactly every solution in index order");
+    if (!smallest) TEST_FAIL("Targets lost their smallest solution");
+    if (!ordered) TEST_FAIL("Writer did not write every solution in index order");
+    
+    TEST_PASS();
+}
+
+bool test_search_checkpoint() {
+    printf("Testing search limit and checkpoint/resume...\n");
+    
+    const char *path = "test_checkpoint.txt";
+    remove(path);
+    
+    ic_enum_state_t fresh;
+    ic_enum_init(&fresh, 20);
+    int64_t expected = ic_search_factor(&fresh, 8, 20, 1000);
+    if (expected < 2000) TEST_FAIL("Test expects 8 to need more than 2000 indices");
+    
+    // A limited search stops short and leaves its frontier behind
+    ic_enum_state_t first;
+    ic_enum_init(&first, 20);
+    ic_enum_set_search_limit(&first, 2000);
+    ic_enum_set_checkpoint(&first, path, 500, false);
+    int64_t partial = ic_search_factor(&first, 8, 20, 1000);
+    bool limited = partial == -1 && first.current_index == 2000;
+    
+    // Resuming skips the indices already covered and finds the same answer
+    ic_enum_state_t second;
+    ic_enum_init(&second, 20);
+    ic_enum_set_checkpoint(&second, path, 500, true);
+    int64_t resumed = ic_search_factor(&second, 8, 20, 1000);
+    bool skipped = second.resumed_from == 2000 &&
+                   second.indices_searched < fresh.indices_searched;
+    
+    // A checkpoint from a search with other parameters is not used
+    ic_enum_state_t other;
+    ic_enum_init(&other, 20);
+    ic_enum_set_search_limit(&other, 100);
+    ic_enum_set_checkpoint(&other, path, 0, true);
+    ic_search_factor(&other, 8, 20, 500);
+    bool ignored = other.resumed_from == 0;
+    
+    remove(path);
+    
+    if (!limited) TEST_FAIL("Search did not stop at its limit");
+    if (resumed != expected) {
+        printf("Resumed index %" PRId64 ", fresh index %" PRId64 "\n", resumed, expected);
+        TEST_FAIL("Resumed search found a different solution");
+    }
+    if (!skipped) TEST_FAIL("Resumed search did not start at the saved frontier");
+    if (!ignored) TEST_FAIL("Resumed from a checkpoint of a different search");
+    
+    TEST_PASS();
+}
+
+bool test_sharded_search() {
+    printf("Testing sharded search and result merge...\n");
+    
+    const int Ns[] = { 6, 8 };
+    ic_batch_result_t expected[2];
+    ic_enum_state_t single;
+    ic_enum_init(&single, 20);
+    ic_enum_set_search_limit(&single, 9000);
+    ic_search_factor_batch(&single, Ns, 2, 20, 1000, expected);
+    
+    // Run three shards, each writing and re-reading its record
+    const char *paths[3] = { "test_shard0.txt", "test_shard1.txt", "test_shard2.txt" };
+    ic_result_record_t records[3];
+    uint64_t next_start = 0;
+    bool contiguous = true;
+    bool io_ok = true;
+    for (int k = 0; k < 3; k++) {
+        ic_enum_state_t shard;
+        ic_enum_init(&shard, 20);
+        ic_enum_set_search_limit(&shard, 9000);
+        ic_enum_set_shard(&shard, k, 3);
+        contiguous = contiguous && shard.search_start == next_start;
+        next_start = shard.search_limit;
+        
+        int shard_Ns[2] = { 6, 8 };
+        ic_batch_result_t results[2];
+        ic_search_factor_batch(&shard, shard_Ns, 2, 20, 1000, results);
+        
+        ic_result_record_t record = {
+            .max_nodes = 20, .gas_limit = 1000,
+            .range_start = shard.search_start, .range_end = shard.search_limit,
+            .count = 2, .Ns = shard_Ns, .results = results,
+        };
+        io_ok = io_ok && ic_result_write(paths[k], &record) == 0 &&
+                ic_result_read(paths[k], &records[k]) == 0 &&
+                records[k].count == 2 && records[k].results[1].solution_index == results[1].solution_index;
+        remove(paths[k]);
+    }
+    if (!io_ok) TEST_FAIL("Result records did not round-trip");
+    if (!contiguous || next_start != 9000) TEST_FAIL("Shards do not tile the range");
+    
+    // Merging in any order gives the single-node answer
+    ic_result_record_t shuffled[3] = { records[2], records[0], records[1] };
+    ic_result_record_t merged;
+    bool merged_ok = ic_result_merge(shuffled, 3, &merged) == 0 && merged.range_end == 9000;
+    for (int i = 0; merged_ok && i < 2; i++) {
+        merged_ok = merged.results[i].solution_index == expected[i].solution_index;
+    }
+    ic_result_free(&merged);
+    
+    // Without the first shard the covered prefix is empty
+    bool gap_ok = ic_result_merge(&records[1], 2, &merged) == 0 && merged.range_end == 0;
+    ic_result_free(&merged);
+    
+    for (int k = 0; k < 3; k++) {
+        ic_result_free(&records[k]);
+    }
+    
+    if (!merged_ok) TEST_FAIL("Merged shards differ from a single-node search");
+    if (!gap_ok) TEST_FAIL("Merge did not detect the missing shard");
+    
+    TEST_PASS();
+}
+
+bool test_search_ordered_exit() {
+    printf("Testing ordered early exit...\n");
+    
+#ifdef _OPENMP
+    int saved_threads = omp_get_max_threads();
+    const int thread_counts[] = { 1, 2, 4 };
+#else
+    const int thread_counts[] = { 1 };
+#endif
+    const size_t runs = sizeof(thread_counts) / sizeof(thread_counts[0]);
+    
+    const int Ns[] = { 6, 8 };
+    int64_t first[2] = { -1, -1 };
+    bool same = true;
+    bool bounded = true;
+    
+    for (size_t r = 0; r < runs; r++) {
+#ifdef _OPENMP
+        omp_set_num_threads(thread_counts[r]);
+#endif
+        ic_enum_state_t state;
+        ic_enum_init(&state, 20);
+        ic_batch_result_t results[2];
+        ic_search_factor_batch(&state, Ns, 2, 20, 1000, results);
+        
+        if (r == 0) {
+            first[0] = results[0].solution_index;
+            first[1] = results[1].solution_index;
+        }
+        same = same && results[0].solution_index == first[0] &&
+               results[1].solution_index == first[1];
+        
+        // Past the last solution, each thread finishes at most its chunk
+        size_t last = (size_t)(first[0] > first[1] ? first[0] : first[1]);
+        bounded = bounded && state.indices_searched <=
+                  last + 1 + (size_t)thread_counts[r] * IC_SEARCH_CHUNK;
+    }
+    
+#ifdef _OPENMP
+    omp_set_num_threads(saved_threads);
+#endif
+    
+    if (first[0] < 0 || first[1] < 0) TEST_FAIL("Search should factor 6 and 8");
+    if (!same) TEST_FAIL("Solution depends on the thread count");
+    if (!bounded) TEST_FAIL("Threads kept searching past the last solution");
+    
+    TEST_PASS();
+}
+
+// Test that the fixed-capacity reducers reproduce ic_net_reduce
+bool test_fixed_reducers() {
+    printf("Testing fixed-capacity reducers...\n");
+    
+    ic_net16_t n16;
+    ic_net32_t n32;
+    ic_net64_t n64;
+    const size_t node_limits[] = { 8, 16, 100 };
+    const size_t capacities[3] = { 16, 32, 64 };
+    
+    for (size_t c = 0; c < 2 * sizeof(node_limits) / sizeof(node_limits[0]); c++) {
+        size_t max_nodes = node_limits[c / 2];
+        bool reuse = c % 2;
+        ic_net_t *ref = ic_net_create(max_nodes, 1000);
+        if (!ref) TEST_FAIL("Failed to create net");
+        ic_net16_init(&n16, max_nodes, 1000);
+        ic_net32_init(&n32, max_nodes, 1000);
+        ic_net64_init(&n64, max_nodes, 1000);
+        ic_net_t *fixed[3] = { &n16.net, &n32.net, &n64.net };
+        ic_net_set_slot_reuse(ref, reuse);
+        for (int f = 0; f < 3; f++) ic_net_set_slot_reuse(fixed[f], reuse);
+        
+        for (size_t index = 0; index < 2000; index++) {
+            if (ic_enum_build_net_compatible(NULL, index, ref) != 0) continue;
+            if (ref->used_nodes > IC_ENUM_MAX_NET_NODES) TEST_FAIL("Enumerated net is too big");
+            for (int f = 0; f < 3; f++) {
+                if (ic_enum_build_net_compatible(NULL, index, fixed[f]) != 0) {
+                    TEST_FAIL("Fixed net could not be built");
+                }
+            }
+            
+            int result = ic_net_reduce(ref);
+            if (reuse && ref->used_nodes > IC_ENUM_MAX_SLOTS) {
+                TEST_FAIL("Reduction outgrew IC_ENUM_MAX_SLOTS");
+            }
+            int results[3] = { ic_net16_reduce(&n16), ic_net32_reduce(&n32), ic_net64_reduce(&n64) };
+            
+            for (int f = 0; f < 3; f++) {
+                // Without reuse a net may need more slots than the storage has
+                if (results[f] == -1 && ref->used_nodes > capacities[f]) continue;
+                if (results[f] != result || fixed[f]->gas_used != ref->gas_used ||
+                    ic_net_hash(fixed[f]) != ic_net_hash(ref)) {
+                    TEST_FAIL("Fixed reducer differs from ic_net_reduce");
+                }
+            }
+        }
+        ic_net_free(ref);
+    }
+    
+    // A net that needs more slots than the storage has is handed back
+    ic_net16_init(&n16, 100, 1000);
+    for (int i = 0; i < 16; i++) {
+        ic_net_new_node(&n16.net, (i % 2) ? IC_NODE_GAMMA : IC_NODE_DELTA);
+    }
+    ic_net_connect(&n16.net, 0, 0, 1, 0);
+    if (ic_net16_reduce(&n16) != -1) TEST_FAIL("Overflowing fixed net should return -1");
+    
+    // At the net's own limit the δγ rule is refused as in ic_net_reduce
+    ic_net_t *ref = ic_net_create(16, 1000);
+    ic_net16_init(&n16, 16, 1000);
+    ic_net_t *pair[2] = { ref, &n16.net };
+    for (int k = 0; k < 2; k++) {
+        for (int i = 0; i < 16; i++) {
+            ic_net_new_node(pair[k], (i % 2) ? IC_NODE_GAMMA : IC_NODE_DELTA);
+        }
+        ic_net_connect(pair[k], 0, 0, 1, 0);
+    }
+    int result = ic_net_reduce(ref);
+    if (ic_net16_reduce(&n16) != result || n16.net.gas_used != ref->gas_used ||
+        ic_net_hash(&n16.net) != ic_net_hash(ref)) {
+        TEST_FAIL("Full fixed net should behave like ic_net_reduce");
+    }
+    ic_net_free(ref);
+    
+    // The search picks the smallest fixed net that holds max_nodes slots...
+    ic_enum_state_t state;
+    ic_enum_init(&state, 20);
+    int64_t solution = ic_search_factor(&state, 6, 20, 1000);
+    if (state.fixed_capacity != 32) TEST_FAIL("Search should reduce in a 32-slot net");
+    if (solution != 322) TEST_FAIL("Fixed reducer changed the solution for 6");
+    if (state.loop_allocations != 0) TEST_FAIL("Fixed reducer allocated in the search loop");
+    
+    // ... or, with slot reuse, every reduction of an enumerated net
+    ic_enum_init(&state, 20);
+    ic_enum_set_slot_reuse(&state, true);
+    solution = ic_search_factor(&state, 6, 20, 1000);
+    if (state.fixed_capacity != 16) TEST_FAIL("Search should reduce in a 16-slot net");
+    if (solution != 322) TEST_FAIL("Fixed reducer changed the solution for 6");
+    
+    TEST_PASS();
+}
+
+// Test that loop detection ends looping nets early without changing them
+static uint64_t shape_mix(uint64_t h, uint64_t v) {
+    h ^= v + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2);
+    return h * 0xff51afd7ed558ccdULL;
+}
+
+/**
+ * Hash of the live graph that ignores slot numbering: each node's label
+ * is refined from its peers' labels, and the sorted labels are hashed
+ */
+static uint64_t net_shape_hash(const ic_net_t *net) {
+    size_t used = net->used_nodes;
+    uint64_t *labels = (uint64_t*)calloc(used + 1, sizeof(uint64_t));
+    uint64_t *next = (uint64_t*)calloc(used + 1, sizeof(uint64_t));
+    for (size_t i = 0; i < used; i++) labels[i] = net->types[i] + 1;
+    
+    for (int round = 0; round < 16; round++) {
+        for (size_t i = 0; i < used; i++) {
+            if (!net->active[i]) continue;
+            uint64_t h = labels[i];
+            for (int p = 0; p < 3; p++) {
+                ic_wire_t peer = net->wires[3 * i + p];
+                bool live = peer != IC_WIRE_NONE && net->active[IC_WIRE_NODE(peer)];
+                h = shape_mix(h, live ? shape_mix(labels[IC_WIRE_NODE(peer)], IC_WIRE_PORT(peer)) : 7);
+            }
+            next[i] = h;
+        }
+        memcpy(labels, next, used * sizeof(uint64_t));
+    }
+    
+    size_t live = 0;
+    for (size_t i = 0; i < used; i++) {
+        if (net->active[i]) next[live++] = labels[i];
+    }
+    qsort(next, live, sizeof(uint64_t), compare_u64);
+    uint64_t h = live;
+    for (size_t i = 0; i < live; i++) h = shape_mix(h, next[i]);
+    free(labels);
+    free(next);
+    return h;
+}
+
+/**
+ * Append a copy of a net's nodes and wiring to another net
+ */
+static void append_net(ic_net_t *into, const ic_net_t *part) {
+    size_t offset = into->used_nodes;
+    for (size_t n = 0; n < part->used_nodes; n++) {
+        ic_net_new_node(into, ic_net_node_type(part, n));
+    }
+    for (size_t w = 0; w < 3 * part->used_nodes; w++) {
+        ic_wire_t wire = part->wires[w];
+        into->wires[3 * offset + w] = (wire == IC_WIRE_NONE) ? IC_WIRE_NONE :
+            IC_WIRE(IC_WIRE_NODE(wire) + offset, IC_WIRE_PORT(wire));
+    }
+}
+
+// Test that the parallel reducer reaches ic_net_reduce's normal forms
+bool test_parallel_reduction() {
+    printf("Testing parallel reduction...\n");
+    
+    ic_net_t *ref = ic_net_create(100, 1000);
+    ic_net_t *par = ic_net_create(100, 1000);
+    ic_net_t *big_ref = ic_net_create(20000, 1000000);
+    ic_net_t *big_par = ic_net_create(20000, 1000000);
+    if (!ref || !par || !big_ref || !big_par) TEST_FAIL("Failed to create nets");
+    ic_net_set_slot_reuse(big_ref, true);
+    ic_net_set_slot_reuse(big_par, true);
+    
+    size_t normal_forms = 0, pairs = 0;
+    for (size_t index = 0; index < 2000; index++) {
+        if (ic_enum_build_net_compatible(NULL, index, ref) != 0) continue;
+        ic_enum_build_net_compatible(NULL, index, par);
+        int result = ic_net_reduce(ref);
+        int par_result = ic_net_reduce_parallel(par, 4);
+        
+        // Nets that loop spend the whole gas either way, in some order
+        if (result != 0) {
+            if (par_result != 1 || par->gas_used != ref->gas_used) {
+                TEST_FAIL("Gas-limited net should spend its gas in parallel too");
+            }
+            continue;
+        }
+        if (par_result != 0 || par->gas_used != ref->gas_used ||
+            net_shape_hash(par) != net_shape_hash(ref)) {
+            printf("Index %zu differs\n", index);
+            TEST_FAIL("Parallel normal form differs from ic_net_reduce");
+        }
+        
+        // A pair survives in both or neither; only the serial slots are factors
+        int ref_a, ref_b, par_a, par_b;
+        bool ref_pair = ic_net_factor_pair(ref, &ref_a, &ref_b);
+        if (ref_pair != ic_net_factor_pair(par, &par_a, &par_b)) {
+            printf("Index %zu: serial pair %s\n", index, ref_pair ? "kept" : "lost");
+            TEST_FAIL("Parallel reduction changed whether a pair survives");
+        }
+        pairs += ref_pair;
+        
+        // The terminating nets side by side make one large net
+        if (big_ref->used_nodes + ref->max_nodes <= big_ref->max_nodes) {
+            ic_enum_build_net_compatible(NULL, index, ref);
+            append_net(big_ref, ref);
+            append_net(big_par, ref);
+        }
+        normal_forms++;
+    }
+    if (normal_forms == 0) TEST_FAIL("No test net reached normal form");
+    if (pairs == 0) TEST_FAIL("No terminating test net kept a factor pair");
+    
+    int result = ic_net_reduce(big_ref);
+    if (result != 0 || ic_net_reduce_parallel(big_par, 4) != 0 ||
+        big_par->gas_used != big_ref->gas_used ||
+        net_shape_hash(big_par) != net_shape_hash(big_ref)) {
+        TEST_FAIL("Parallel normal form of the large net differs");
+    }
+    
+    // The freed slots are handed back, so the net can be built and reduced again
+    size_t live = 0;
+    for (size_t i = 0; i < big_par->used_nodes; i++) live += big_par->active[i];
+    size_t spare = 0;
+    for (int slot = big_par->free_head; slot != -1 && spare <= big_par->used_nodes; spare++) {
+        ic_wire_t link = big_par->wires[3 * (size_t)slot];
+        slot = (link == IC_WIRE_NONE) ? -1 : (int)link;
+    }
+    if (live + spare != big_par->used_nodes) TEST_FAIL("Free list lost slots");
+    
+    // A tight gas limit stops after exactly that many rewrites
+    ic_enum_build_net_compatible(NULL, 7, par);
+    par->gas_limit = 5;
+    if (ic_net_reduce_parallel(par, 2) != 1 || par->gas_used != 5) {
+        TEST_FAIL("Parallel reduction should stop at the gas limit");
+    }
+    
+    ic_net_free(ref);
+    ic_net_free(par);
+    ic_net_free(big_ref);
+    ic_net_free(big_par);
+    TEST_PASS();
+}
+
+// Test that compaction renumbers live nodes without changing the reduction
+bool test_compaction() {
+    printf("Testing live-node compaction...\n");
+    
+    // Holes are left wherever the rules erase nodes
+    ic_net_t *net = ic_net_create(200, 1000);
+    if (!net) TEST_FAIL("Failed to create net");
+    ic_net_t *part = ic_net_create(100, 1000);
+    for (size_t index = 0; net->used_nodes + 20 <= net->max_nodes; index++) {
+        ic_enum_build_net_compatible(NULL, index, part);
+        append_net(net, part);
+    }
+    if (ic_net_compact(net) != 0) TEST_FAIL("A net without holes has nothing to reclaim");
+    
+    int eps = ic_net_new_node(net, IC_NODE_EPSILON);
+    int target = ic_net_new_node(net, IC_NODE_DELTA);
+    ic_net_connect(net, eps, 0, target, 0);
+    ic_net_connect(net, 0, 1, target, 1);  // One-way wire, as the builder leaves them
+    ic_net_reduce(net);  // Erases eps and leaves holes wherever the rules erased nodes
+    
+    size_t used = net->used_nodes;
+    size_t live = 0;
+    for (size_t i = 0; i < net->used_nodes; i++) live += net->active[i];
+    uint64_t reduced_shape = net_shape_hash(net);
+    size_t reclaimed = ic_net_compact(net);
+    if (reclaimed == 0 || reclaimed != used - live || net->used_nodes != live ||
+        net->free_head != -1) {
+        TEST_FAIL("Compaction should reclaim exactly the erased slots");
+    }
+    for (size_t i = 0; i < net->used_nodes; i++) {
+        if (!net->active[i]) TEST_FAIL("Compacted net has a hole");
+    }
+    if (net_shape_hash(net) != reduced_shape) TEST_FAIL("Compaction changed the graph");
+    
+    // New nodes go after the compacted ones
+    if (ic_net_new_node(net, IC_NODE_GAMMA) != (int)live) TEST_FAIL("New node should follow the live ones");
+    
+    // Compacting during reduction reaches the same normal form with the same gas
+    ic_net_t *ref = ic_net_create(20000, 1000000);
+    ic_net_t *compacted = ic_net_create(20000, 1000000);
+    for (size_t index = 0; compacted->used_nodes + 20 <= compacted->max_nodes; index++) {
+        ic_enum_build_net_compatible(NULL, index, part);
+        if (ic_net_reduce(part) != 0) continue;
+        ic_enum_build_net_compatible(NULL, index, part);
+        append_net(ref, part);
+        append_net(compacted, part);
+    }
+    ic_net_set_compaction(compacted, 90);
+    int result = ic_net_reduce(ref);
+    if (ic_net_reduce(compacted) != result || compacted->gas_used != ref->gas_used ||
+        net_shape_hash(compacted) != net_shape_hash(ref)) {
+        TEST_FAIL("Compacted reduction differs");
+    }
+    live = 0;
+    for (size_t i = 0; i < ref->used_nodes; i++) live += ref->active[i];
+    if (compacted->used_nodes >= ref->used_nodes || 10 * live < 9 * compacted->used_nodes) {
+        TEST_FAIL("Compaction should keep the used slots near the live count");
+    }
+#ifdef IC_STATS
+    if (compacted->stats.compactions == 0 || compacted->stats.compaction_slots == 0 ||
+        ref->stats.compactions != 0) {
+        TEST_FAIL("Compactions should be counted");
+    }
+#endif
+    
+    ic_net_free(net);
+    ic_net_free(part);
+    ic_net_free(ref);
+    ic_net_free(compacted);
+    TEST_PASS();
+}
+
+bool test_loop_detection() {
+    printf("Testing loop detection...\n");
+    
+    ic_net_t *full = ic_net_create(20, 5000);
+    ic_net_t *checked = ic_net_create(20, 5000);
+    ic_net16_t fixed;
+    if (!full || !checked) TEST_FAIL("Failed to create nets");
+    ic_net_set_loop_check(checked, 8);
+    ic_net16_init(&fixed, 20, 5000);
+    ic_net_set_loop_check(&fixed.net, 8);
+    
+    // With slot reuse the enumerated nets fit the 16-slot reducer
+    ic_net_set_slot_reuse(full, true);
+    ic_net_set_slot_reuse(checked, true);
+    ic_net_set_slot_reuse(&fixed.net, true);
+    
+    size_t loops = 0, skipped = 0;
+    for (size_t index = 0; index < 2000; index++) {
+        if (ic_enum_build_net_compatible(NULL, index, full) != 0) continue;
+        ic_enum_build_net_compatible(NULL, index, checked);
+        ic_enum_build_net_compatible(NULL, index, &fixed.net);
+        
+        int expected = ic_net_reduce(full);
+        int result = ic_net_reduce(checked);
+        int fixed_result = ic_net16_reduce(&fixed);
+        if (result != fixed_result || checked->gas_skipped != fixed.net.gas_skipped) {
+            TEST_FAIL("Fixed reducer detected loops differently");
+        }
+        
+        // A detected loop still ends where the full run ends
+        if (result == 2) {
+            loops++;
+            skipped += checked->gas_skipped;
+            if (expected != 1) TEST_FAIL("A terminating net was reported as looping");
+        } else if (result != expected) {
+            TEST_FAIL("Loop check changed the reduction result");
+        }
+        if (checked->gas_used != full->gas_used || ic_net_hash(checked) != ic_net_hash(full) ||
+            ic_net_hash(&fixed.net) != ic_net_hash(full)) {
+            TEST_FAIL("Loop check changed the final net");
+        }
+    }
+    
+    // A hash that matches a different state is a collision, not a loop
+    ic_enum_build_index(1, checked);
+    ic_loop_detector_t detector;
+    ic_loop_detector_init(&detector, checked);
+    if (ic_loop_detector_sample(&detector, checked)) TEST_FAIL("First sample found a loop");
+    if (ic_net_reduce_steps(checked, 1) != IC_REDUCE_SUSPENDED) {
+        TEST_FAIL("Index 1 should outlast a budget of one rewrite");
+    }
+    detector.saved = ic_net_state_hash(checked);
+    size_t gas_before = checked->gas_used;
+    if (ic_loop_detector_sample(&detector, checked) || detector.found ||
+        checked->gas_used != gas_before || checked->gas_skipped != 0) {
+        TEST_FAIL("A hash collision skipped gas");
+    }
+    
+    ic_net_free(full);
+    ic_net_free(checked);
+    if (loops == 0 || skipped == 0) TEST_FAIL("No looping nets detected");
+    
+    // The search finds the same solutions with detection on and off
+    const int Ns[] = { 6, 8 };
+    ic_batch_result_t with_check[2], without_check[2];
+    ic_enum_state_t state;
+    ic_enum_init(&state, 20);
+    ic_enum_set_loop_check(&state, 0);
+    ic_search_factor_batch(&state, Ns, 2, 20, 5000, without_check);
+    uint64_t rewrites_without = state.rewrites;
+    if (state.loops_detected != 0) TEST_FAIL("Loops detected with the check off");
+    
+    ic_enum_init(&state, 20);
+    ic_search_factor_batch(&state, Ns, 2, 20, 5000, with_check);
+    for (int t = 0; t < 2; t++) {
+        if (with_check[t].solution_index != without_check[t].solution_index ||
+            with_check[t].factor_a != without_check[t].factor_a) {
+            TEST_FAIL("Loop check changed a solution");
+        }
+    }
+    if (state.loops_detected == 0 || state.rewrites >= rewrites_without) {
+        TEST_FAIL("Search should skip the rewrites of looping nets");
+    }
+    
+    TEST_PASS();
+}
+
+// Goal that gives up once a net has used `target` rewrites
+static bool gas_goal_impossible(const ic_goal_t *goal, const ic_net_t *net) {
+    return net->gas_used >= (size_t)goal->target;
+}
+
+// Test that goals decide success and abandon nets that cannot reach them
+bool test_levin_search() {
+    printf("Testing resumable reductions and Levin search...\n");
+    
+    // Reducing in slices ends exactly like one ic_net_reduce call
+    ic_net_t *whole = ic_net_create(20, 5000);
+    ic_net_t *sliced = ic_net_create(20, 5000);
+    if (!whole || !sliced) TEST_FAIL("Failed to create nets");
+    ic_goal_t goal = ic_goal_factor(0);
+    ic_net_set_goal(whole, &goal);
+    ic_net_set_goal(sliced, &goal);
+    ic_net_set_loop_check(whole, 8);
+    ic_net_set_loop_check(sliced, 8);
+    
+    size_t suspensions = 0, loops = 0;
+    for (size_t index = 0; index < 2000; index++) {
+        ic_enum_build_index(index, whole);
+        ic_enum_build_index(index, sliced);
+        int expected = ic_net_reduce(whole);
+        
+        size_t budget = 1 + index % 5;
+        int result;
+        while ((result = ic_net_reduce_steps(sliced, budget)) == IC_REDUCE_SUSPENDED) {
+            suspensions++;
+            budget *= 2;
+        }
+        if (result == 2) loops++;
+        if (result != expected || sliced->gas_used != whole->gas_used ||
+            sliced->gas_skipped != whole->gas_skipped ||
+            ic_net_hash(sliced) != ic_net_hash(whole) ||
+            sliced->factor_found != whole->factor_found ||
+            sliced->factor_a != whole->factor_a || sliced->factor_b != whole->factor_b) {
+            TEST_FAIL("Sliced reduction ended differently from ic_net_reduce");
+        }
+    }
+    if (suspensions == 0 || loops == 0) TEST_FAIL("Test expects suspended and looping nets");
+    
+    // Rebuilding a net discards its suspended reduction
+    ic_enum_build_index(1, sliced);
+    if (ic_net_reduce_steps(sliced, 1) != IC_REDUCE_SUSPENDED) {
+        TEST_FAIL("Index 1 should outlast a budget of one rewrite");
+    }
+    ic_enum_build_index(1, sliced);
+    ic_enum_build_index(1, whole);
+    if (ic_net_reduce_steps(sliced, SIZE_MAX) != ic_net_reduce(whole) ||
+        sliced->gas_used != whole->gas_used || ic_net_hash(sliced) != ic_net_hash(whole)) {
+        TEST_FAIL("A rebuilt net resumed its old reduction");
+    }
+    
+    // Levin search finds a genuine solution, on any number of threads,
+    // with far less work than reducing every index to the gas limit
+    const int Ns[] = { 6, 8 };
+    for (int t = 0; t < 2; t++) {
+        ic_levin_result_t one, three;
+        ic_enum_state_t state;
+        ic_enum_init(&state, 20);
+        ic_enum_set_search_limit(&state, 1u << 14);
+        ic_enum_set_threads(&state, 1);
+        int64_t found = ic_search_levin(&state, Ns[t], 20, 5000, &one);
+        ic_enum_set_threads(&state, 3);
+        ic_search_levin(&state, Ns[t], 20, 5000, &three);
+        
+        if (found < 0 || found != one.solution_index) TEST_FAIL("Levin search found no solution");
+        if (three.solution_index != found || three.phase != one.phase ||
+            three.factor_a != one.factor_a || three.factor_b != one.factor_b) {
+            TEST_FAIL("Levin search depends on the thread count");
+        }
+        if (one.resumptions == 0 || one.peak_suspended == 0) {
+            TEST_FAIL("Levin search never resumed a reduction");
+        }
+        
+        // Skipping duplicate layouts leaves the answer alone
+        ic_levin_result_t all;
+        ic_enum_set_dedup(&state, false);
+        ic_search_levin(&state, Ns[t], 20, 5000, &all);
+        if (all.solution_index != found || all.phase != one.phase ||
+            all.candidates <= one.candidates || state.indices_deduplicated != 0) {
+            TEST_FAIL("Levin deduplication changed the result");
+        }
+        
+        ic_enum_build_index((uint64_t)found, whole);
+        ic_net_reduce(whole);
+        int factor_a, factor_b;
+        if (!ic_net_factor_pair(whole, &factor_a, &factor_b) || factor_a * factor_b != Ns[t] ||
+            factor_a != one.factor_a || whole->gas_used != one.solution_gas) {
+            TEST_FAIL("Levin solution does not factor its target");
+        }
+        
+        ic_enum_init(&state, 20);
+        ic_enum_set_search_limit(&state, 1u << 14);
+        ic_enum_set_loop_check(&state, 0);
+        ic_enum_set_dedup(&state, false);
+        ic_search_factor(&state, Ns[t], 20, 5000);
+        if (one.rewrites * 10 >= state.rewrites) {
+            TEST_FAIL("Levin search should need far fewer rewrites than full gas");
+        }
+    }
+    
+    // Without a solution every distinct candidate runs until its reduction
+    // stops
+    ic_levin_result_t none;
+    ic_enum_state_t state;
+    ic_enum_init(&state, 20);
+    ic_enum_set_search_limit(&state, 1u << 12);
+    if (ic_search_levin(&state, 11, 20, 5000, &none) != -1 || none.phase != 0 ||
+        none.candidates != state.distinct_nets ||
+        none.candidates + state.indices_deduplicated + state.indices_pruned != (1u << 12)) {
+        TEST_FAIL("Unsolvable Levin search should try every candidate");
+    }
+    
+    ic_net_free(whole);
+    ic_net_free(sliced);
+    TEST_PASS();
+}
+
+bool test_goal_pruning() {
+    printf("Testing reduction goals...\n");
+    
+    ic_net_t *net = ic_net_create(20, 1000);
+    ic_net16_t fixed;
+    if (!net) TEST_FAIL("Failed to create net");
+    ic_net16_init(&fixed, 20, 1000);
+    
+    // Without a goal, a net the factor goal rules out never ends with a pair
+    ic_goal_t any_pair = ic_goal_factor(0);
+    size_t hopeless = 0;
+    for (size_t index = 0; index < 3000; index++) {
+        net->input_number = 0;
+        if (ic_enum_build_net_compatible(NULL, index, net) != 0) continue;
+        if (!ic_goal_impossible(&any_pair, net)) continue;
+        hopeless++;
+        ic_net_reduce(net);
+        if (ic_net_factor_pair(net, NULL, NULL)) {
+            printf("Index %zu ends with a pair\n", index);
+            TEST_FAIL("Factor goal pruned a net that reaches it");
+        }
+    }
+    if (hopeless == 0) TEST_FAIL("Factor goal never prunes");
+    
+    // Index 322 factors 6; the goal records its pair only for its own N
+    ic_goal_t six = ic_goal_factor(6);
+    ic_goal_t seven = ic_goal_factor(7);
+    ic_net_set_goal(net, &six);
+    ic_enum_build_net_compatible(NULL, 322, net);
+    if (ic_net_reduce(net) == 3 || !ic_net_has_valid_factor(net, 6)) {
+        TEST_FAIL("Goal for 6 missed the solution at index 322");
+    }
+    ic_net_set_goal(net, &seven);
+    ic_enum_build_net_compatible(NULL, 322, net);
+    ic_net_reduce(net);
+    if (net->factor_found) TEST_FAIL("Goal for 7 accepted a pair for 6");
+    
+    // A goal is polled every poll_interval rewrites, by both reducers
+    ic_goal_t gas_goal = { .reached = NULL, .impossible = gas_goal_impossible,
+                           .poll_interval = 4, .target = 10 };
+    ic_net_set_goal(net, &gas_goal);
+    ic_net_set_goal(&fixed.net, &gas_goal);
+    ic_net_set_slot_reuse(net, true);
+    ic_net_set_slot_reuse(&fixed.net, true);
+    size_t abandoned = 0;
+    for (size_t index = 0; index < 200; index++) {
+        ic_enum_build_net_compatible(NULL, index, net);
+        ic_enum_build_net_compatible(NULL, index, &fixed.net);
+        int status = ic_net_reduce(net);
+        if (ic_net16_reduce(&fixed) != status || fixed.net.gas_used != net->gas_used) {
+            TEST_FAIL("Fixed reducer polls the goal differently");
+        }
+        if (status == 3) {
+            abandoned++;
+            if (net->gas_used != 12) TEST_FAIL("Goal was not polled at its interval");
+        } else if (net->gas_used > 12) {
+            TEST_FAIL("Net ran past an impossible goal");
+        }
+    }
+    if (abandoned == 0) TEST_FAIL("No net was abandoned");
+    ic_net_free(net);
+    
+    // Pruning only skips work: same solutions, fewer rewrites
+    const int Ns[] = { 6, 8 };
+    for (size_t i = 0; i < 2; i++) {
+        ic_enum_state_t plain, pruned;
+        ic_enum_init(&plain, 20);
+        ic_enum_set_prune(&plain, false);
+        ic_enum_init(&pruned, 20);
+        int64_t expected = ic_search_factor(&plain, Ns[i], 20, 1000);
+        int64_t solution = ic_search_factor(&pruned, Ns[i], 20, 1000);
+        if (solution != expected) TEST_FAIL("Pruning changed the solution");
+        if (plain.nets_abandoned != 0) TEST_FAIL("Disabled pruning abandoned nets");
+        if (pruned.nets_abandoned == 0 || pruned.rewrites >= plain.rewrites) {
+            TEST_FAIL("Pruning did not skip any work");
+        }
+    }
+    
+    TEST_PASS();
+}
+
+// Test that indices too small for any target's factors are skipped
+bool test_divisor_pruning() {
+    printf("Testing divisor pruning...\n");
+    
+    // With slot reuse every factor pair satisfies the bounds the pruning relies on
+    ic_net_t *net = ic_net_create(20, 1000);
+    if (!net) TEST_FAIL("Failed to create net");
+    ic_net_set_slot_reuse(net, true);
+    for (size_t index = 0; index < 3000; index++) {
+        net->input_number = 0;
+        ic_enum_build_net_compatible(NULL, index, net);
+        ic_net_reduce(net);
+        int a, b;
+        if (!ic_net_factor_pair(net, &a, &b)) continue;
+        size_t bound = ic_enum_net_size(index) + 2;
+        if (a == b || (size_t)a > bound || (size_t)b > bound) {
+            printf("Index %zu reported %d * %d\n", index, a, b);
+            TEST_FAIL("Factor pair exceeds the net size bound");
+        }
+    }
+    ic_net_free(net);
+    
+    // Without it only max_nodes bounds the factors
+    const struct { int N; size_t max_nodes; bool reuse; size_t size; } cases[] = {
+        { 6, 100, true, 3 }, { 4, 100, true, 3 }, { 7, 100, true, 5 }, { 9, 100, true, 7 },
+        { 13, 100, true, 11 }, { 17, 100, true, 0 }, { 49, 100, true, 0 }, { 1, 100, true, 0 },
+        { 12, 4, true, 3 }, { 7, 6, true, 0 }, { 7, 100, false, 3 }, { 17, 100, false, 3 },
+        { 49, 100, false, 3 }, { 49, 40, false, 0 }, { 7, 6, false, 0 }, { 9900, 100, false, 3 },
+    };
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        if (ic_search_min_net_size(cases[i].N, cases[i].max_nodes, cases[i].reuse) != cases[i].size) {
+            printf("N = %d, max_nodes = %zu, reuse = %d\n", cases[i].N, cases[i].max_nodes,
+                   cases[i].reuse);
+            TEST_FAIL("Wrong smallest net size");
+        }
+    }
+    
+    // 6 needs no pruning, so the batch finds 7's answer without it
+    const int Ns[] = { 6, 7 };
+    ic_batch_result_t results[2];
+    ic_enum_state_t state;
+    ic_enum_init(&state, 20);
+    ic_enum_set_slot_reuse(&state, true);
+    ic_search_factor_batch(&state, Ns, 2, 20, 1000, results);
+    if (state.indices_pruned != 0) TEST_FAIL("Batch with 6 should not prune");
+    
+    ic_enum_init(&state, 20);
+    ic_enum_set_slot_reuse(&state, true);
+    if (ic_search_factor(&state, 7, 20, 1000) != results[1].solution_index ||
+        results[1].solution_index < 0) {
+        TEST_FAIL("Pruning changed the solution for 7");
+    }
+    if (state.indices_pruned == 0) TEST_FAIL("Search for 7 should skip small nets");
+    
+    // A target no net can factor ends the search at once
+    ic_enum_init(&state, 20);
+    ic_enum_set_slot_reuse(&state, true);
+    if (ic_search_factor(&state, 17, 20, 1000) != -1) TEST_FAIL("17 cannot be factored");
+    if (state.indices_searched != 0 || state.indices_pruned != 0) {
+        TEST_FAIL("Search for 17 should not examine any index");
+    }
+    
+    // ... and does not keep a batch running once the others are solved
+    const int with_prime[] = { 6, 17 };
+    ic_enum_init(&state, 20);
+    ic_enum_set_slot_reuse(&state, true);
+    if (ic_search_factor_batch(&state, with_prime, 2, 20, 1000, results) != 1 ||
+        results[0].solution_index != 322 || results[1].solution_index != -1) {
+        TEST_FAIL("Batch with an unfactorable target failed");
+    }
+    if (state.current_index != 323) TEST_FAIL("Batch should stop after the last solution");
+    
+    TEST_PASS();
+}
+
+// Progress seen by test_search_progress
+static int progress_calls = 0;
+static int progress_found = 0;
+static bool progress_monotonic = true;
+static ic_search_progress_t progress_last;
+
+static void record_progress(size_t current_index, bool found_solution,
+                            const ic_search_progress_t *progress) {
+    (void)current_index;
+    if (progress_calls > 0 && progress->indices < progress_last.indices) {
+        progress_monotonic = false;
+    }
+    progress_last = *progress;
+    progress_calls++;
+    if (found_solution) progress_found++;
+}
+
+// Test thread placement plans and that pinned searches find the same solutions
+bool test_thread_placement() {
+    printf("Testing thread placement...\n");
+    
+    ic_topology_t topo;
+    ic_topology_detect(&topo);
+    if (topo.num_cpus < 1 || topo.num_nodes < 1 || topo.num_nodes > topo.num_cpus) {
+        TEST_FAIL("Detected topology is inconsistent");
+    }
+    for (int i = 1; i < topo.num_cpus; i++) {
+        if (topo.nodes[i] < topo.nodes[i - 1]) TEST_FAIL("CPUs should be grouped by node");
+    }
+    
+    // Two nodes of four CPUs: compact fills node 0, scatter alternates
+    ic_topology_t two;
+    two.num_cpus = 8;
+    two.num_nodes = 2;
+    for (int i = 0; i < 8; i++) {
+        two.cpus[i] = i;
+        two.nodes[i] = i / 4;
+    }
+    const int compact[] = { 0, 1, 2, 3, 4, 5, 6, 7, 0 };
+    const int scatter[] = { 0, 4, 1, 5, 2, 6, 3, 7, 0 };
+    for (int t = 0; t < 9; t++) {
+        if (ic_topology_slot_for_thread(&two, IC_PIN_COMPACT, t) != compact[t] ||
+            ic_topology_slot_for_thread(&two, IC_PIN_SCATTER, t) != scatter[t]) {
+            TEST_FAIL("Wrong thread placement");
+        }
+    }
+    if (ic_topology_slot_for_thread(&two, IC_PIN_NONE, 0) != -1) TEST_FAIL("Unpinned threads have no slot");
+    
+    ic_pin_mode_t mode;
+    if (ic_pin_mode_parse("scatter", &mode) != 0 || mode != IC_PIN_SCATTER ||
+        ic_pin_mode_parse("spread", &mode) == 0) {
+        TEST_FAIL("Pin modes should parse");
+    }
+    
+    // Faulting memory in leaves its contents alone
+    size_t bytes = 3 * IC_TOPOLOGY_HUGE_BYTES;
+    unsigned char *memory = (unsigned char*)malloc(bytes);
+    if (!memory) TEST_FAIL("Failed to allocate");
+    for (size_t i = 0; i < bytes; i += 977) memory[i] = (unsigned char)i;
+    ic_topology_place(memory, bytes, true);
+    for (size_t i = 0; i < bytes; i += 977) {
+        if (memory[i] != (unsigned char)i) TEST_FAIL("Placement changed memory");
+    }
+    free(memory);
+    
+    // Pinned, NUMA-local searches on a fixed thread count solve as before
+    const ic_pin_mode_t modes[] = { IC_PIN_COMPACT, IC_PIN_SCATTER };
+    for (int m = 0; m < 2; m++) {
+        ic_enum_state_t state;
+        ic_enum_init(&state, 100);
+        ic_enum_set_threads(&state, 2);
+        ic_enum_set_placement(&state, modes[m], m == 1);
+        int64_t solution = ic_search_factor(&state, 8, 100, 100000);
+        if (solution != 7607) TEST_FAIL("Pinned search found a different solution");
+        if (state.threads_used < 1 || state.threads_used > 2) TEST_FAIL("Search should use the requested threads");
+#ifdef __linux__
+        if (state.threads_pinned != state.threads_used) TEST_FAIL("Threads should be pinned");
+#endif
+    }
+    
+    // The masks are restored once the search ends
+    ic_topology_t after;
+    ic_topology_detect(&after);
+    if (after.num_cpus != topo.num_cpus) TEST_FAIL("Search left the thread pinned");
+    
+    TEST_PASS();
+}
+
+bool test_search_progress() {
+    printf("Testing aggregated search progress...\n");
+    
+    ic_enum_state_t state;
+    ic_enum_init(&state, 20);
+    ic_enum_set_progress_callback(&state, record_progress);
+    state.progress_interval_ms = 10;
+    
+    int64_t solution = ic_search_factor(&state, 8, 20, 1000);
+    
+    if (solution < 0) TEST_FAIL("Search should factor 8");
+    if (progress_calls == 0 || progress_found == 0) TEST_FAIL("Callback missed the solution");
+    if (!progress_monotonic) TEST_FAIL("Aggregated index count went backwards");
+    
+    // The last call carries the final totals of all threads
+    if (progress_last.indices != state.indices_searched ||
+        progress_last.deduplicated != state.indices_deduplicated ||
+        progress_last.rewrites != state.rewrites || state.rewrites == 0) {
+        printf("Final report: %" PRIu64 " indices, %" PRIu64 " rewrites; state: %zu, %" PRIu64 "\n",
+               progress_last.indices, progress_last.rewrites, state.indices_searched, state.rewrites);
+        TEST_FAIL("Final report does not match the search totals");
+    }
+    if (progress_last.threads < 1) TEST_FAIL("Report has no threads");
+    
+    TEST_PASS();
+}
+
+bool test_reduction_stats() {
+    printf("Testing reduction statistics...\n");
+    
+#ifdef IC_STATS
+    // δγ pair plus an ε-γ pair: two rules fire on the first rewrites
+    ic_net_t *net = ic_net_create(10, 3);
+    int d = ic_net_new_node(net, IC_NODE_DELTA);
+    int g = ic_net_new_node(net, IC_NODE_GAMMA);
+    int e = ic_net_new_node(net, IC_NODE_EPSILON);
+    int g2 = ic_net_new_node(net, IC_NODE_GAMMA);
+    ic_net_connect(net, d, 0, g, 0);
+    ic_net_connect(net, e, 0, g2, 0);
+    ic_net_reduce(net);
+    
+    ic_stats_t stats = net->stats;
+    ic_net_free(net);
+    
+    if (stats.delta_gamma == 0 || stats.epsilon != 1) TEST_FAIL("Rule counters are wrong");
+    if (stats.delta_delta + stats.gamma_gamma + stats.delta_gamma + stats.epsilon != 3) {
+        TEST_FAIL("Rule counters do not add up to the gas used");
+    }
+    
+    // Gas 3 falls in the [2, 3] bucket
+    if (stats.nets_reduced != 1 || stats.gas_histogram[2] != 1) TEST_FAIL("Gas histogram is wrong");
+    
+    // A search sums the counters of all its threads
+    ic_enum_state_t state;
+    ic_enum_init(&state, 20);
+    ic_search_factor(&state, 6, 20, 1000);
+    uint64_t reduced = state.indices_searched - state.indices_deduplicated;
+    if (state.stats.nets_reduced != reduced) {
+        printf("Stats saw %llu nets, search reduced %llu\n",
+               (unsigned long long)state.stats.nets_reduced, (unsigned long long)reduced);
+        TEST_FAIL("Search statistics miss some reductions");
+    }
+#else
+    printf("(IC_STATS is off; build with make STATS=1 to exercise the counters)\n");
+#endif
+    
+    TEST_PASS();
+}
+
+/**
+ * Count occurrences of a string in a buffer
+ */
+static size_t count_substrings(const char *text, const char *needle) {
+    size_t count = 0;
+    for (const char *at = strstr(text, needle); at; at = strstr(at + 1, needle)) count++;
+    return count;
+}
+
+// Test the Chrome trace converter and, in traced builds, the tracer itself
+bool test_rewrite_trace() {
+    printf("Testing rewrite tracing...\n");
+    
+    // A hand-written trace: one chunk holding one index with one rewrite
+    FILE *trace = tmpfile();
+    FILE *json = tmpfile();
+    if (!trace || !json) TEST_FAIL("Failed to create trace files");
+    ic_trace_header_t header = { IC_TRACE_MAGIC, IC_TRACE_VERSION, sizeof(ic_trace_event_t), 0 };
+    const ic_trace_event_t events[] = {
+        { 1000, 64, 8, 3, IC_TRACE_CHUNK_BEGIN, 0 },
+        { 2000, 70, 0, 3, IC_TRACE_INDEX_BEGIN, 0 },
+        { 2500, 0, 1, 3, IC_TRACE_REWRITE, IC_TRACE_DELTA_GAMMA },
+        { 3000, 70, 1, 3, IC_TRACE_INDEX_END, 0 },
+        { 4250, 64, 0, 3, IC_TRACE_CHUNK_END, 0 },
+    };
+    fwrite(&header, sizeof(header), 1, trace);
+    fwrite(events, sizeof(events[0]), 5, trace);
+    rewind(trace);
+    
+    int64_t converted = ic_trace_export_chrome(trace, json);
+    char text[4096];
+    rewind(json);
+    size_t length = fread(text, 1, sizeof(text) - 1, json);
+    text[length] = '\0';
+    if (converted != 5 || !strstr(text, "\"traceEvents\"") ||
+        count_substrings(text, "\"ph\":\"B\"") != 2 || count_substrings(text, "\"ph\":\"E\"") != 2 ||
+        !strstr(text, "\"name\":\"δγ\"") || !strstr(text, "\"ts\":4.250") ||
+        count_substrings(text, "\"thread_name\"") != 1) {
+        printf("%s", text);
+        TEST_FAIL("Chrome trace does not match the events");
+    }
+    
+    // Anything but a trace is refused
+    rewind(json);
+    if (ic_trace_export_chrome(json, trace) != -1) TEST_FAIL("Converter accepted a non-trace");
+    fclose(trace);
+    fclose(json);
+    
+#ifdef IC_TRACE
+    const char *path = "test_trace.ictr";
+    if (ic_trace_start(path) != 0) TEST_FAIL("Failed to start a trace");
+    if (ic_trace_start(path) != -1) TEST_FAIL("Two traces ran at once");
+    
+    // One reduction on this thread, then a search on three threads
+    ic_trace_attach();
+    ic_net_t *net = ic_net_create(20, 1000);
+    ic_enum_build_index(1, net);
+    ic_net_reduce(net);
+    size_t gas = net->gas_used;
+    ic_net_free(net);
+    
+    ic_enum_state_t state;
+    ic_enum_init(&state, 20);
+    ic_enum_set_threads(&state, 3);
+    int64_t solution = ic_search_factor(&state, 6, 20, 1000);
+    int64_t written = ic_trace_stop();
+    if (solution < 0 || written <= 0) {
+        remove(path);
+        TEST_FAIL("Traced search failed");
+    }
+    
+    // Every thread's events are in time order, with chunks and indices
+    // properly nested and each rewrite inside an index
+    FILE *in = fopen(path, "rb");
+    if (!in || fread(&header, sizeof(header), 1, in) != 1 || header.magic != IC_TRACE_MAGIC) {
+        if (in) fclose(in);
+        remove(path);
+        TEST_FAIL("Trace file has no header");
+    }
+    uint64_t last[8] = { 0 };
+    int chunks[8] = { 0 }, indices[8] = { 0 };
+    size_t read = 0, reductions = 0, chunk_count = 0, dropped = 0;
+    size_t solo_rewrites = 0, search_rewrites = 0;
+    bool searching[8] = { false };
+    bool ordered = true, nested = true;
+    ic_trace_event_t event;
+    while (fread(&event, sizeof(event), 1, in) == 1) {
+        read++;
+        unsigned t = event.thread;
+        if (t >= 8) {
+            nested = false;
+            break;
+        }
+        ordered = ordered && event.time_ns >= last[t];
+        last[t] = event.time_ns;
+        switch (event.kind) {
+            case IC_TRACE_CHUNK_BEGIN:
+                chunks[t]++;
+                chunk_count++;
+                searching[t] = true;
+                nested = nested && chunks[t] == 1;
+                break;
+            case IC_TRACE_CHUNK_END:
+                chunks[t]--;
+                nested = nested && chunks[t] == 0;
+                break;
+            case IC_TRACE_INDEX_BEGIN:
+                indices[t]++;
+                reductions++;
+                nested = nested && indices[t] == 1 && chunks[t] == 1;
+                break;
+            case IC_TRACE_INDEX_END:
+                indices[t]--;
+                nested = nested && indices[t] == 0;
+                break;
+            case IC_TRACE_REWRITE:
+                // Thread 0 reduced the lone net before any search chunk
+                if (t == 0 && !searching[t]) {
+                    solo_rewrites++;
+                } else {
+                    search_rewrites++;
+                }
+                break;
+            case IC_TRACE_DROPPED:
+                dropped += event.value;
+                break;
+            default:
+                break;
+        }
+    }
+    fclose(in);
+    remove(path);
+    
+    if (read != (size_t)written || !ordered || !nested || dropped != 0) {
+        TEST_FAIL("Trace events are out of order or unbalanced");
+    }
+    
+    // The lone reduction traced exactly its own rewrites, the search at
+    // least the ones it counted
+    if (solo_rewrites != gas || chunk_count == 0 ||
+        reductions != state.indices_searched - state.indices_deduplicated ||
+        search_rewrites < state.rewrites) {
+        printf("Trace: %zu reductions, %zu rewrites; search: %zu indices, %" PRIu64 " rewrites\n",
+               reductions, search_rewrites, state.indices_searched - state.indices_deduplicated,
+               state.rewrites);
+        TEST_FAIL("Trace misses reductions or rewrites");
+    }
+#else
+    if (ic_trace_start("test_trace.ictr") != -1) TEST_FAIL("Tracing started without IC_TRACE");
+    printf("(IC_TRACE is off; build with make TRACE=1 to exercise the tracer)\n");
+#endif
+    
+    TEST_PASS();
+}
+
+typedef struct {
+    ic_service_t *service;
+    int fd;
+    int result;
+} service_test_run_t;
+
+static void *service_test_run(void *arg) {
+    service_test_run_t *run = (service_test_run_t*)arg;
+    run->result = ic_service_run(run->service, run->fd);
+    return NULL;
+}
+
+static int service_test_connect(const char *path) {
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, path, sizeof(addr.sun_path) - 1);
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd >= 0 && connect(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0) {
+        close(fd);
+        fd = -1;
+    }
+    return fd;
+}
+
+/**
+ * Read reply lines from a service socket until `lines` have arrived
+ */
+static bool service_test_read(int fd, char *buffer, size_t size, int lines) {
+    size_t used = 0;
+    int seen = 0;
+    while (seen < lines && used < size - 1) {
+        ssize_t got = read(fd, buffer + used, size - 1 - used);
+        if (got <= 0) return false;
+        for (ssize_t i = 0; i < got; i++) seen += buffer[used + i] == '\n';
+        used += (size_t)got;
+    }
+    buffer[used] = '\0';
+    return seen == lines;
+}
+
+bool test_search_service() {
+    printf("Testing the search service and its result cache...\n");
+    
+    // The cache keeps the most recently used entries and forgets the rest
+    ic_service_cache_t cache;
+    if (ic_service_cache_init(&cache, 3) != 0) TEST_FAIL("Failed to create cache");
+    for (int N = 2; N < 7; N++) {
+        ic_service_key_t key = { N, 20, 1000 };
+        ic_batch_result_t result = { N * 10, N, 1 };
+        ic_service_cache_insert(&cache, &key, &result);
+        if (N == 4) {
+            ic_service_key_t first = { 2, 20, 1000 };
+            ic_service_cache_lookup(&cache, &first, NULL);
+        }
+    }
+    ic_batch_result_t got;
+    ic_service_key_t kept = { 2, 20, 1000 }, evicted = { 3, 20, 1000 }, other = { 2, 21, 1000 };
+    if (!ic_service_cache_lookup(&cache, &kept, &got) || got.solution_index != 20 ||
+        ic_service_cache_lookup(&cache, &evicted, &got) ||
+        ic_service_cache_lookup(&cache, &other, &got) ||
+        cache.count != 3 || cache.evictions != 2) {
+        TEST_FAIL("Cache kept the wrong entries");
+    }
+    ic_service_cache_destroy(&cache);
+    
+    // Requests are answered as the search answers them, from the cache
+    // when repeated, with the nets kept warm in between
+    ic_enum_state_t base;
+    ic_enum_init(&base, 20);
+    ic_enum_set_search_limit(&base, 1u << 16);
+    ic_service_t service;
+    if (ic_service_init(&service, &base, 16) != 0) TEST_FAIL("Failed to create service");
+    
+    FILE *out = tmpfile();
+    if (!out) TEST_FAIL("Failed to create reply file");
+    const char *requests[] = {
+        "factor 8 20 2000", "factor 8 20 2000", "batch 20 2000 6 8 9 6", "factor 8 20 500",
+        "factor 1", "batch 20", "frobnicate", "stats", "quit",
+    };
+    int statuses[9];
+    for (int r = 0; r < 9; r++) statuses[r] = ic_service_handle(&service, requests[r], out);
+    
+    int64_t expected[4];
+    const int Ns[] = { 6, 8, 9 };
+    for (int t = 0; t < 3; t++) {
+        ic_enum_state_t state;
+        ic_enum_init(&state, 20);
+        ic_enum_set_search_limit(&state, 1u << 16);
+        expected[t] = ic_search_factor(&state, Ns[t], 20, 2000);
+    }
+    ic_enum_state_t state;
+    ic_enum_init(&state, 20);
+    ic_enum_set_search_limit(&state, 1u << 16);
+    expected[3] = ic_search_factor(&state, 8, 20, 500);
+    
+    rewind(out);
+    char expect[9][128];
+    snprintf(expect[0], 128, "8 %" PRId64 " 1 8 searched", expected[1]);
+    snprintf(expect[1], 128, "8 %" PRId64 " 1 8 cached", expected[1]);
+    snprintf(expect[2], 128, "6 %" PRId64 " 3 2 searched", expected[0]);
+    snprintf(expect[3], 128, "8 %" PRId64 " 1 8 cached", expected[1]);
+    snprintf(expect[4], 128, "9 %" PRId64 " 1 9 searched", expected[2]);
+    snprintf(expect[5], 128, "6 %" PRId64 " 3 2 searched", expected[0]);
+    snprintf(expect[6], 128, "8 %" PRId64 " 1 8 searched", expected[3]);
+    snprintf(expect[7], 128, "error");
+    snprintf(expect[8], 128, "error");
+    char line[512];
+    for (int l = 0; l < 9; l++) {
+        if (!fgets(line, sizeof(line), out) || strncmp(line, expect[l], strlen(expect[l])) != 0) {
+            printf("Reply %d: %s (expected %s)\n", l, line, expect[l]);
+            TEST_FAIL("Service reply differs from ic_search_factor");
+        }
+    }
+    if (!fgets(line, sizeof(line), out) || strncmp(line, "error", 5) != 0 ||
+        !fgets(line, sizeof(line), out) || strncmp(line, "requests 8 searches 3 ", 22) != 0) {
+        TEST_FAIL("Service stats are wrong");
+    }
+    fclose(out);
+    
+    // Settings past the bounds are refused, not searched and cached as "not found"
+    out = tmpfile();
+    if (!out) TEST_FAIL("Failed to create reply file");
+    size_t entries = service.cache.count;
+    ic_service_handle(&service, "factor 6 100000000000000 100", out);
+    ic_service_handle(&service, "batch 20 100000000000 6", out);
+    rewind(out);
+    for (int l = 0; l < 2; l++) {
+        if (!fgets(line, sizeof(line), out) || strncmp(line, "error", 5) != 0) {
+            TEST_FAIL("Service searched past its bounds");
+        }
+    }
+    fclose(out);
+    if (service.searches != 3 || service.cache.count != entries) {
+        TEST_FAIL("Refused request reached the search or the cache");
+    }
+    
+    // Over a socket, a client's replies keep their order while another
+    // client is answered, and a shutdown request ends the run
+    char address[64];
+    snprintf(address, sizeof(address), "unix:/tmp/ic_service_test_%d.sock", (int)getpid());
+    service_test_run_t run = { &service, ic_service_listen(address), -1 };
+    pthread_t runner;
+    if (run.fd < 0 || pthread_create(&runner, NULL, service_test_run, &run) != 0) {
+        if (run.fd >= 0) close(run.fd);
+        TEST_FAIL("Failed to start the service");
+    }
+    int first = service_test_connect(address + 5), second = service_test_connect(address + 5);
+    const char *searches = "factor 9 20 1000\nfactor 9 20 1000\n", *others = "factor 8 20 0\nstats\n";
+    char replies[1024], expect_first[128];
+    bool served = first >= 0 && second >= 0 &&
+        write(first, searches, strlen(searches)) == (ssize_t)strlen(searches) &&
+        write(second, others, strlen(others)) == (ssize_t)strlen(others) &&
+        service_test_read(second, replies, sizeof(replies), 2) &&
+        strncmp(replies, "error", 5) == 0 && strstr(replies, "\nrequests ") != NULL;
+    
+    ic_enum_init(&state, 20);
+    ic_enum_set_search_limit(&state, 1u << 16);
+    int64_t nine = ic_search_factor(&state, 9, 20, 1000);
+    snprintf(expect_first, sizeof(expect_first), "9 %" PRId64 " 1 9 searched\n9 %" PRId64 " 1 9 cached\n",
+             nine, nine);
+    served = served && service_test_read(first, replies, sizeof(replies), 2) &&
+        strcmp(replies, expect_first) == 0;
+    served = served && write(second, "shutdown\n", 9) == 9 &&
+        service_test_read(second, replies, sizeof(replies), 1) && strcmp(replies, "bye\n") == 0;
+    if (!served) {
+        printf("Replies: %s", replies);
+        int stopper = service_test_connect(address + 5);
+        if (stopper >= 0 && write(stopper, "shutdown\n", 9) == 9) service_test_read(stopper, replies, sizeof(replies), 1);
+        if (stopper >= 0) close(stopper);
+    }
+    pthread_join(runner, NULL);
+    if (first >= 0) close(first);
+    if (second >= 0) close(second);
+    close(run.fd);
+    unlink(address + 5);
+    if (!served || run.result != 0) TEST_FAIL("Service run answered its clients wrongly");
+    
+    if (statuses[0] != IC_SERVICE_CONTINUE || statuses[8] != IC_SERVICE_CLOSE ||
+        ic_service_handle(&service, "shutdown", stdout) != IC_SERVICE_SHUTDOWN) {
+        TEST_FAIL("Service ended a connection at the wrong request");
+    }
+    if (service.pool.nets_created == 0 || service.pool.nets_reused < 2) {
+        TEST_FAIL("Service searches did not reuse their nets");
+    }
+    ic_service_destroy(&service);
+    
+    if (ic_service_listen("udp:7") != -1 || ic_service_listen("tcp:") != -1 ||
+        ic_service_listen("unix:") != -1) {
+        TEST_FAIL("Service listened on a bad address");
+    }
+    
+    TEST_PASS();
+}
+
 int main() {
     printf("=== Interaction Combinators Test Suite ===\n\n");
     
@@ -514,12 +2606,37 @@ int main() {
     passed += test_delta_delta_reduction();
     passed += test_gamma_gamma_reduction();
     passed += test_delta_gamma_reduction();
+    passed += test_created_redex_reduction();
+    passed += test_redex_queue_growth();
     passed += test_epsilon_reduction();
     passed += test_gas_limit();
     passed += test_factorization();
     passed += test_enumeration();
-    
-    total = 9; // Update for the actual number of tests
+    passed += test_enum_cursor();
+    passed += test_search_net_reuse();
+    passed += test_search_dedup();
+    passed += test_search_batch();
+    passed += test_solution_indices();
+    passed += test_outcome_table();
+    passed += test_net_serialization();
+    passed += test_all_solutions();
+    passed += test_search_checkpoint();
+    passed += test_sharded_search();
+    passed += test_search_ordered_exit();
+    passed += test_fixed_reducers();
+    passed += test_parallel_reduction();
+    passed += test_compaction();
+    passed += test_loop_detection();
+    passed += test_levin_search();
+    passed += test_goal_pruning();
+    passed += test_divisor_pruning();
+    passed += test_thread_placement();
+    passed += test_search_progress();
+    passed += test_reduction_stats();
+    passed += test_rewrite_trace();
+    passed += test_search_service();
+    
+    total = 34; // Update for the actual number of tests
     
     printf("\n=== Test Results ===\n");
     printf("Passed: %d/%d tests\n", passed, total);